@@ -106,6 +106,55 @@ def load_json_list(fname):
         print(f"[Warning] Could not load {fname} from {path}: {e}")
         return []
     
+# Characters that turn '?' into a character class in patterns (see the C++ pattern syntax)
+MASK_CLASS_CHARS = "ludsa1234"
+
+# Group brackets in patterns and their closing counterparts
+GROUP_CLOSERS = {'[': ']', '{': '}', '(': ')'}
+
+def _find_closing(pattern, start, closer):
+    """Index of `closer` after `start` (skipping escaped characters), or -1."""
+    i = start + 1
+    while i < len(pattern):
+        if pattern[i] == '\\':
+            i += 1
+        elif pattern[i] == closer:
+            return i
+        i += 1
+    return -1
+
+def _find_group_closing(pattern, start, closer):
+    """Like _find_closing, but -1 unless the body holds an unescaped '|' ("pw(1)" stays literal)."""
+    close = _find_closing(pattern, start, closer)
+    i = start + 1
+    while 0 <= i < close:
+        if pattern[i] == '\\':
+            i += 1
+        elif pattern[i] == '|':
+            return close
+        i += 1
+    return -1
+
+def _group_closing(pattern, start):
+    """Closing index of the [...] class or {...|...} / (...|...) group opened at `start`, or -1."""
+    if pattern[start] == '[':
+        return _find_closing(pattern, start, ']')
+    return _find_group_closing(pattern, start, GROUP_CLOSERS[pattern[start]])
+
+def _shortest_alternative(body):
+    """Length of the shortest '|'-separated alternative in a group body (escapes count once)."""
+    lengths = [0]
+    i = 0
+    while i < len(body):
+        if body[i] == '|':
+            lengths.append(0)
+        else:
+            if body[i] == '\\':
+                i += 1
+            lengths[-1] += 1
+        i += 1
+    return min(lengths)
+
 def parse_pattern(pattern):
     """Parse the pattern into segments, handling escape characters."""
     segments = []
@@ -120,11 +169,27 @@ def parse_pattern(pattern):
                 i += 1
             else:
                 literal += c
+        elif c in GROUP_CLOSERS and _group_closing(pattern, i) != -1:
+            # [a-z] is one position; {a|bc} / (a|bc) count with their shortest alternative
+            close = _group_closing(pattern, i)
+            if literal:
+                segments.append(literal)
+                literal = ""
+            if c == '[':
+                segments.append('?')
+            else:
+                shortest = _shortest_alternative(pattern[i + 1:close])
+                if shortest:
+                    segments.append('x' * shortest)
+            i = close
         elif c in ['?', '*']:
             if literal:
                 segments.append(literal)
                 literal = ""
             segments.append(c)
+            # ?l ?u ?d ?s ?a and ?1-?4 are one position, like a plain '?'
+            if c == '?' and i + 1 < len(pattern) and pattern[i + 1] in MASK_CLASS_CHARS:
+                i += 1
         else:
             literal += c
         i += 1
@@ -801,6 +866,9 @@ class ArchivePasswordCrackerApp(ctk.CTk):
                                        "Previously tried passwords for the next run will NOT be skipped.\n"
                                        "Are you sure?", icon='warning'):
                     os.remove(SKIP_LIST_PATH)
+                    # The run state (tested positions of any mode, shard and range) belongs to the skip list; drop it as well
+                    if os.path.isfile(SKIP_LIST_PATH + ".state"):
+                        os.remove(SKIP_LIST_PATH + ".state")
                     self.update_status(f"Skip list file '{SKIP_LIST_FILENAME}' removed.")
                     messagebox.showinfo("Cleared", f"Skip list file '{SKIP_LIST_FILENAME}' removed successfully.")
             except OSError as e:
@@ -73,12 +73,12 @@ if errorlevel 1 (
 echo Compiling C++ source...
 REM Add -static flags to try and link runtime statically, reducing DLL dependencies
 REM --- UPDATED: Added bloom_filter.cpp and use COMPILER_EXE variable ---
-"%MINGW_BIN%\%COMPILER_EXE%" "%SRC_DIR%\main.cpp" "%SRC_DIR%\brute_force.cpp" "%SRC_DIR%\bloom_filter.cpp" ^
+"%MINGW_BIN%\%COMPILER_EXE%" "%SRC_DIR%\main.cpp" "%SRC_DIR%\brute_force.cpp" "%SRC_DIR%\bloom_filter.cpp" "%SRC_DIR%\candidate_generator.cpp" "%SRC_DIR%\candidate_batch.cpp" "%SRC_DIR%\feistel_permutation.cpp" "%SRC_DIR%\run_state.cpp" "%SRC_DIR%\pattern_automaton.cpp" "%SRC_DIR%\pattern_plan.cpp" "%SRC_DIR%\pattern_syntax.cpp" "%SRC_DIR%\password_constraints.cpp" "%SRC_DIR%\wordlist.cpp" "%SRC_DIR%\compiled_wordlist.cpp" "%SRC_DIR%\rule_engine.cpp" "%SRC_DIR%\combinator.cpp" "%SRC_DIR%\markov_model.cpp" "%SRC_DIR%\pcfg.cpp" "%SRC_DIR%\typo_neighborhood.cpp" "%SRC_DIR%\common_passwords.cpp" "%SRC_DIR%\archive_tokens.cpp" "%SRC_DIR%\tcp_socket.cpp" "%SRC_DIR%\coordinator.cpp" "%SRC_DIR%\worker_pool.cpp" ^
     -o "%RELEASE_DIR%\%OUT_EXE%" ^
     -I"%SRC_DIR%" ^
     -I"%INCLUDE_DIR%" -L"%LIB_DIR%" ^
     -std=c++17 -pthread -O3 -Wall -Wextra ^
-    -lshlwapi -static-libgcc -static-libstdc++ -static -lpthread
+    -lshlwapi -lws2_32 -static-libgcc -static-libstdc++ -static -lpthread
 
 if errorlevel 1 (
     echo.
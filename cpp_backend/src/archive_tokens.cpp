@@ -0,0 +1,425 @@
+#include "archive_tokens.h"
+#include <algorithm>     // For std::stable_sort, std::min
+#include <cctype>        // For std::isalnum, std::isdigit, std::tolower, std::toupper
+#include <map>           // For std::map (date and year counts)
+#include <unordered_map> // For std::unordered_map (token counts)
+#include <unordered_set> // For std::unordered_set (guess deduplication)
+
+#ifdef _WIN32
+#include <windows.h>  // For CreatePipe, CreateProcessW, ReadFile
+#else
+#include <sys/wait.h> // For waitpid
+#include <unistd.h>   // For pipe, fork, execvp, read, dup2, close
+#include <fcntl.h>    // For open flags (O_RDONLY, O_WRONLY)
+#endif
+
+// --- Runs `7z l -slt <archive>` and returns its standard output ---
+// Standard input is closed, so an archive with encrypted headers fails instead of prompting.
+static bool run_listing(const std::string &seven_zip_path, const std::string &archive_path, std::string &output, std::string &error)
+{
+    output.clear();
+#ifdef _WIN32
+    auto widen = [](const std::string &utf8) -> std::wstring
+    {
+        int len = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, NULL, 0);
+        if (len <= 0)
+            return L"";
+        std::vector<wchar_t> buf(len);
+        MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, buf.data(), len);
+        return buf.data();
+    };
+    std::wstring command = L"\"" + widen(seven_zip_path) + L"\" l -slt \"" + widen(archive_path) + L"\"";
+    std::vector<wchar_t> command_buf(command.begin(), command.end());
+    command_buf.push_back(0);
+
+    SECURITY_ATTRIBUTES sa;
+    ZeroMemory(&sa, sizeof(sa));
+    sa.nLength = sizeof(sa);
+    sa.bInheritHandle = TRUE;
+    HANDLE read_end = NULL, write_end = NULL;
+    if (!CreatePipe(&read_end, &write_end, &sa, 0))
+    {
+        error = "CreatePipe failed: " + std::to_string(GetLastError());
+        return false;
+    }
+    SetHandleInformation(read_end, HANDLE_FLAG_INHERIT, 0);
+    STARTUPINFOW si;
+    PROCESS_INFORMATION pi;
+    ZeroMemory(&si, sizeof(si));
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+    si.wShowWindow = SW_HIDE;
+    si.hStdOutput = write_end;
+    ZeroMemory(&pi, sizeof(pi));
+    BOOL started = CreateProcessW(nullptr, command_buf.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi);
+    CloseHandle(write_end);
+    if (!started)
+    {
+        CloseHandle(read_end);
+        error = "Could not run 7z to list the archive: " + std::to_string(GetLastError());
+        return false;
+    }
+    char buffer[4096];
+    DWORD got = 0;
+    while (ReadFile(read_end, buffer, sizeof(buffer), &got, nullptr) && got > 0)
+        output.append(buffer, got);
+    CloseHandle(read_end);
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+#else
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        error = "pipe() failed while listing the archive.";
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        error = "fork() failed while listing the archive.";
+        return false;
+    }
+    if (pid == 0)
+    {
+        const char *argv[] = {seven_zip_path.c_str(), "l", "-slt", archive_path.c_str(), nullptr};
+        dup2(fds[1], STDOUT_FILENO);
+        int devNull = open("/dev/null", O_RDWR);
+        if (devNull != -1)
+        {
+            dup2(devNull, STDIN_FILENO);
+            dup2(devNull, STDERR_FILENO);
+            close(devNull);
+        }
+        close(fds[0]);
+        close(fds[1]);
+        execvp(seven_zip_path.c_str(), const_cast<char *const *>(argv));
+        _exit(127);
+    }
+    close(fds[1]);
+    char buffer[4096];
+    ssize_t got;
+    while ((got = read(fds[0], buffer, sizeof(buffer))) > 0)
+        output.append(buffer, static_cast<size_t>(got));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+#endif
+    return true;
+}
+
+void parse_archive_listing(const std::string &listing, ArchiveMetadata &out)
+{
+    size_t begin = 0;
+    std::string last_key;
+    while (begin < listing.size())
+    {
+        size_t end = listing.find('\n', begin);
+        if (end == std::string::npos)
+            end = listing.size();
+        std::string line = listing.substr(begin, end - begin);
+        begin = end + 1;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        const size_t separator = line.find(" = ");
+        if (separator == std::string::npos)
+        {
+            // Continuation of a multi-line comment, or a banner / blank line ending it
+            if (last_key == "Comment" && !line.empty() && !out.comments.empty())
+                out.comments.back() += "\n" + line;
+            else
+                last_key.clear();
+            continue;
+        }
+        last_key = line.substr(0, separator);
+        const std::string value = line.substr(separator + 3);
+        if (last_key == "Path" && !value.empty())
+            out.paths.push_back(value);
+        else if (last_key == "Comment")
+            out.comments.push_back(value);
+        else if ((last_key == "Modified" || last_key == "Created" || last_key == "Accessed") && value.size() >= 10)
+            out.timestamps.push_back(value.substr(0, 19));
+    }
+}
+
+bool read_archive_metadata(const std::string &seven_zip_path, const std::string &archive_path, ArchiveMetadata &out,
+                           std::string &error)
+{
+    out = ArchiveMetadata();
+    out.paths.push_back(archive_path);
+    std::string listing;
+    if (!run_listing(seven_zip_path, archive_path, listing, error))
+        return false;
+    ArchiveMetadata listed;
+    parse_archive_listing(listing, listed);
+    if (listed.paths.empty())
+    {
+        error = "7z listed no entries (encrypted headers or unsupported archive); using the archive name only.";
+        return false;
+    }
+    // The first Path is the archive itself (already recorded)
+    out.paths.insert(out.paths.end(), listed.paths.begin() + 1, listed.paths.end());
+    out.comments = std::move(listed.comments);
+    out.timestamps = std::move(listed.timestamps);
+    return true;
+}
+
+// --- Token helpers ---
+
+static bool is_alnum(char c) { return std::isalnum(static_cast<unsigned char>(c)) != 0; }
+static bool is_digit(char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }
+static bool is_upper(char c) { return c >= 'A' && c <= 'Z'; }
+static bool is_lower(char c) { return c >= 'a' && c <= 'z'; }
+
+static std::string lower(std::string s)
+{
+    for (auto &c : s)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+static std::string upper(std::string s)
+{
+    for (auto &c : s)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return s;
+}
+
+static std::string capitalized(const std::string &s)
+{
+    std::string out = lower(s);
+    if (!out.empty())
+        out[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(out[0])));
+    return out;
+}
+
+// Path components; the extension of the last one (the file name) is dropped
+static std::vector<std::string> path_stems(const std::string &path)
+{
+    std::vector<std::string> parts;
+    std::string current;
+    for (char c : path)
+    {
+        if (c == '/' || c == '\\' || c == ':')
+        {
+            if (!current.empty())
+                parts.push_back(current);
+            current.clear();
+        }
+        else
+        {
+            current += c;
+        }
+    }
+    const size_t dot = current.rfind('.');
+    if (dot != std::string::npos && dot > 0)
+        current.erase(dot);
+    if (!current.empty())
+        parts.push_back(current);
+    return parts;
+}
+
+// Alphanumeric runs, also split at letter/digit and camelCase boundaries ("ProjectX2021" ->
+// "ProjectX2021", "Project", "X", "2021"). Only pieces of at least three characters are kept.
+static void split_words(const std::string &text, std::vector<std::string> &out)
+{
+    size_t i = 0;
+    while (i < text.size())
+    {
+        if (!is_alnum(text[i]))
+        {
+            ++i;
+            continue;
+        }
+        size_t run_end = i;
+        while (run_end < text.size() && is_alnum(text[run_end]))
+            ++run_end;
+        const std::string run = text.substr(i, run_end - i);
+        std::vector<std::string> pieces;
+        size_t piece = 0;
+        for (size_t k = 1; k <= run.size(); ++k)
+        {
+            const bool boundary = k == run.size() || is_digit(run[k]) != is_digit(run[k - 1]) ||
+                                  (is_upper(run[k]) && is_lower(run[k - 1]));
+            if (boundary)
+            {
+                pieces.push_back(run.substr(piece, k - piece));
+                piece = k;
+            }
+        }
+        if (run.size() >= 3)
+            out.push_back(run);
+        if (pieces.size() > 1)
+            for (const auto &p : pieces)
+                if (p.size() >= 3)
+                    out.push_back(p);
+        i = run_end;
+    }
+}
+
+std::vector<std::string> archive_token_guesses(const ArchiveMetadata &metadata, size_t max_guesses)
+{
+    std::vector<std::string> guesses;
+    std::unordered_set<std::string> seen;
+    auto add = [&](const std::string &guess)
+    {
+        if (!guess.empty() && guesses.size() < max_guesses && seen.insert(guess).second)
+            guesses.push_back(guess);
+    };
+
+    // Word tokens: the archive's own name first, then by how often they occur
+    struct TokenInfo {
+        std::string text; // First spelling seen
+        size_t count;
+        size_t first;
+        bool own_name;
+    };
+    std::vector<TokenInfo> tokens;
+    std::unordered_map<std::string, size_t> token_index;
+    std::vector<std::string> stems, words;
+    auto note_words = [&](const std::vector<std::string> &found, bool own_name)
+    {
+        for (const auto &word : found)
+        {
+            const std::string key = lower(word);
+            auto it = token_index.find(key);
+            if (it == token_index.end())
+            {
+                token_index.emplace(key, tokens.size());
+                tokens.push_back(TokenInfo{word, 1, tokens.size(), own_name});
+            }
+            else
+            {
+                ++tokens[it->second].count;
+            }
+        }
+    };
+    for (size_t p = 0; p < metadata.paths.size(); ++p)
+    {
+        std::vector<std::string> parts = path_stems(metadata.paths[p]);
+        if (p == 0 && parts.size() > 1)
+            parts.erase(parts.begin(), parts.end() - 1); // The archive's file name, not the directories it sits in
+        for (const auto &stem : parts)
+        {
+            stems.push_back(stem);
+            words.clear();
+            split_words(stem, words);
+            note_words(words, p == 0);
+        }
+    }
+    for (const auto &comment : metadata.comments)
+    {
+        words.clear();
+        split_words(comment, words);
+        note_words(words, false);
+    }
+    std::stable_sort(tokens.begin(), tokens.end(), [](const TokenInfo &a, const TokenInfo &b)
+                     { return a.own_name != b.own_name ? a.own_name : a.count > b.count; });
+
+    // Dates and years, most frequent first
+    std::map<std::string, size_t> date_counts, year_counts;
+    for (const auto &stamp : metadata.timestamps)
+    {
+        if (stamp.size() < 10 || !is_digit(stamp[0]) || stamp[4] != '-' || stamp[7] != '-')
+            continue;
+        ++date_counts[stamp.substr(0, 4) + stamp.substr(5, 2) + stamp.substr(8, 2)];
+    }
+    for (const auto &token : tokens)
+    {
+        const std::string &t = token.text;
+        if (t.size() == 4 && (t.compare(0, 2, "19") == 0 || t.compare(0, 2, "20") == 0) && is_digit(t[2]) && is_digit(t[3]))
+            year_counts[t] += token.count;
+    }
+    for (const auto &date : date_counts)
+        year_counts[date.first.substr(0, 4)] += date.second;
+    auto by_count = [](const std::map<std::string, size_t> &counts)
+    {
+        std::vector<std::pair<std::string, size_t>> sorted(counts.begin(), counts.end());
+        std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+        std::vector<std::string> out;
+        for (const auto &entry : sorted)
+            out.push_back(entry.first);
+        return out;
+    };
+    const std::vector<std::string> dates = by_count(date_counts); // YYYYMMDD
+    const std::vector<std::string> years = by_count(year_counts);
+
+    // 1. Whole names and comments as they are
+    for (const auto &stem : stems)
+        add(stem);
+    for (const auto &comment : metadata.comments)
+    {
+        // Each line of a multi-line comment on its own
+        size_t line_begin = 0;
+        while (line_begin <= comment.size())
+        {
+            size_t line_end = comment.find('\n', line_begin);
+            if (line_end == std::string::npos)
+                line_end = comment.size();
+            if (line_end - line_begin <= 64)
+                add(comment.substr(line_begin, line_end - line_begin));
+            line_begin = line_end + 1;
+        }
+    }
+
+    // 2. Word tokens in the usual capitalisations
+    for (const auto &token : tokens)
+    {
+        add(token.text);
+        add(lower(token.text));
+        add(capitalized(token.text));
+        add(upper(token.text));
+    }
+
+    // 3. Years and dates on their own
+    for (const auto &year : years)
+    {
+        add(year);
+        add(year.substr(2));
+    }
+    for (const auto &date : dates)
+    {
+        const std::string yyyy = date.substr(0, 4), mm = date.substr(4, 2), dd = date.substr(6, 2);
+        add(date);
+        add(dd + mm + yyyy);
+        add(mm + dd + yyyy);
+        add(dd + mm + yyyy.substr(2));
+    }
+
+    // 4. Tokens with a year or a common suffix
+    std::vector<std::string> suffixes;
+    for (const auto &year : years)
+    {
+        suffixes.push_back(year);
+        suffixes.push_back(year.substr(2));
+    }
+    for (const char *common : {"1", "123", "!", "12", "2", "01", "1!"})
+        suffixes.push_back(common);
+    for (const auto &suffix : suffixes)
+    {
+        for (const auto &token : tokens)
+        {
+            if (is_digit(token.text[0]) && is_digit(suffix[0]))
+                continue; // Number + number is covered by the dates above
+            add(lower(token.text) + suffix);
+            add(capitalized(token.text) + suffix);
+        }
+    }
+
+    // 5. Pairs of the leading tokens ("projectalpha", "ProjectAlpha")
+    const size_t pair_tokens = std::min<size_t>(tokens.size(), 16);
+    for (size_t a = 0; a < pair_tokens; ++a)
+    {
+        for (size_t b = 0; b < pair_tokens; ++b)
+        {
+            if (a == b)
+                continue;
+            add(lower(tokens[a].text) + lower(tokens[b].text));
+            add(capitalized(tokens[a].text) + capitalized(tokens[b].text));
+        }
+    }
+    return guesses;
+}
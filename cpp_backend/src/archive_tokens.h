@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef> // For size_t
+
+// What an archive tells about itself without the password: entry paths (unless the headers are
+// encrypted), the archive comment and entry timestamps. Read from `7z l -slt`.
+struct ArchiveMetadata {
+    std::vector<std::string> paths;      // Archive path first, then entry paths
+    std::vector<std::string> comments;
+    std::vector<std::string> timestamps; // "YYYY-MM-DD hh:mm:ss" as printed by 7-Zip
+};
+
+// Guesses built from the metadata are capped at this many
+constexpr size_t kMaxArchiveTokenGuesses = 20000;
+
+// Lists `archive_path` with `seven_zip_path l -slt` and parses the output. The archive path is
+// always recorded, so encrypted headers still yield its file name. Returns false and sets `error`
+// if 7-Zip could not be run or listed nothing (`out` then holds just the archive path).
+bool read_archive_metadata(const std::string& seven_zip_path, const std::string& archive_path, ArchiveMetadata& out,
+                           std::string& error);
+
+// Parses `7z l -slt` output ("Key = Value" lines; multi-line comments continue without a key)
+void parse_archive_listing(const std::string& listing, ArchiveMetadata& out);
+
+// Targeted guesses, likeliest first: whole file stems and the comment, then word tokens in
+// lower/Capitalized/UPPER case, dates (YYYY, YY, YYYYMMDD, DDMMYYYY, MMDDYYYY, DDMMYY), tokens with
+// year and common numeric suffixes, and pairs of tokens. Duplicates are removed; at most `max_guesses`.
+std::vector<std::string> archive_token_guesses(const ArchiveMetadata& metadata, size_t max_guesses = kMaxArchiveTokenGuesses);
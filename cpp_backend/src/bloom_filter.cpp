@@ -1,4 +1,6 @@
 #include "bloom_filter.h"
+#include "candidate_batch.h"
+#include <algorithm> // For std::min
 #include <iostream> // For error messages during serialization/deserialization
 
 // Magic number and version for file format
@@ -48,37 +50,58 @@ BloomFilter::BloomFilter(uint64_t estimated_items, double false_positive_rate)
     }
 }
 
-void BloomFilter::generate_hashes(const std::string& item, std::vector<uint64_t>& hashes) const {
-    hashes.resize(m_num_hashes);
+void BloomFilter::base_hashes(std::string_view item, uint64_t& h1, uint64_t& h2) {
     // Use double hashing technique: H(i) = (h1(item) + i * h2(item)) mod m
-    uint64_t h1 = fnv1a_hash(item.c_str(), item.length());
+    h1 = fnv1a_hash(item.data(), static_cast<int>(item.length()));
     // Use a different seed/basis for the second hash
-    uint64_t h2 = fnv1a_hash(&h1, sizeof(h1)); // Hash the first hash for simplicity
+    h2 = fnv1a_hash(&h1, sizeof(h1)); // Hash the first hash for simplicity
+}
 
+bool BloomFilter::probe(uint64_t h1, uint64_t h2) const {
     for (uint32_t i = 0; i < m_num_hashes; ++i) {
-        hashes[i] = (h1 + i * h2) % m_num_bits;
+        if (!m_bits[(h1 + i * h2) % m_num_bits]) {
+            return false; // Definitely not present
+        }
     }
+    return true; // Probably present (or false positive)
 }
 
-void BloomFilter::insert(const std::string& item) {
+void BloomFilter::insert(std::string_view item) {
     if (!isValid()) return; // Don't operate on an invalid filter
-    std::vector<uint64_t> hashes;
-    generate_hashes(item, hashes);
-    for (uint64_t hash_index : hashes) {
-        m_bits[hash_index] = true;
+    uint64_t h1, h2;
+    base_hashes(item, h1, h2);
+    for (uint32_t i = 0; i < m_num_hashes; ++i) {
+        m_bits[(h1 + i * h2) % m_num_bits] = true;
     }
 }
 
-bool BloomFilter::contains(const std::string& item) const {
+bool BloomFilter::contains(std::string_view item) const {
     if (!isValid()) return false; // Treat invalid filter as containing nothing
-    std::vector<uint64_t> hashes;
-    generate_hashes(item, hashes);
-    for (uint64_t hash_index : hashes) {
-        if (!m_bits[hash_index]) {
-            return false; // Definitely not present
-        }
+    uint64_t h1, h2;
+    base_hashes(item, h1, h2);
+    return probe(h1, h2);
+}
+
+void BloomFilter::containsBatch(const CandidateBatch& batch, std::vector<uint8_t>& hits) const {
+    const size_t n = batch.size();
+    hits.assign(n, 0);
+    if (!isValid()) return;
+    // Hash the whole batch first, then probe, so the bit lookups are not interleaved with hashing
+    std::vector<uint64_t> h1s(n), h2s(n);
+    for (size_t i = 0; i < n; ++i) {
+        base_hashes(batch.view(i), h1s[i], h2s[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        hits[i] = probe(h1s[i], h2s[i]) ? 1 : 0;
+    }
+}
+
+void BloomFilter::insertBatch(const CandidateBatch& batch, const std::vector<uint8_t>& selected) {
+    if (!isValid()) return;
+    const size_t n = std::min(batch.size(), selected.size());
+    for (size_t i = 0; i < n; ++i) {
+        if (selected[i]) insert(batch.view(i));
     }
-    return true; // Probably present (or false positive)
 }
 
 bool BloomFilter::serialize(const std::string& filepath) const {
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstdint> // For uint64_t, uint32_t
 #include <cmath>   // For std::log, std::ceil
 #include <fstream> // For file I/O
@@ -21,6 +22,8 @@ inline uint64_t fnv1a_hash(const void* key, int len) {
 
 extern std::string skipListFilePath;
 
+class CandidateBatch;
+
 class BloomFilter {
 public:
     // Constructor: Calculates optimal size and hash count
@@ -30,10 +33,16 @@ public:
     BloomFilter() : m_num_bits(0), m_num_hashes(0), m_estimated_items(0), m_fp_rate(0.0) {}
 
     // Add an item to the filter
-    void insert(const std::string& item);
+    void insert(std::string_view item);
 
     // Check if an item might be in the filter
-    bool contains(const std::string& item) const;
+    bool contains(std::string_view item) const;
+
+    // Batched probe: hits[i] = 1 if candidate i of the batch might be in the filter
+    void containsBatch(const CandidateBatch& batch, std::vector<uint8_t>& hits) const;
+
+    // Batched insert of every candidate whose selected[i] flag is non-zero
+    void insertBatch(const CandidateBatch& batch, const std::vector<uint8_t>& selected);
 
     // Serialize the filter state to a file
     bool serialize(const std::string& filepath) const;
@@ -53,6 +62,7 @@ private:
     double m_fp_rate;           // Target false positive rate (p) - stored for info
     std::vector<bool> m_bits;   // The bit vector
 
-    // Generate k hash values for an item
-    void generate_hashes(const std::string& item, std::vector<uint64_t>& hashes) const;
+    // Base hashes for double hashing: bit i of an item is (h1 + i * h2) mod m
+    static void base_hashes(std::string_view item, uint64_t& h1, uint64_t& h2);
+    bool probe(uint64_t h1, uint64_t h2) const;
 };
\ No newline at end of file
@@ -8,24 +8,43 @@
 
 #include "brute_force.h"  // Includes CrackingMode enum, function declarations
 #include "bloom_filter.h" // Include Bloom Filter header
+#include "candidate_generator.h" // OdometerGenerator for in-place sequential generation
+#include "candidate_batch.h"     // CandidateBatch passed from generators to the filter and verifier
+#include "feistel_permutation.h" // Keyed O(1)-memory permutation for random mode
+#include "run_state.h"           // Seed and slice positions for resumable random mode
+#include "pattern_syntax.h"      // Pattern tokens, built-in and custom character classes
+#include "pattern_plan.h"        // Pattern compiled once: counts, prefix sums, layouts, automaton
+#include "wordlist.h"            // Memory-mapped wordlist, line-snapped slices
+#include "compiled_wordlist.h"   // Deduplicated, length-bucketed wordlists indexed by rank
+#include "rule_engine.h"         // Word mangling rules compiled to bytecode
+#include "combinator.h"          // Combinator and hybrid (wordlist + mask) attacks
+#include "markov_model.h"        // Markov-ordered brute force (level sums, exact ranks)
+#include "pcfg.h"                // PCFG guesses in descending probability
+#include "typo_neighborhood.h"   // Damerau-Levenshtein neighbourhood of remembered guesses
+#include "common_passwords.h"    // Built-in common password list for the pre-pass
+#include "archive_tokens.h"      // Guesses from archive metadata (names, comment, dates)
+#include "worker_pool.h"         // Process-wide worker threads shared by all phases and lengths
 #include <iostream>       // For std::cout, std::cerr
 #include <sstream>        // For std::ostringstream
 #include <vector>         // For std::vector
-#include <algorithm>      // For std::shuffle, std::min
+#include <algorithm>      // For std::min, std::max
 #include <cmath>          // For std::log, std::ceil
 #include <limits>         // For std::numeric_limits
 #include <chrono>         // For timing (std::chrono) AND SEEDING
 #include <cstdio>         // For C-style file I/O (popen etc)
-#include <numeric>        // For std::iota (filling index vector)
 #include <stdexcept>      // For exceptions like std::bad_alloc, std::overflow_error
-#include <random>         // For std::mt19937_64, std::shuffle, std::random_device
-#include <thread>         // For std::thread, std::hardware_concurrency
+#include <random>         // For std::random_device (random mode seed)
+#include <thread>         // For std::this_thread
 #include <mutex>          // For std::mutex, std::lock_guard
 #include <atomic>         // For std::atomic<bool>
 #include <iomanip>        // For std::fixed, std::setprecision in RAM log message
 #include <fstream>
 #include <optional> // For std::optional
-#include <map>      // For std::map in random pattern mode
+#include <functional> // For std::function (sequential run callbacks)
+#include <memory>   // For std::unique_ptr (slice progress counters)
+#include <deque>    // For the per-length stages of sequential runs
+#include <string_view> // For passing batch slots to tryPassword
+#include <type_traits> // For std::is_same (expansion worker statistics)
 
 // Platform-specific includes for process management
 #ifdef _WIN32
@@ -45,137 +64,17 @@ extern std::string skipListFilePath;                   // Use the path directly
 extern std::string sevenZipPath;                       // Defined in main.cpp
 extern void update_output(const std::string &message); // Defined in main.cpp
 
-struct PatternInfo
-{
-    int fixed_length; // Sum of literal lengths + number of '?'
-    int num_stars;    // Number of '*' wildcards
-};
-
 // ================================================================
 // ===                UTILITY / HELPER FUNCTIONS                ===
 // ================================================================
 
-// --- Pattern Parsing and Info ---
-std::vector<std::string> parse_pattern(const std::string &pattern)
-{
-    std::vector<std::string> segments;
-    std::string current_segment;
-    bool escape = false;
-
-    for (char c : pattern)
-    {
-        if (escape)
-        {
-            current_segment += c;
-            escape = false;
-        }
-        else if (c == '\\')
-        {
-            escape = true;
-        }
-        else if (c == '*' || c == '?')
-        {
-            if (!current_segment.empty())
-            {
-                segments.push_back(current_segment);
-                current_segment.clear();
-            }
-            segments.push_back(std::string(1, c));
-        }
-        else
-        {
-            current_segment += c;
-        }
-    }
-    if (!current_segment.empty())
-    {
-        segments.push_back(current_segment);
-    }
-    return segments;
-}
-
-PatternInfo calculate_pattern_info(const std::vector<std::string> &segments)
-{
-    int fixed_length = 0;
-    int num_stars = 0;
-    for (const auto &segment : segments)
-    {
-        if (segment == "*")
-        {
-            num_stars++;
-        }
-        else if (segment == "?")
-        {
-            fixed_length++;
-        }
-        else
-        {
-            fixed_length += segment.length();
-        }
-    }
-    return {fixed_length, num_stars};
-}
-
-// --- Calculates combinations for a pattern at a specific length ---
-std::optional<uint64_t> calculate_pattern_combinations(
-    const std::vector<std::string> &segments,
-    uint64_t charset_size,
-    int total_length)
+// --- Non-deterministic seed for random mode ---
+static uint64 random_seed()
 {
-    if (charset_size == 0)
-        return 0;
-
-    PatternInfo info = calculate_pattern_info(segments);
-    int fixed_part_len_total = info.fixed_length;
-    int num_stars = info.num_stars;
-    int num_qmarks = 0;
-
-    for (const auto &seg : segments)
-    {
-        if (seg == "?")
-            num_qmarks++;
-    }
-
-    if (total_length < fixed_part_len_total)
-        return 0;
-
-    if (num_stars == 0)
-    {
-        if (total_length != fixed_part_len_total)
-            return 0;
-        int wildcard_chars = num_qmarks;
-        if (wildcard_chars == 0)
-            return 1;
-        uint64_t combinations = 1;
-        for (int i = 0; i < wildcard_chars; ++i)
-        {
-            if (combinations > std::numeric_limits<uint64>::max() / charset_size)
-                return std::nullopt;
-            combinations *= charset_size;
-        }
-        return combinations;
-    }
-    else if (num_stars == 1)
-    {
-        int star_chars = total_length - fixed_part_len_total;
-        if (star_chars < 0)
-            return 0;
-        int total_wildcard_chars = num_qmarks + star_chars;
-        if (total_wildcard_chars == 0)
-            return 1;
-        uint64_t combinations = 1;
-        for (int i = 0; i < total_wildcard_chars; ++i)
-        {
-            if (combinations > std::numeric_limits<uint64>::max() / charset_size)
-                return std::nullopt;
-            combinations *= charset_size;
-        }
-        return combinations;
-    }
-    else
-    {
-        return std::nullopt; // Multiple stars: too complex for this calculation
-    }
+    std::random_device rd;
+    if (rd.entropy() > 0)
+        return static_cast<uint64>(rd()) << 32 | rd();
+    return static_cast<uint64>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
 }
 
 // --- Check if stop flag file exists ---
@@ -186,7 +85,7 @@ static bool stop_flag_exists(const std::string &path)
 }
 
 // --- Tries a single password against the archive ---
-static bool tryPassword(const std::string &password, const std::string &archivePath)
+static bool tryPassword(std::string_view password, const std::string &archivePath)
 {
     if (sevenZipPath.empty())
     {
@@ -211,11 +110,11 @@ static bool tryPassword(const std::string &password, const std::string &archiveP
         };
         wSevenZipPath = to_wstring(sevenZipPath);
         wArchivePath = to_wstring(archivePath);
-        wPasswordArg = to_wstring("-p" + password);
+        wPasswordArg = to_wstring("-p" + std::string(password));
     }
     catch (const std::exception &e)
     {
-        update_output("ERROR: UTF-8 to WString conversion failed: " + std::string(e.what()) + " - PWD: " + password);
+        update_output("ERROR: UTF-8 to WString conversion failed: " + std::string(e.what()) + " - PWD: " + std::string(password));
         return false;
     }
     std::wostringstream woss;
@@ -242,6 +141,9 @@ static bool tryPassword(const std::string &password, const std::string &archiveP
     CloseHandle(pi.hThread);
     return (exitCode == 0);
 #else
+    // Built before fork(): the child of a multithreaded process must not allocate
+    const std::string password_arg = "-p" + std::string(password);
+    const char *argv[] = {sevenZipPath.c_str(), "t", archivePath.c_str(), password_arg.c_str(), "-y", nullptr};
     pid_t pid = fork();
     if (pid == -1)
     {
@@ -250,8 +152,6 @@ static bool tryPassword(const std::string &password, const std::string &archiveP
     }
     if (pid == 0)
     {
-        std::string password_arg = "-p" + password;
-        const char *argv[] = {sevenZipPath.c_str(), "t", archivePath.c_str(), password_arg.c_str(), "-y", nullptr};
         int devNull = open("/dev/null", O_WRONLY);
         if (devNull != -1)
         {
@@ -265,7 +165,7 @@ static bool tryPassword(const std::string &password, const std::string &archiveP
         }
         execvp(sevenZipPath.c_str(), const_cast<char *const *>(argv));
         perror("execvp failed");
-        exit(127);
+        _exit(127); // Not exit(): static destructors (the worker pool) must not run in the child
     }
     else
     {
@@ -277,542 +177,676 @@ static bool tryPassword(const std::string &password, const std::string &archiveP
 }
 
 // --- Generates password from a standard global index (across all lengths) ---
-bool getPasswordByIndex(uint64 index, const std::string &charset, int max_possible_length, std::string &out_password)
+bool getPasswordByIndex(uint128 index, const std::string &charset, int max_possible_length, std::string &out_password)
 {
-    uint64 charsetSize = static_cast<uint64>(charset.size());
+    const uint64 charsetSize = static_cast<uint64>(charset.size());
     if (charsetSize == 0)
         return false;
-    uint64 current_index = index;
-    uint64 combinations_power = 1;
+    uint128 current_index = index;
+    uint128 combinations_this_len = 1;
     for (int len = 1; len <= max_possible_length; ++len)
     {
-        uint64 combinations_this_len = 0;
-        if (len == 1)
-        {
-            combinations_this_len = charsetSize;
-            combinations_power = charsetSize;
-        }
-        else
-        {
-            if (combinations_power > std::numeric_limits<uint64>::max() / charsetSize)
-                return false;
-            combinations_power *= charsetSize;
-            combinations_this_len = combinations_power;
-        }
+        if (!checked_mul(combinations_this_len, charsetSize, combinations_this_len))
+            return false;
         if (current_index < combinations_this_len)
         {
             out_password.assign(len, charset[0]);
-            uint64 index_within_length = current_index;
-            for (int i = 0; i < len; ++i)
+            // Rightmost characters first; 64-bit division once the remaining index fits
+            int pos = len - 1;
+            for (; pos >= 0 && !fits_u64(current_index); --pos)
+            {
+                out_password[pos] = charset[static_cast<size_t>(current_index % charsetSize)];
+                current_index /= charsetSize;
+            }
+            for (uint64 index_within_length = static_cast<uint64>(current_index); pos >= 0 && index_within_length != 0; --pos)
             {
-                uint64 char_idx = index_within_length % charsetSize;
-                out_password[len - 1 - i] = charset[char_idx];
+                out_password[pos] = charset[index_within_length % charsetSize];
                 index_within_length /= charsetSize;
-                if (index_within_length == 0 && i < len - 1)
-                    break;
             }
             return true;
         }
-        if (current_index < combinations_this_len)
-            return false;
         current_index -= combinations_this_len;
     }
     return false;
 }
 
-// --- Generates Nth password matching pattern for a SPECIFIC length ---
-// (Must be defined before getPatternPasswordByGlobalIndex)
-bool getPatternPasswordByIndex(
-    uint64_t index,
-    const std::vector<std::string> &segments,
-    const std::string &charset,
-    int total_length,
-    std::string &out_password)
+bool getIndexByPassword(std::string_view password, const std::string &charset, uint128 &out_index)
 {
-    uint64_t charset_size = static_cast<uint64>(charset.size());
-    if (charset_size == 0)
+    if (password.empty() || charset.empty())
         return false;
-    int fixed_part_len_literals = 0;
-    int num_qmarks = 0;
-    int num_stars = 0;
-    int star_len = 0;
-    for (const auto &seg : segments)
+    // Shorter lengths come first: charset^1 + ... + charset^(len - 1)
+    uint128 index = 0;
+    uint128 combinations_this_len = 1;
+    for (size_t len = 1; len < password.size(); ++len)
     {
-        if (seg == "?")
-            num_qmarks++;
-        else if (seg == "*")
-            num_stars++;
-        else
-            fixed_part_len_literals += seg.length();
+        if (!checked_mul(combinations_this_len, charset.size(), combinations_this_len) || !checked_add(index, combinations_this_len, index))
+            return false;
     }
-    int fixed_part_len_total = fixed_part_len_literals + num_qmarks;
-    if (static_cast<size_t>(total_length) < static_cast<size_t>(fixed_part_len_total))
+    if (!checked_mul(combinations_this_len, charset.size(), combinations_this_len))
         return false;
-    if (num_stars > 0)
+    uint128 index_within_length = 0;
+    for (char c : password)
     {
-        star_len = total_length - fixed_part_len_total;
-        if (star_len < 0)
+        const size_t digit = charset.find(c);
+        if (digit == std::string::npos)
             return false;
+        index_within_length = index_within_length * charset.size() + digit; // < charset^len, checked above
     }
-    else
+    return checked_add(index, index_within_length, out_index);
+}
+
+bool open_combination_side(const CrackOptions &options, const std::string &charset, int max_length, ComponentList &out, std::string &error)
+{
+    if (!options.combinator_path.empty())
+        return out.openWordlist(options.combinator_path, max_length, error);
+    ParsedPattern mask;
+    if (!parse_pattern(options.hybrid_mask, charset, options.custom_charsets, mask, error))
+        return false;
+    return out.compileMask(mask, max_length, options.increment, error);
+}
+
+// ================================================================
+// ===                    WORKER THREAD FUNCTIONS               ===
+// ================================================================
+
+// --- Shared state every worker thread needs to verify candidates ---
+struct WorkerContext
+{
+    const std::string &archivePath;
+    std::atomic<bool> &foundFlag;
+    std::string &foundPassword;
+    std::mutex &foundMutex;
+    BloomFilter *filter;
+    std::mutex *filterMutex;
+    const std::string &stop_flag_path;
+    std::atomic<bool> &stop_requested;
+
+    bool finished() const
     {
-        if (static_cast<size_t>(total_length) != static_cast<size_t>(fixed_part_len_total))
-            return false;
+        return foundFlag.load(std::memory_order_acquire) || stop_requested.load(std::memory_order_acquire);
     }
-    int total_wildcard_chars = num_qmarks + star_len;
-    if (total_wildcard_chars < 0)
+};
+
+// --- Filters and verifies one batch of candidates ---
+// The skip filter is probed for the whole batch up front and every tested candidate is added
+// back in one go, so the filter mutex is taken twice per batch instead of once per password.
+// Returns false once the password was found or a stop was requested. If `consumed` is given it
+// receives the number of leading candidates that were fully handled (tested or skipped).
+static bool verify_batch(const CandidateBatch &batch, WorkerContext &ctx, const char *worker_name, size_t *consumed = nullptr)
+{
+    if (consumed)
+        *consumed = 0;
+    if (batch.empty())
+        return !ctx.finished();
+    if (!ctx.stop_flag_path.empty() && stop_flag_exists(ctx.stop_flag_path))
+    {
+        update_output("INFO: Stop flag detected by " + std::string(worker_name) + " " + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".");
+        ctx.stop_requested.store(true, std::memory_order_release);
         return false;
-    std::string wildcard_values;
-    if (total_wildcard_chars > 0)
+    }
+
+    thread_local std::vector<uint8_t> skipped;
+    thread_local std::vector<uint8_t> tested;
+    if (ctx.filter && ctx.filterMutex)
     {
-        uint64_t combinations_power = 1;
-        uint64_t offset = 0;
-        for (int len = 1; len < total_wildcard_chars; ++len)
-        {
-            uint64_t combinations_this_len_offset = 0;
-            if (len == 1)
-            {
-                combinations_this_len_offset = charset_size;
-                combinations_power = charset_size;
-            }
-            else
-            {
-                if (combinations_power > std::numeric_limits<uint64>::max() / charset_size)
-                    return false;
-                combinations_power *= charset_size;
-                combinations_this_len_offset = combinations_power;
-            }
-            if (offset > std::numeric_limits<uint64>::max() - combinations_this_len_offset)
-                return false;
-            offset += combinations_this_len_offset;
-        }
-        if (offset > std::numeric_limits<uint64>::max() - index)
-            return false;
-        uint64_t global_index = offset + index;
-        if (!getPasswordByIndex(global_index, charset, total_wildcard_chars, wildcard_values))
-        {
-            update_output("WARN: getPasswordByIndex failed internally...");
-            return false;
-        }
-        if (wildcard_values.length() != static_cast<size_t>(total_wildcard_chars))
-        {
-            update_output("WARN: Pattern wildcard generation mismatch...");
-            return false;
-        }
+        std::lock_guard<std::mutex> filterLk(*ctx.filterMutex);
+        ctx.filter->containsBatch(batch, skipped);
     }
     else
     {
-        wildcard_values = "";
+        skipped.assign(batch.size(), 0);
     }
-    out_password.clear();
-    out_password.reserve(total_length);
-    int wildcard_idx = 0;
-    for (const auto &segment : segments)
+    tested.assign(batch.size(), 0);
+
+    bool keep_going = true;
+    size_t handled = 0;
+    for (; handled < batch.size(); ++handled)
     {
-        if (segment == "?")
+        if (ctx.finished())
         {
-            if (static_cast<size_t>(wildcard_idx) < wildcard_values.length())
-            {
-                out_password += wildcard_values[wildcard_idx++];
-            }
-            else
-            {
-                update_output("ERROR: Pattern assembly mismatch '?'...");
-                return false;
-            }
+            keep_going = false;
+            break;
         }
-        else if (segment == "*")
+        if (skipped[handled])
+            continue;
+        if (tryPassword(batch.view(handled), ctx.archivePath))
         {
-            int current_star_len = star_len;
-            if (static_cast<size_t>(wildcard_idx + current_star_len) <= wildcard_values.length())
-            {
-                out_password += wildcard_values.substr(wildcard_idx, current_star_len);
-                wildcard_idx += current_star_len;
-            }
-            else
+            bool expected = false;
+            if (ctx.foundFlag.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
             {
-                update_output("ERROR: Pattern assembly mismatch '*'...");
-                return false;
+                std::lock_guard<std::mutex> lk(ctx.foundMutex);
+                ctx.foundPassword.assign(batch.view(handled));
             }
+            keep_going = false;
+            ++handled;
+            break;
         }
-        else
-        {
-            out_password += segment;
-        }
+        tested[handled] = 1;
     }
-    if (out_password.length() != static_cast<size_t>(total_length))
+    if (consumed)
+        *consumed = handled;
+
+    if (ctx.filter && ctx.filterMutex)
     {
-        update_output("ERROR: Final pattern password length mismatch...");
-        return false;
+        std::lock_guard<std::mutex> filterLk(*ctx.filterMutex);
+        ctx.filter->insertBatch(batch, tested);
     }
-    return true;
+    return keep_going;
 }
 
-// --- Translates GLOBAL pattern index (across lengths) to a password ---
-// (Needs getPatternPasswordByIndex defined above)
-bool getPatternPasswordByGlobalIndex(
-    uint64_t global_pattern_index,
-    const std::vector<std::string> &segments,
-    const std::string &charset,
-    int min_len,
-    int max_len,
-    const std::map<int, uint64_t> &per_length_counts,
-    std::string &out_password)
+// --- Shared block queue for the sequential orders (one length at a time) ---
+// Threads claim fixed-size blocks in rank order instead of one static chunk each, so when a run
+// stops, every rank below the lowest unfinished position has been tested. That position is the
+// exact resume point for --start-index / --resume-from.
+class BlockQueue
 {
-    uint64_t current_global_index = global_pattern_index;
-    for (int L = min_len; L <= max_len; ++L)
+public:
+    static constexpr uint64_t kBlockSize = 4 * CandidateBatch::kDefaultCapacity;
+
+    BlockQueue(uint128 begin, uint128 end) : m_begin(begin), m_end(end), m_resume(end) {}
+
+    // Next unclaimed block [start, end); false once the range is used up
+    bool claim(uint128 &start, uint128 &end)
     {
-        auto it = per_length_counts.find(L);
-        if (it != per_length_counts.end())
-        {
-            uint64_t count_this_length = it->second;
-            if (count_this_length == 0)
-                continue;
-            if (current_global_index < count_this_length)
-            {
-                uint64_t local_idx = current_global_index;
-                // *** Fixed call: Uses the correctly defined function now ***
-                return getPatternPasswordByIndex(local_idx, segments, charset, L, out_password);
-            }
-            else
-            {
-                if (current_global_index < count_this_length)
-                    return false;
-                current_global_index -= count_this_length;
-            }
-        }
+        const uint128 offset = static_cast<uint128>(m_next.fetch_add(1, std::memory_order_relaxed)) * kBlockSize;
+        if (offset >= m_end - m_begin)
+            return false;
+        start = m_begin + offset;
+        end = (m_end - start > kBlockSize) ? start + kBlockSize : m_end;
+        return true;
     }
-    update_output("ERROR: Global pattern index " + std::to_string(global_pattern_index) + " out of range.");
-    return false;
-}
 
-// ================================================================
-// ===                    WORKER THREAD FUNCTIONS               ===
-// ================================================================
+    // A claimed block was left unfinished: ranks from `position` on were not all tested
+    void stoppedAt(uint128 position)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (position < m_resume)
+            m_resume = position;
+    }
+
+    // No worker will claim from here on (stop or hit): the unclaimed blocks stay untested
+    void abandon()
+    {
+        const uint128 claimed = static_cast<uint128>(m_next.load(std::memory_order_relaxed)) * kBlockSize;
+        stoppedAt(claimed < m_end - m_begin ? m_begin + claimed : m_end);
+    }
+
+    // First rank not known to be tested (the range end if every block finished)
+    uint128 resumePoint() const { return m_resume; }
+
+private:
+    const uint128 m_begin;
+    const uint128 m_end;
+    std::atomic<uint64_t> m_next{0}; // Block counter; no run gets through 2^64 blocks
+    std::mutex m_mutex;
+    uint128 m_resume;
+};
 
 // --- Worker for sequential mode ---
-static void sequential_password_worker(
-    int length, uint64 start_idx, uint64 end_idx, const std::string &charset, const std::string &archivePath,
-    std::atomic<bool> &foundFlag, std::string &foundPassword_out, std::mutex &foundMutex,
-    BloomFilter *filter, std::mutex *filterMutex, const std::string &stop_flag_path, std::atomic<bool> &stop_requested)
+static void sequential_password_worker(int length, BlockQueue &queue, const std::string &charset, WorkerContext &ctx)
 {
-    uint64 charsetSize = static_cast<uint64>(charset.size());
-    if (charsetSize == 0)
+    if (charset.empty())
         return;
-    for (uint64 idx = start_idx; idx < end_idx && !foundFlag.load(std::memory_order_acquire) && !stop_requested.load(std::memory_order_acquire); ++idx)
+    OdometerGenerator generator(charset, length);
+    CandidateBatch batch(length);
+    uint128 start = 0, end = 0;
+    while (queue.claim(start, end))
     {
-        std::string pwd(length, charset[0]);
-        uint64 current = idx;
-        for (int i = 0; i < length; ++i)
+        // Unrank the block start once, then advance in place
+        if (ctx.finished() || !generator.seek(start))
         {
-            pwd[length - 1 - i] = charset[current % charsetSize];
-            current /= charsetSize;
-            if (current == 0 && i < length - 1)
-                break;
-        }
-        if (idx % 1000 == 0) { // Check every 1000 iterations
-            if (!stop_flag_path.empty() && stop_flag_exists(stop_flag_path)) { // Check path validity first
-                // *** No serialization call here anymore ***
-                update_output("INFO: Stop flag detected by sequential worker " + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".");
-                stop_requested.store(true, std::memory_order_release); // Just set the flag
-                break; // Exit the loop
-            }
+            queue.stoppedAt(start);
+            return;
         }
-        bool skip = (filter && filter->contains(pwd));
-        if (!skip)
+        for (uint128 idx = start; idx < end;)
         {
-            if (tryPassword(pwd, archivePath))
+            batch.clear();
+            size_t appended = generator.fill(batch, idx, end - idx);
+            size_t consumed = 0;
+            if (appended == 0 || !verify_batch(batch, ctx, "sequential worker", &consumed))
             {
-                bool expected = false;
-                if (foundFlag.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
-                {
-                    std::lock_guard<std::mutex> lk(foundMutex);
-                    foundPassword_out = pwd;
-                }
+                queue.stoppedAt(idx + consumed);
                 return;
             }
-            else if (filter && filterMutex)
-            {
-                std::lock_guard<std::mutex> filterLk(*filterMutex);
-                filter->insert(pwd);
-            }
+            idx += appended;
         }
     }
 }
 
-// --- Worker for Asc/Desc pattern mode (using local indices per length) ---
-static void pattern_index_worker(
-    uint64_t start_idx, uint64_t end_idx, const std::vector<std::string> &segments, const std::string &charset, int total_length, const std::string &archivePath,
-    std::atomic<bool> &foundFlag, std::string &foundPassword_out, std::mutex &foundMutex,
-    BloomFilter *filter, std::mutex *filterMutex, const std::string &stop_flag_path, std::atomic<bool> &stop_requested)
+// --- Asc/Desc pattern mode: tests local indices [start_idx, end_idx) of one length ---
+// Multi-star patterns and groups enumerate each distinct password once on the automaton; otherwise
+// the odometer runs over the plan's layout for this length. Returns the first index not tested
+// (end_idx when the range is done).
+static uint128 pattern_index_range(uint128 start_idx, uint128 end_idx, const PatternPlan &plan, int total_length, CandidateBatch &batch,
+                                   WorkerContext &ctx)
 {
-    for (uint64 idx = start_idx; idx < end_idx && !foundFlag.load(std::memory_order_acquire) && !stop_requested.load(std::memory_order_acquire); ++idx)
+    if (const PatternAutomaton *automaton = plan.automaton())
     {
-        if (idx % 1000 == 0)
+        AutomatonGenerator generator(*automaton, total_length);
+        if (!generator.seek(start_idx))
         {
-            if (stop_flag_exists(stop_flag_path))
-            {
-                if (filter && filterMutex)
-                {
-                    std::lock_guard<std::mutex> lock(*filterMutex);
-                    filter->serialize(skipListFilePath);
-                    update_output("INFO: Stop flag detected by pattern worker...");
-                }
-                stop_requested.store(true, std::memory_order_release);
-                break;
-            }
+            update_output("WARN: Pattern index " + to_string(start_idx) + " out of range for length " + std::to_string(total_length));
+            return start_idx;
+        }
+        for (uint128 idx = start_idx; idx < end_idx;)
+        {
+            batch.clear();
+            size_t appended = generator.fill(batch, idx, end_idx - idx);
+            size_t consumed = 0;
+            if (appended == 0 || !verify_batch(batch, ctx, "pattern worker", &consumed))
+                return idx + consumed;
+            idx += appended;
         }
-        std::string pwd;
-        if (getPatternPasswordByIndex(idx, segments, charset, total_length, pwd))
+        return end_idx;
+    }
+
+    std::unique_ptr<OdometerGenerator> generator;
+    PatternLayout layout;
+    uint128 idx = start_idx;
+    batch.clear();
+    while (idx < end_idx)
+    {
+        if (!generator)
         {
-            bool skip = (filter && filter->contains(pwd));
-            if (!skip)
+            // Unrank the layout once, then advance in place
+            uint128 local_index = 0, first_index = 0;
+            if (!plan.layoutFor(idx, total_length, layout, local_index, first_index))
             {
-                if (tryPassword(pwd, archivePath))
-                {
-                    bool expected = false;
-                    if (foundFlag.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
-                    {
-                        std::lock_guard<std::mutex> lk(foundMutex);
-                        foundPassword_out = pwd;
-                    }
-                    return;
-                }
-                else if (filter && filterMutex)
-                {
-                    std::lock_guard<std::mutex> filterLk(*filterMutex);
-                    filter->insert(pwd);
-                }
+                update_output("WARN: Pattern index " + to_string(idx) + " out of range for length " + std::to_string(total_length));
+                return batch.empty() ? idx : batch.rank(0);
             }
+            generator = std::make_unique<OdometerGenerator>(plan.sets(), layout.templ, layout.wildcard_positions, layout.wildcard_sets);
+            generator->seek(local_index);
         }
-        else
+        idx += generator->fill(batch, idx, end_idx - idx);
+        if (generator->exhausted())
+            generator.reset(); // Next index is out of range and reported above
+        if (batch.full() || idx >= end_idx)
+        {
+            size_t consumed = 0;
+            if (!verify_batch(batch, ctx, "pattern worker", &consumed))
+                return consumed < batch.size() ? batch.rank(consumed) : idx;
+            batch.clear();
+        }
+    }
+    return idx;
+}
+
+// --- Worker for Asc/Desc pattern mode (blocks of local indices per length) ---
+static void pattern_index_worker(BlockQueue &queue, const PatternPlan &plan, int total_length, WorkerContext &ctx)
+{
+    CandidateBatch batch(total_length);
+    uint128 start = 0, end = 0;
+    while (queue.claim(start, end))
+    {
+        uint128 stopped = ctx.finished() ? start : pattern_index_range(start, end, plan, total_length, batch, ctx);
+        if (stopped < end)
         {
-            update_output("WARN: getPatternPasswordByIndex failed for index " + std::to_string(idx) + ", length " + std::to_string(total_length));
+            queue.stoppedAt(stopped);
+            return;
         }
     }
 }
 
-// --- Worker for standard random mode (shuffled global indices) ---
-static void shuffled_index_worker(
-    uint64 start_vector_idx, uint64 end_vector_idx, const std::vector<uint64> &shuffled_indices, uint64 global_index_offset, const std::string &charset, int max_length, const std::string &archivePath,
-    std::atomic<bool> &foundFlag, std::string &foundPassword_out, std::mutex &foundMutex,
-    BloomFilter *filter, std::mutex *filterMutex, const std::string &stop_flag_path, std::atomic<bool> &stop_requested)
+// --- Worker for standard random mode (permuted global indices) ---
+// Each thread walks a contiguous counter range; the permutation turns counters into shuffled ranks.
+// `progress` always holds the first counter of the slice that has not been handled yet.
+static void permuted_index_worker(
+    uint128 start_counter, uint128 end_counter, const FeistelPermutation &permutation, uint128 global_index_offset, const std::string &charset, int max_length,
+    WorkerContext &ctx, SliceCounter &progress)
 {
-    for (uint64 vec_idx = start_vector_idx; vec_idx < end_vector_idx && !foundFlag.load(std::memory_order_acquire) && !stop_requested.load(std::memory_order_acquire); ++vec_idx)
+    CandidateBatch batch(max_length);
+    std::string pwd;
+    uint128 batch_start = start_counter;
+    for (uint128 counter = start_counter; counter < end_counter && !ctx.finished(); ++counter)
     {
-        uint64 relative_index = shuffled_indices[vec_idx];
-        uint64 global_password_index = relative_index + global_index_offset;
-        if (vec_idx % 1000 == 0) { // Check every 1000 iterations
-            if (!stop_flag_path.empty() && stop_flag_exists(stop_flag_path)) { // Check path validity first
-               // *** No serialization call here anymore ***
-               update_output("INFO: Stop flag detected by shuffled_index_worker " + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".");
-               stop_requested.store(true, std::memory_order_release); // Just set the flag
-               break; // Exit the loop
-           }
-       }
-        std::string pwd;
+        uint128 global_password_index = permutation.permute(counter) + global_index_offset;
         if (getPasswordByIndex(global_password_index, charset, max_length, pwd))
         {
-            bool skip = (filter && filter->contains(pwd));
-            if (!skip)
-            {
-                if (tryPassword(pwd, archivePath))
-                {
-                    bool expected = false;
-                    if (foundFlag.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
-                    {
-                        std::lock_guard<std::mutex> lk(foundMutex);
-                        foundPassword_out = pwd;
-                    }
-                    return;
-                }
-                else if (filter && filterMutex)
-                {
-                    std::lock_guard<std::mutex> filterLk(*filterMutex);
-                    filter->insert(pwd);
-                }
-            }
+            batch.push(pwd, global_password_index);
         }
         else
         {
-            update_output("WARN: getPasswordByIndex failed for global index " + std::to_string(global_password_index));
+            update_output("WARN: getPasswordByIndex failed for global index " + to_string(global_password_index));
+        }
+        if (batch.full() || counter + 1 == end_counter)
+        {
+            size_t consumed = 0;
+            bool keep_going = verify_batch(batch, ctx, "permuted index worker", &consumed);
+            progress.store(batch_start + consumed, std::memory_order_release);
+            if (!keep_going)
+                break;
+            batch.clear();
+            batch_start = counter + 1;
         }
     }
 }
 
-// --- Worker for random pattern mode (shuffled global pattern indices) ---
-// (Needs stop_flag_exists, getPatternPasswordByGlobalIndex, tryPassword defined above)
-static void shuffled_pattern_worker(
-    uint64_t start_vector_idx, uint64_t end_vector_idx, const std::vector<uint64_t> &shuffled_indices, const std::vector<std::string> &segments, const std::string &charset,
-    int min_len, int max_len, const std::map<int, uint64_t> &per_length_counts, const std::string &archivePath,
-    std::atomic<bool> &foundFlag, std::string &foundPassword_out, std::mutex &foundMutex,
-    BloomFilter *filter, std::mutex *filterMutex, const std::string &stop_flag_path, std::atomic<bool> &stop_requested)
+// --- Worker for random pattern mode (permuted global pattern indices) ---
+// (Needs verify_batch defined above)
+static void permuted_pattern_worker(
+    uint128 start_counter, uint128 end_counter, const FeistelPermutation &permutation, const PatternPlan &plan, WorkerContext &ctx,
+    SliceCounter &progress)
 {
-    for (uint64 vec_idx = start_vector_idx; vec_idx < end_vector_idx && !foundFlag.load(std::memory_order_acquire) && !stop_requested.load(std::memory_order_acquire); ++vec_idx)
+    CandidateBatch batch(plan.maxLength());
+    std::string pwd;
+    uint128 batch_start = start_counter;
+    for (uint128 counter = start_counter; counter < end_counter && !ctx.finished(); ++counter)
     {
-        if (vec_idx % 1000 == 0)
+        uint128 global_pattern_index = permutation.permute(counter);
+        if (plan.unrankGlobal(global_pattern_index, pwd))
         {
-            // *** Fixed call: Uses the correctly defined function now ***
-            if (stop_flag_exists(stop_flag_path))
-            {
-                if (filter && filterMutex)
-                {
-                    std::lock_guard<std::mutex> lock(*filterMutex);
-                    filter->serialize(skipListFilePath);
-                    update_output("INFO: Stop flag detected by shuffled pattern worker...");
-                }
-                stop_requested.store(true, std::memory_order_release);
-                break;
-            }
+            batch.push(pwd, global_pattern_index);
         }
-        uint64 global_pattern_index = shuffled_indices[vec_idx];
-        std::string pwd;
-        if (getPatternPasswordByGlobalIndex(global_pattern_index, segments, charset, min_len, max_len, per_length_counts, pwd))
+        else
         {
-            bool skip = (filter && filter->contains(pwd));
-            if (!skip)
-            {
-                // *** Fixed call: Uses the correctly defined function now ***
-                if (tryPassword(pwd, archivePath))
-                {
-                    bool expected = false;
-                    if (foundFlag.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
-                    {
-                        std::lock_guard<std::mutex> lk(foundMutex);
-                        foundPassword_out = pwd;
-                    }
-                    return;
-                }
-                else if (filter && filterMutex)
-                {
-                    std::lock_guard<std::mutex> filterLk(*filterMutex);
-                    filter->insert(pwd);
-                }
-            }
+            update_output("WARN: Cannot unrank global pattern index " + to_string(global_pattern_index));
         }
-        else
+        if (batch.full() || counter + 1 == end_counter)
         {
-            update_output("WARN: getPatternPasswordByGlobalIndex failed for global pattern index " + std::to_string(global_pattern_index));
+            size_t consumed = 0;
+            bool keep_going = verify_batch(batch, ctx, "permuted pattern worker", &consumed);
+            progress.store(batch_start + consumed, std::memory_order_release);
+            if (!keep_going)
+                break;
+            batch.clear();
+            batch_start = counter + 1;
         }
     }
 }
 
-// ================================================================
-// ===     RECURSIVE GENERATORS (Optional Fallback - Not Used)  ===
-// ================================================================
-// Forward declare for mutual recursion
-void generate_pattern_passwords(const std::vector<std::string> &segments, const std::string &charset, int length, std::string current_pwd, size_t segment_idx, int pos, std::atomic<bool> &foundFlag, std::string &foundPassword_out, std::mutex &foundMutex, BloomFilter *filter, std::mutex *filterMutex, const std::string &archivePath, const std::string &stop_flag_path, std::atomic<bool> &stop_requested);
-
-void generate_suffix_combinations(const std::string &charset, std::string &suffix, size_t idx, const std::string &current_pwd, size_t segment_idx, int pos, int length, const std::vector<std::string> &segments, std::atomic<bool> &foundFlag, std::string &foundPassword_out, std::mutex &foundMutex, BloomFilter *filter, std::mutex *filterMutex, const std::string &archivePath, const std::string &stop_flag_path, std::atomic<bool> &stop_requested)
+// --- Worker for wordlist mode (one line-aligned byte slice of the mapped file) ---
+// `progress` always holds the offset of the first line of the slice that has not been handled yet.
+static void wordlist_worker(
+    const Wordlist &wordlist, uint64_t begin, uint64_t end, int min_length, int max_length, WorkerContext &ctx,
+    SliceCounter &progress, std::atomic<uint64_t> &skipped)
 {
-    if (idx == suffix.length())
+    WordlistReader reader(wordlist, begin, end, min_length, max_length);
+    CandidateBatch batch(max_length);
+    while (!reader.done() && !ctx.finished())
     {
-        std::string new_pwd = current_pwd + suffix;
-        generate_pattern_passwords(segments, charset, length, new_pwd, segment_idx + 1, pos, foundFlag, foundPassword_out, foundMutex, filter, filterMutex, archivePath, stop_flag_path, stop_requested);
-        return;
+        batch.clear();
+        reader.fill(batch);
+        size_t consumed = 0;
+        bool keep_going = verify_batch(batch, ctx, "wordlist worker", &consumed);
+        // Ranks are line offsets: resume at the first unhandled word, or after everything scanned
+        progress.store(consumed < batch.size() ? batch.rank(consumed) : reader.position(), std::memory_order_release);
+        if (!keep_going)
+            break;
     }
-    for (char c : charset)
+    skipped.fetch_add(reader.skipped(), std::memory_order_relaxed);
+}
+
+// --- Worker for compiled wordlists (a slice of word ranks) ---
+// Ranks are relative to `first_rank`; every batch holds words of a single length.
+static void compiled_wordlist_worker(
+    const CompiledWordlist &wordlist, uint64_t first_rank, uint64_t start, uint64_t end, int slot_length, WorkerContext &ctx,
+    SliceCounter &progress)
+{
+    CandidateBatch batch(slot_length);
+    uint64_t next = start;
+    while (next < end && !ctx.finished())
     {
-        if (foundFlag.load(std::memory_order_acquire) || stop_requested.load(std::memory_order_acquire))
+        batch.clear();
+        size_t appended = wordlist.fill(batch, first_rank + next, first_rank + end);
+        if (appended == 0)
+            break;
+        size_t consumed = 0;
+        bool keep_going = verify_batch(batch, ctx, "wordlist worker", &consumed);
+        progress.store(next + consumed, std::memory_order_release);
+        next += appended;
+        if (!keep_going)
             break;
-        suffix[idx] = c;
-        generate_suffix_combinations(charset, suffix, idx + 1, current_pwd, segment_idx, pos, length, segments, foundFlag, foundPassword_out, foundMutex, filter, filterMutex, archivePath, stop_flag_path, stop_requested);
     }
 }
 
-void generate_pattern_passwords(const std::vector<std::string> &segments, const std::string &charset, int length, std::string current_pwd, size_t segment_idx, int pos, std::atomic<bool> &foundFlag, std::string &foundPassword_out, std::mutex &foundMutex, BloomFilter *filter, std::mutex *filterMutex, const std::string &archivePath, const std::string &stop_flag_path, std::atomic<bool> &stop_requested)
+// --- Worker for Markov mode (a slice of Markov ranks) ---
+// The generator is unranked once at the slice start and then advanced in place.
+static void markov_worker(
+    const MarkovPlan &plan, uint64_t start, uint64_t end, int max_length, WorkerContext &ctx, SliceCounter &progress)
 {
-    if (segment_idx == segments.size())
-    {
-        if (pos == length && !foundFlag.load(std::memory_order_acquire) && !stop_requested.load(std::memory_order_acquire))
-        {
-            if (stop_flag_exists(stop_flag_path))
-            {
-                if (filter && filterMutex)
-                {
-                    std::lock_guard<std::mutex> lock(*filterMutex);
-                    filter->serialize(skipListFilePath);
-                    update_output("INFO: Stop flag detected (recursive gen)...");
-                }
-                stop_requested.store(true, std::memory_order_release);
-                return;
-            }
-            bool skip = (filter && filter->contains(current_pwd));
-            if (!skip)
-            {
-                if (tryPassword(current_pwd, archivePath))
-                {
-                    std::lock_guard<std::mutex> lock(foundMutex);
-                    if (!foundFlag.load(std::memory_order_acquire))
-                    {
-                        foundPassword_out = current_pwd;
-                        foundFlag.store(true, std::memory_order_release);
-                    }
-                }
-                else if (filter && filterMutex)
-                {
-                    std::lock_guard<std::mutex> filterLock(*filterMutex);
-                    filter->insert(current_pwd);
-                }
-            }
-        }
+    MarkovGenerator generator(plan);
+    if (!generator.seek(start))
         return;
+    CandidateBatch batch(max_length);
+    uint64_t next = start;
+    while (next < end && !ctx.finished())
+    {
+        batch.clear();
+        size_t appended = generator.fill(batch, next, end - next);
+        if (appended == 0)
+            break;
+        size_t consumed = 0;
+        bool keep_going = verify_batch(batch, ctx, "markov worker", &consumed);
+        progress.store(next + consumed, std::memory_order_release);
+        next += appended;
+        if (!keep_going)
+            break;
     }
-    if (foundFlag.load(std::memory_order_acquire) || stop_requested.load(std::memory_order_acquire))
-        return;
-    const std::string &segment = segments[segment_idx];
-    if (segment == "*")
+}
+
+// --- Worker for typo mode (a slice of neighbourhood ranks) ---
+static void typo_worker(
+    const TypoNeighborhood &neighborhood, uint64_t start, uint64_t end, int max_length, WorkerContext &ctx, SliceCounter &progress)
+{
+    CandidateBatch batch(max_length);
+    uint64_t next = start;
+    while (next < end && !ctx.finished())
     {
-        int remaining_fixed = 0;
-        for (size_t i = segment_idx + 1; i < segments.size(); ++i)
-        {
-            if (segments[i] == "?")
-                remaining_fixed++;
-            else if (segments[i] != "*")
-                remaining_fixed += segments[i].length();
-        }
-        int max_star_len = length - pos - remaining_fixed;
-        if (max_star_len < 0)
-            return;
-        for (int star_len = 0; star_len <= max_star_len && !foundFlag.load(std::memory_order_acquire) && !stop_requested.load(std::memory_order_acquire); ++star_len)
-        {
-            std::string suffix(star_len, ' ');
-            generate_suffix_combinations(charset, suffix, 0, current_pwd, segment_idx, pos + star_len, length, segments, foundFlag, foundPassword_out, foundMutex, filter, filterMutex, archivePath, stop_flag_path, stop_requested);
-        }
+        batch.clear();
+        size_t appended = neighborhood.fill(batch, next, end);
+        if (appended == 0)
+            break;
+        size_t consumed = 0;
+        bool keep_going = verify_batch(batch, ctx, "typo worker", &consumed);
+        progress.store(next + consumed, std::memory_order_release);
+        next += appended;
+        if (!keep_going)
+            break;
     }
-    else if (segment == "?")
+}
+
+// --- Common password pre-pass ---
+// The embedded passwords a length-range or pattern run could produce: the length range and the
+// charset (or, with a pattern, the pattern itself) and the password constraints. Popularity order is kept.
+static std::vector<std::string_view> select_common_passwords(
+    const std::string &charset, const ParsedPattern *pattern, const PasswordConstraints &constraints, int min_length, int max_length)
+{
+    std::vector<std::string_view> selected;
+    const ConstraintMachine machine(constraints);
+    ConstraintMachine::State state, next;
+    for (std::string_view word : common_passwords())
     {
-        if (pos + 1 <= length)
+        // A star-free pattern fixes the length itself
+        if ((!pattern || pattern->numStars() > 0) &&
+            (word.size() < static_cast<size_t>(min_length) || word.size() > static_cast<size_t>(max_length)))
+            continue;
+        if (pattern ? !pattern_matches(*pattern, word) : word.find_first_not_of(charset) != std::string_view::npos)
+            continue;
+        if (!constraints.empty())
         {
-            for (char c : charset)
+            bool allowed = true;
+            state = machine.initial();
+            for (size_t i = 0; i < word.size() && allowed; ++i)
             {
-                if (foundFlag.load(std::memory_order_acquire) || stop_requested.load(std::memory_order_acquire))
-                    break;
-                std::string new_pwd = current_pwd + c;
-                generate_pattern_passwords(segments, charset, length, new_pwd, segment_idx + 1, pos + 1, foundFlag, foundPassword_out, foundMutex, filter, filterMutex, archivePath, stop_flag_path, stop_requested);
+                allowed = machine.step(state, static_cast<unsigned char>(word[i]), next);
+                state.swap(next);
             }
+            if (!allowed || !machine.accepting(state))
+                continue;
         }
+        selected.push_back(word);
     }
-    else
-    {
-        if (static_cast<size_t>(pos) + segment.length() <= static_cast<size_t>(length))
-        {
-            std::string new_pwd = current_pwd + segment;
-            generate_pattern_passwords(segments, charset, length, new_pwd, segment_idx + 1, pos + segment.length(), foundFlag, foundPassword_out, foundMutex, filter, filterMutex, archivePath, stop_flag_path, stop_requested);
+    return selected;
+}
+
+// Thread `offset` tests words offset, offset + stride, ..., so the likeliest ones go first on every thread
+static void prepass_worker(
+    const std::vector<std::string_view> &words, size_t stride, size_t offset, int slot_length, WorkerContext &ctx)
+{
+    CandidateBatch batch(slot_length);
+    for (size_t i = offset; i < words.size() && !ctx.finished();)
+    {
+        batch.clear();
+        for (; i < words.size() && !batch.full(); i += stride)
+            batch.push(words[i], i);
+        if (!verify_batch(batch, ctx, "pre-pass worker"))
+            break;
+    }
+}
+
+// Tests a short list of guesses (pre-passes) on up to `num_threads` threads and waits for them
+static void run_prepass(const std::vector<std::string_view> &words, unsigned int num_threads, WorkerContext &ctx)
+{
+    size_t slot_length = 1;
+    for (std::string_view word : words)
+        slot_length = std::max(slot_length, word.size());
+    TaskGroup tasks;
+    const size_t stride = std::min<size_t>(num_threads, std::max<size_t>(1, words.size()));
+    for (size_t t = 0; t < stride && t < words.size(); ++t)
+        tasks.run(prepass_worker, std::cref(words), stride, t, static_cast<int>(slot_length), std::ref(ctx));
+    tasks.wait();
+}
+
+// Queue entries shared by all PCFG generators (about 48 bytes each, ~200 MB in total)
+static const size_t kPcfgQueueEntries = size_t(1) << 22;
+
+// --- Worker for PCFG mode ---
+// Guess order comes from a priority queue, so it cannot be unranked: every thread runs its own
+// generator over the full order and keeps guess g when g % stride == offset. Ranks and `progress`
+// count this thread's guesses, so a resumed slice regenerates and skips the first `start` of them.
+static void pcfg_worker(
+    const PcfgGrammar &grammar, size_t max_queue, uint64_t stride, uint64_t offset, uint64_t start, uint64_t end, int min_length,
+    int max_length, WorkerContext &ctx, SliceCounter &progress, std::atomic<uint64_t> &pruned)
+{
+    PcfgGenerator generator(grammar, max_queue);
+    CandidateBatch batch(max_length);
+    std::string guess;
+    uint64_t global = 0, local = 0;
+    bool guesses_left = true;
+    while (guesses_left && local < end && !ctx.finished())
+    {
+        batch.clear();
+        uint64_t batch_end = local; // Local index after the last guess examined for this batch
+        while (!batch.full() && local < end)
+        {
+            if (!(guesses_left = generator.next(guess)))
+                break;
+            if (global++ % stride != offset)
+                continue;
+            const uint64_t rank = local++;
+            batch_end = local;
+            if (rank < start || guess.size() < static_cast<size_t>(min_length) || guess.size() > static_cast<size_t>(max_length))
+                continue;
+            batch.push(guess, rank);
+        }
+        if (batch.empty())
+        {
+            if (batch_end > start)
+                progress.store(batch_end, std::memory_order_release);
+            continue;
         }
+        size_t consumed = 0;
+        bool keep_going = verify_batch(batch, ctx, "pcfg worker", &consumed);
+        progress.store(consumed < batch.size() ? batch.rank(consumed) : batch_end, std::memory_order_release);
+        if (!keep_going)
+            break;
+    }
+    pruned.fetch_add(generator.pruned(), std::memory_order_relaxed);
+}
+
+// --- Word sources for the rule worker ---
+// next() yields the following word and its index (text: byte offset of its line, compiled: rank
+// relative to the length range); position() is the index of the word next() would return.
+struct TextWordSource
+{
+    WordlistReader reader;
+
+    bool next(std::string_view &word, uint64_t &index) { return reader.next(word, index); }
+    uint64_t position() const { return reader.position(); }
+};
+
+struct CompiledWordSource
+{
+    const CompiledWordlist *wordlist;
+    uint64_t first_rank; // Rank of index 0
+    uint64_t next_index;
+    uint64_t end_index;
+
+    bool next(std::string_view &word, uint64_t &index)
+    {
+        if (next_index >= end_index)
+            return false;
+        word = wordlist->word(first_rank + next_index);
+        index = next_index++;
+        return true;
+    }
+    uint64_t position() const { return next_index; }
+};
+
+// --- Worker for wordlist + rules / combinator / hybrid (every word of a slice expanded per_word times) ---
+// Candidate ranks are word_index * per_word + k, so `progress` can point inside a word; a resumed
+// slice starts with the remaining expansions of its first word (`first`).
+struct ExpansionStats
+{
+    std::atomic<uint64_t> dropped{0};    // Rejected or outside the length range
+    std::atomic<uint64_t> results{0};    // Rules: passed the length range
+    std::atomic<uint64_t> duplicates{0}; // Rules: of those, skipped by the short-window dedup
+};
+
+template <typename WordSource, typename Expander>
+static void expansion_worker(
+    WordSource source, Expander expander, uint64_t per_word, size_t first, size_t slot_length, WorkerContext &ctx,
+    SliceCounter &progress, ExpansionStats &stats)
+{
+    CandidateBatch batch(slot_length);
+    std::string_view word;
+    uint64_t index = 0;
+    bool words_left = true;
+    if (first > 0 && (words_left = source.next(word, index)))
+        expander.setWord(word, index, first);
+    while (!ctx.finished())
+    {
+        batch.clear();
+        while (!batch.full())
+        {
+            if (expander.done())
+            {
+                if (!(words_left = source.next(word, index)))
+                    break;
+                expander.setWord(word, index);
+            }
+            expander.fill(batch);
+        }
+        size_t consumed = 0;
+        bool keep_going = verify_batch(batch, ctx, "expansion worker", &consumed);
+        uint64_t resume = expander.done() ? source.position() * per_word : expander.position();
+        progress.store(consumed < batch.size() ? batch.rank(consumed) : resume, std::memory_order_release);
+        if (!keep_going || (!words_left && expander.done()))
+            break;
+    }
+    stats.dropped.fetch_add(expander.dropped(), std::memory_order_relaxed);
+    if constexpr (std::is_same<Expander, RuleExpander>::value)
+    {
+        stats.results.fetch_add(expander.results(), std::memory_order_relaxed);
+        stats.duplicates.fetch_add(expander.duplicates(), std::memory_order_relaxed);
     }
 }
 
-// ================================================================
-// ===                MAIN BRUTE-FORCE DISPATCHER               ===
-// ================================================================
 // ================================================================
 // ===                MAIN BRUTE-FORCE DISPATCHER               ===
 // ================================================================
 std::string brute_force_worker_combined(
     const std::string &charset, int min_length, int max_length, const std::string &archivePath,
-    CrackingMode mode, BloomFilter *filter, std::mutex *filterMutex, int checkpointInterval, const std::string &pattern)
+    CrackingMode mode, BloomFilter *filter, std::mutex *filterMutex, int checkpointInterval, const CrackOptions &options)
 {
+    // Constraints are enforced on the pattern automaton, so plain brute force becomes the pattern "*"
+    std::string pattern = options.pattern;
+    if (pattern.empty() && options.wordlist_path.empty() && !options.constraints.empty())
+    {
+        update_output("INFO: Password constraints given; enumerating the charset as pattern '*'.");
+        pattern = "*";
+    }
     update_output("INFO: Starting brute-force worker...");
     auto startTime = std::chrono::high_resolution_clock::now();
     auto lastCheckpointTime = startTime;
@@ -823,34 +857,31 @@ std::string brute_force_worker_combined(
         return "";
     }
 
-    unsigned int numThreads = std::thread::hardware_concurrency();
-    if (numThreads == 0)
-        numThreads = 4;
-    numThreads = std::max(1u, numThreads);
+    const unsigned int numThreads = WorkerPool::shared().size();
     update_output("INFO: Using " + std::to_string(numThreads) + " worker threads.");
 
     std::atomic<bool> foundFlag(false);
     std::string foundPassword_internal;
     std::mutex foundMutex;
     std::atomic<bool> stop_requested(false); // Atomic stop flag shared across threads and main logic
-    std::string stop_flag_path = "";         // Initialize empty
-    if (filter && !skipListFilePath.empty()) { // Only define stop path if filter is active
-         stop_flag_path = skipListFilePath + ".stop";
-    }
+    // The stop flag follows --skip-file even when the filter itself had to be disabled (e.g. too large)
+    const std::string &stop_flag_path = options.stop_flag_path;
+    WorkerContext ctx{archivePath, foundFlag, foundPassword_internal, foundMutex,
+                      filter, filterMutex, stop_flag_path, stop_requested};
 
 
-    // Helper lambda for combination calculation (avoids code duplication)
-    auto calculate_combinations = [&](int length) -> uint64
+    // Helper lambda for combination calculation (avoids code duplication); 128-bit, so only
+    // lengths far beyond anything testable overflow
+    auto calculate_combinations = [&](int length) -> uint128
     {
         if (length <= 0) return 0;
-        uint64 combinations = 1;
+        uint128 combinations = 1;
         for (int i = 0; i < length; ++i)
         {
-            if (combinations > (std::numeric_limits<uint64>::max)() / charsetSize)
+            if (!checked_mul(combinations, charsetSize, combinations))
             {
                 throw std::overflow_error("Combination calculation overflow for length " + std::to_string(length));
             }
-            combinations *= charsetSize;
         }
         return combinations;
     };
@@ -891,30 +922,775 @@ std::string brute_force_worker_combined(
         return stop_requested.load(std::memory_order_acquire); // Also return true if already set
     };
 
+    // --- Position range of the run order (--start-index / --end-index, --shard, or --resume-from) ---
+    // Positions count candidates in the order the phase visits them: lengths in run order for the
+    // sequential modes, the shuffled order for random mode, slice domain units for the others.
+    const bool sharded = options.shard_count > 1;
+    const std::string shard_name = std::to_string(options.shard_index) + "/" + std::to_string(options.shard_count);
+    const bool has_range = options.start_index != 0 || options.end_index != kUint128Max || !options.resume_from.empty() || sharded;
+    uint128 range_begin = options.start_index; // Narrowed by apply_shard, moved by --resume-from
+    uint128 range_end = options.end_index;
+    // Clamps the range to the phase's [0, domain) and, with --shard i/N, keeps piece i of N of it.
+    // Pieces depend only on the domain and the range options, so every shard computes the same split.
+    auto apply_shard = [&](uint128 domain) {
+        if (options.phase_domain)
+            *options.phase_domain = domain;
+        range_begin = std::min(range_begin, domain);
+        range_end = std::max(range_begin, std::min(range_end, domain));
+        if (!sharded)
+            return;
+        const uint128 size = range_end - range_begin;
+        const uint128 piece = size / options.shard_count;
+        const uint128 extra = size % options.shard_count;
+        const uint128 index = options.shard_index;
+        const uint128 first = range_begin + piece * index + std::min(index, extra);
+        const uint128 last = first + piece + (index < extra ? 1 : 0);
+        update_output("INFO: Shard " + shard_name + ": positions " + to_string(first) + " to " + to_string(last) + " of " +
+                      to_string(range_begin) + " to " + to_string(range_end) + " (end exclusive).");
+        range_begin = first;
+        range_end = last;
+    };
+    // Pre-pass words are dealt round-robin across shards, so each one is tried by exactly one shard
+    auto shard_words = [&](const std::vector<std::string_view> &words) {
+        if (!sharded)
+            return words;
+        std::vector<std::string_view> mine;
+        for (size_t i = options.shard_index; i < words.size(); i += options.shard_count)
+            mine.push_back(words[i]);
+        return mine;
+    };
+    // --resume-from: starts at the candidate's position, which has to lie in this run's range
+    auto resume_at = [&](uint128 position) -> bool {
+        if (position < range_begin || position >= range_end) {
+            update_output("ERROR: --resume-from candidate '" + options.resume_from + "' is at position " + to_string(position) +
+                          ", outside this run's range " + to_string(range_begin) + " to " + to_string(range_end) +
+                          (sharded ? " (shard " + shard_name + ")." : "."));
+            return false;
+        }
+        range_begin = position;
+        return true;
+    };
+    auto resume_unsupported = [&](const std::string &what, bool has_positions = true) {
+        update_output("ERROR: --resume-from is not supported for " + what +
+                      (has_positions ? "; use --start-index with a logged position." : "; continue from its <skip-file>.state instead."));
+    };
+    // Slices of [0, domain) restricted to the position range, one per thread
+    auto split_range = [&](uint128 domain) {
+        return RunState::split(std::min(range_begin, domain), std::min(range_end, domain), numThreads);
+    };
+    // Sequential orders log where a stopped run can continue
+    auto log_resume_point = [&](uint128 position, const std::string &candidate) {
+        update_output("INFO: Resume point: position " + to_string(position) + (candidate.empty() ? std::string() : " (" + candidate + ")") +
+                      ". Continue with --start-index " + to_string(position) + (candidate.empty() ? std::string() : " or --resume-from " + candidate) + ".");
+    };
+    // Random mode: --resume-from starts at the counter that visits `rank` in the seeded order
+    auto resume_random_counter = [&](uint128 domain, uint128 rank) -> bool {
+        if (!options.has_seed) {
+            update_output("ERROR: --resume-from in random mode needs the --seed of the run being continued.");
+            return false;
+        }
+        return resume_at(FeistelPermutation(domain, options.seed).invert(rank));
+    };
+    auto resume_not_in_keyspace = [&]() {
+        update_output("ERROR: --resume-from candidate '" + options.resume_from + "' is not in this job's keyspace.");
+    };
+
+    // --- Random-order phase state (seed + per-slice positions) ---
+    RunState run_state;
+    std::unique_ptr<SliceCounter[]> slice_progress;
+
+    // Picks the slices for a resumable phase over [0, domain): `fresh_slices` for a new run, or the
+    // saved positions of the same job (and the same --seed, if given, for random phases).
+    // Returns false if nothing is left to test.
+    auto prepare_phase = [&](uint128 domain, const std::string &job_description, std::vector<SliceProgress> fresh_slices, bool random,
+                             const char *unit, const char *phase_name = nullptr) -> bool
+    {
+        const char *what = phase_name ? phase_name : (random ? "random order" : "wordlist");
+        run_state = RunState();
+        run_state.job_key = RunState::make_job_key(!has_range ? job_description
+                                                              : job_description + "\nrange\n" + to_string(range_begin) + "\n" + to_string(range_end) +
+                                                                    (sharded ? "\nshard\n" + shard_name : std::string()));
+        run_state.domain = domain;
+        run_state.order = what;
+        run_state.shard = sharded ? shard_name : std::string();
+        run_state.range_begin = std::min(range_begin, domain);
+        run_state.range_end = std::min(range_end, domain);
+
+        RunState saved;
+        bool resumed = !options.state_path.empty() && saved.load(options.state_path)
+                       && saved.job_key == run_state.job_key && saved.domain == domain
+                       && (!random || !options.has_seed || saved.seed == options.seed);
+        if (resumed)
+        {
+            run_state = saved;
+            update_output("INFO: Resuming " + std::string(what) + " from saved run state: " + options.state_path);
+        }
+        else
+        {
+            run_state.seed = !random ? 0 : (options.has_seed ? options.seed : random_seed());
+            run_state.slices = std::move(fresh_slices);
+        }
+        if (random)
+            update_output("INFO: Random order seed: " + std::to_string(run_state.seed) + " (use --seed to reproduce this order).");
+
+        slice_progress.reset(new SliceCounter[run_state.slices.size()]);
+        uint128 remaining = 0;
+        for (size_t i = 0; i < run_state.slices.size(); ++i)
+        {
+            slice_progress[i].reset(run_state.slices[i].begin, run_state.slices[i].next);
+            remaining += run_state.slices[i].end - run_state.slices[i].next;
+        }
+        if (resumed)
+            update_output("INFO: " + to_string(remaining) + " of " + to_string(domain) + " " + unit + " left in the saved " + what + ".");
+        return remaining > 0;
+    };
+
+    // Random phases split the counter space (or its position range) evenly, one slice per thread
+    auto prepare_random_phase = [&](uint128 domain, const std::string &job_description) -> bool
+    {
+        return prepare_phase(domain, job_description, split_range(domain), true, "candidates");
+    };
+
+    // Writes the current slice positions to the state file (no-op before a phase is prepared)
+    auto save_run_state = [&]()
+    {
+        if (options.state_path.empty() || run_state.slices.empty() || !slice_progress)
+            return;
+        for (size_t i = 0; i < run_state.slices.size(); ++i)
+            run_state.slices[i].next = slice_progress[i].load(std::memory_order_acquire);
+        if (run_state.save(options.state_path))
+            update_output("INFO: Run state saved to: " + options.state_path);
+        else
+            update_output("ERROR: Failed to save run state to: " + options.state_path);
+    };
+
+    // Job fingerprint shared by the brute-force and pattern phases; `order` is "random", "ascending" or "descending"
+    auto keyspace_job_description = [&](const std::string &order, int min_len, int max_len) -> std::string
+    {
+        std::string description = order + "\n" + charset + "\n" + std::to_string(min_len) + "\n" + std::to_string(max_len) + "\n" + pattern + "\n" + archivePath;
+        for (const auto &custom : options.custom_charsets)
+            description += "\n" + custom;
+        if (options.increment)
+            description += "\nincrement";
+        if (!options.constraints.empty())
+            description += "\n" + options.constraints.describe();
+        return description;
+    };
+
+    // --- Ascending / descending runs: lengths in run order, each split into claimed blocks ---
+    // Positions run over all lengths, so --start-index, --shard and --resume-from cut across them.
+    // The run state keeps one slice whose `next` is the tested prefix, saved after every length.
+    // `count(length)` is nullopt if the length overflows, `rank_in_length` ranks a --resume-from
+    // candidate within its length, `work` tests blocks of the length's queue until it is used up
+    // and `candidate_at` names a resume position. Returns false on a --resume-from error.
+    // There is no barrier between lengths: every pool thread walks the lengths in order and moves
+    // on as soon as the current length has no unclaimed block, while others finish theirs.
+    auto run_sequential = [&](const char *what, const std::function<std::optional<uint128>(int)> &count,
+                              const std::function<bool(const std::string &, uint128 &)> &rank_in_length,
+                              const std::function<void(int, BlockQueue &)> &work,
+                              const std::function<std::string(int, uint128)> &candidate_at) -> bool
+    {
+        const bool ascending = (mode == CrackingMode::ASCENDING);
+        const int start_len = ascending ? min_length : max_length;
+        const int end_len = ascending ? max_length : min_length;
+        const int step = ascending ? 1 : -1;
+
+        uint128 total = 0;
+        for (int length = min_length; length <= max_length; ++length)
+        {
+            if (!checked_add(total, count(length).value_or(0), total))
+                total = kUint128Max;
+        }
+        apply_shard(total);
+        if (!options.resume_from.empty())
+        {
+            // Rank within the candidate's length plus the lengths visited before it
+            const int resume_len = static_cast<int>(options.resume_from.size());
+            uint128 position = 0;
+            if (resume_len < min_length || resume_len > max_length || !rank_in_length(options.resume_from, position))
+            {
+                resume_not_in_keyspace();
+                return false;
+            }
+            for (int length = start_len; length != resume_len; length += step)
+            {
+                const std::optional<uint128> combinations = count(length);
+                if (!combinations || !checked_add(position, *combinations, position))
+                {
+                    update_output("ERROR: Position of --resume-from candidate '" + options.resume_from + "' overflows (length " +
+                                  std::to_string(length) + " is too large to count); use --start-index instead.");
+                    return false;
+                }
+            }
+            if (!resume_at(position))
+                return false;
+        }
+        if (range_begin >= range_end)
+        {
+            update_output("INFO: No candidates in this run's position range.");
+            return true;
+        }
+        if (!prepare_phase(total, keyspace_job_description(ascending ? "ascending" : "descending", min_length, max_length),
+                           {SliceProgress{range_begin, range_end, range_begin}}, false, "candidates",
+                           ascending ? "ascending order" : "descending order"))
+        {
+            update_output("INFO: Saved run state shows this job was already completed.");
+            return true;
+        }
+        const uint128 first = run_state.slices[0].next; // Later than range_begin if resumed from the state file
+        const uint128 last = run_state.slices[0].end;
+
+        // This run's share of every length, in run order
+        struct LengthStage
+        {
+            LengthStage(int length, uint128 offset, uint128 begin, uint128 end)
+                : length(length), offset(offset), queue(begin, end), end(end)
+            {
+            }
+            const int length;
+            const uint128 offset; // Position of the length's first candidate
+            BlockQueue queue;     // Ranks within the length
+            const uint128 end;
+            std::atomic<bool> announced{false};
+            unsigned left = 0;    // Workers done with this length (under progress_mutex)
+        };
+        std::deque<LengthStage> stages; // Never moved: workers hold references
+        uint128 run_offset = 0;
+        for (int length = start_len; step == 1 ? length <= end_len : length >= end_len; length += step)
+        {
+            const std::optional<uint128> combinations = count(length);
+            if (!combinations)
+            {
+                update_output("WARN: Cannot calculate combinations (overflow?) for length " + std::to_string(length) + ". Skipping.");
+                continue;
+            }
+            const uint128 length_offset = run_offset;
+            if (!checked_add(run_offset, *combinations, run_offset))
+                run_offset = kUint128Max;
+            // This length's share of the position range
+            const uint128 local_begin = first > length_offset ? std::min(first - length_offset, *combinations) : 0;
+            const uint128 local_end = last > length_offset ? std::min(last - length_offset, *combinations) : 0;
+            if (local_begin < local_end)
+                stages.emplace_back(length, length_offset, local_begin, local_end);
+        }
+
+        // The last worker to leave a length moves the tested prefix over every finished length
+        std::mutex progress_mutex;
+        size_t settled = 0;    // Stages folded into the prefix
+        bool gap = false;      // A stopped length ends the prefix for good
+        const unsigned workers = numThreads;
+        auto leave = [&](LengthStage &stage) {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            if (++stage.left < workers)
+                return;
+            if (!ctx.finished())
+                update_output("INFO: Workers finished length " + std::to_string(stage.length) + ".");
+            bool moved = false;
+            while (!gap && settled < stages.size() && stages[settled].left == workers)
+            {
+                const LengthStage &done = stages[settled];
+                slice_progress[0].store(done.offset + done.queue.resumePoint());
+                moved = true;
+                gap = done.queue.resumePoint() < done.end;
+                ++settled;
+            }
+            if (moved)
+            {
+                save_run_state();
+                checkpoint_filter_func(); // Checkpoint once a length is done
+            }
+        };
+
+        if (!check_stop_flag())
+        {
+            TaskGroup tasks;
+            for (unsigned int t = 0; t < workers; ++t)
+            {
+                tasks.run([&]() {
+                    for (LengthStage &stage : stages)
+                    {
+                        if (ctx.finished())
+                        {
+                            stage.queue.abandon();
+                        }
+                        else
+                        {
+                            if (!stage.announced.exchange(true))
+                                update_output("INFO: Testing " + std::string(what) + " of length " + std::to_string(stage.length) +
+                                              " (Combinations: " + to_string(count(stage.length).value_or(0)) + ")...");
+                            work(stage.length, stage.queue);
+                        }
+                        leave(stage);
+                    }
+                });
+            }
+            update_output("INFO: Waiting for workers...");
+            tasks.wait();
+        }
+        else
+        {
+            for (LengthStage &stage : stages)
+                stage.queue.abandon();
+        }
+
+        // First untested position, if the run ended early
+        if (!foundFlag.load(std::memory_order_acquire))
+        {
+            for (const LengthStage &stage : stages)
+            {
+                if (stage.queue.resumePoint() < stage.end)
+                {
+                    log_resume_point(stage.offset + stage.queue.resumePoint(), candidate_at(stage.length, stage.queue.resumePoint()));
+                    break;
+                }
+            }
+        }
+        return true;
+    };
+
 
     try
     {
-        if (!pattern.empty())
+        const bool keyspace_run = options.pcfg_path.empty() && options.typo_bases.empty() && options.wordlist_path.empty();
+        if (options.archive_tokens && keyspace_run)
+        {
+            // --- ARCHIVE METADATA PRE-PASS: file names, comment and dates the archive shows without a password ---
+            ArchiveMetadata metadata;
+            std::string metadata_error;
+            if (!read_archive_metadata(sevenZipPath, archivePath, metadata, metadata_error))
+                update_output("WARN: " + metadata_error);
+            const std::vector<std::string> guesses = archive_token_guesses(metadata);
+            std::vector<std::string_view> words;
+            for (const auto &guess : guesses)
+                if (guess.size() >= static_cast<size_t>(min_length) && guess.size() <= static_cast<size_t>(max_length))
+                    words.push_back(guess);
+            words = shard_words(words);
+            update_output("INFO: Testing " + std::to_string(words.size()) + " guesses built from archive metadata (" +
+                          std::to_string(metadata.paths.size()) + " names, " + std::to_string(metadata.comments.size()) + " comments, " +
+                          std::to_string(metadata.timestamps.size()) + " timestamps) first...");
+            run_prepass(words, numThreads, ctx);
+            if (foundFlag.load(std::memory_order_acquire))
+                update_output("INFO: Password found by the archive metadata pre-pass.");
+        }
+        if (options.common_passwords && keyspace_run && !foundFlag.load(std::memory_order_acquire) && !check_stop_flag())
+        {
+            // --- COMMON PASSWORD PRE-PASS (before length-range and pattern runs) ---
+            ParsedPattern parsed;
+            std::string parse_error;
+            if (!pattern.empty() && !parse_pattern(pattern, charset, options.custom_charsets, parsed, parse_error))
+            {
+                update_output("ERROR: " + parse_error);
+                return "";
+            }
+            const std::vector<std::string_view> words =
+                shard_words(select_common_passwords(charset, pattern.empty() ? nullptr : &parsed, options.constraints, min_length, max_length));
+            update_output("INFO: Testing " + std::to_string(words.size()) + " of the " + std::to_string(common_password_count()) +
+                          " built-in common passwords that fit this run first...");
+            run_prepass(words, numThreads, ctx);
+            if (foundFlag.load(std::memory_order_acquire))
+                update_output("INFO: Password found by the common password pre-pass.");
+        }
+
+        if (foundFlag.load(std::memory_order_acquire) || check_stop_flag())
+        {
+            // Found (or stopped) during a pre-pass: nothing left to run
+        }
+        else if (!options.pcfg_path.empty())
+        {
+            // --- PCFG MODE ---
+            if (!pattern.empty() || !options.wordlist_path.empty() || !options.markov_path.empty())
+                update_output("WARN: --pattern, --wordlist and --markov do not apply to --pcfg; ignoring them.");
+            if (mode != CrackingMode::ASCENDING)
+                update_output("INFO: PCFG guesses are tested in descending probability; the cracking mode does not apply.");
+            if (!options.resume_from.empty())
+            {
+                resume_unsupported("--pcfg", false);
+                return "";
+            }
+            if (options.start_index != 0 || options.end_index != kUint128Max)
+            {
+                update_output("ERROR: PCFG guesses are interleaved across threads and have no positions; --start-index and --end-index are not supported for --pcfg.");
+                return "";
+            }
+            PcfgGrammar grammar;
+            std::string grammar_error;
+            if (!grammar.load(options.pcfg_path, grammar_error))
+            {
+                update_output("ERROR: " + grammar_error);
+                return "";
+            }
+            const uint64_t total = grammar.guesses();
+            update_output("INFO: PCFG grammar " + options.pcfg_path + ": " + std::to_string(grammar.structures().size()) + " structures, " +
+                          std::to_string(total) + " guesses. Guesses shorter than " + std::to_string(min_length) + " or longer than " +
+                          std::to_string(max_length) + " characters are skipped.");
+
+            // Thread t owns guesses t, t + N, t + 2N, ... of the global order. With --shard i/S the
+            // stride is N * S and thread t starts at t * S + i, so shard i owns exactly the guesses
+            // congruent to i mod S, whatever the thread counts of the other shards.
+            const uint64_t shards = options.shard_count;
+            const uint64_t stride = numThreads * shards;
+            std::vector<SliceProgress> slices;
+            for (uint64_t t = 0; t < numThreads && t * shards + options.shard_index < total; ++t)
+                slices.push_back(SliceProgress{0, (total - (t * shards + options.shard_index) + stride - 1) / stride, 0});
+            std::string description = "pcfg\n" + options.pcfg_path + "\n" + std::to_string(total) + "\n" + std::to_string(min_length) +
+                                      "\n" + std::to_string(max_length) + "\n" + archivePath;
+            if (!prepare_phase(total, description, std::move(slices), false, "guesses", "PCFG order"))
+            {
+                update_output("INFO: Saved run state shows this PCFG job was already completed.");
+            }
+            else
+            {
+                // The saved state fixes the stride, so a resumed run keeps the same interleaving
+                const uint64_t saved_stride = run_state.slices.size() * shards;
+                const size_t max_queue = kPcfgQueueEntries / run_state.slices.size();
+                std::atomic<uint64_t> pruned(0);
+                TaskGroup tasks;
+                for (size_t t = 0; t < run_state.slices.size(); ++t)
+                {
+                    if (check_stop_flag()) break;
+                    const SliceProgress &slice = run_state.slices[t];
+                    if (slice.next >= slice.end) continue;
+                    tasks.run(pcfg_worker, std::cref(grammar), max_queue, saved_stride, t * shards + options.shard_index, slice.next,
+                                         slice.end, min_length, max_length, std::ref(ctx), std::ref(slice_progress[t]), std::ref(pruned));
+                }
+                update_output("INFO: Waiting for PCFG workers...");
+                tasks.wait();
+                update_output("INFO: PCFG workers finished.");
+                if (pruned.load() > 0)
+                    update_output("INFO: " + std::to_string(pruned.load()) + " low-probability PCFG branches were dropped at the queue memory limit.");
+                save_run_state();
+                checkpoint_filter_func();
+            }
+        } // End PCFG Mode
+        else if (!options.typo_bases.empty())
+        {
+            // --- TYPO MODE: every string within --typo-distance edits of a base, nearest first ---
+            if (!pattern.empty() || !options.wordlist_path.empty() || !options.markov_path.empty())
+                update_output("WARN: --pattern, --wordlist and --markov do not apply to --typo; ignoring them.");
+            if (mode != CrackingMode::ASCENDING)
+                update_output("INFO: Typo candidates are tested by edit distance; the cracking mode does not apply.");
+            if (!options.resume_from.empty())
+            {
+                resume_unsupported("--typo");
+                return "";
+            }
+            TypoNeighborhood neighborhood;
+            std::string typo_error;
+            if (!neighborhood.build(options.typo_bases, charset, options.typo_distance, options.typo_keyboard, min_length, max_length, typo_error))
+            {
+                update_output("ERROR: " + typo_error);
+                return "";
+            }
+            const uint64_t total = neighborhood.size();
+            update_output("INFO: Typo neighbourhood of " + std::to_string(options.typo_bases.size()) + " base(s) within distance " +
+                          std::to_string(options.typo_distance) + ": " + std::to_string(total) + " distinct candidates" +
+                          (options.typo_keyboard ? ", keyboard-adjacent slips first." : "."));
+            for (int d = 0; d <= options.typo_distance; ++d)
+                update_output("INFO:   distance " + std::to_string(d) + ": " + std::to_string(neighborhood.countAt(d)) + " candidates");
+
+            std::string description = "typo\n" + charset + "\n" + std::to_string(min_length) + "\n" + std::to_string(max_length) + "\n" +
+                                      archivePath + "\n" + std::to_string(options.typo_distance) + (options.typo_keyboard ? " keyboard" : "");
+            for (const auto &base : options.typo_bases)
+                description += "\n" + base;
+            apply_shard(total);
+            if (total == 0)
+            {
+                update_output("INFO: No typo candidates within the length range.");
+            }
+            else if (!prepare_phase(total, description, split_range(total), false, "candidates", "edit distance order"))
+            {
+                update_output("INFO: Saved run state shows this typo job was already completed.");
+            }
+            else
+            {
+                TaskGroup tasks;
+                for (size_t t = 0; t < run_state.slices.size(); ++t)
+                {
+                    if (check_stop_flag()) break;
+                    const SliceProgress &slice = run_state.slices[t];
+                    if (slice.next >= slice.end) continue;
+                    tasks.run(typo_worker, std::cref(neighborhood), slice.next, slice.end, max_length,
+                                         std::ref(ctx), std::ref(slice_progress[t]));
+                }
+                update_output("INFO: Waiting for typo workers...");
+                tasks.wait();
+                update_output("INFO: Typo workers finished.");
+                save_run_state();
+                checkpoint_filter_func();
+            }
+        } // End Typo Mode
+        else if (!options.wordlist_path.empty())
+        {
+            // --- WORDLIST MODE ---
+            if (!pattern.empty() || !options.constraints.empty())
+                update_output("WARN: --pattern and password constraints do not apply to --wordlist; ignoring them.");
+            const bool combination = !options.combinator_path.empty() || !options.hybrid_mask.empty();
+            if (combination && (!options.rules_path.empty() || (!options.combinator_path.empty() && !options.hybrid_mask.empty())))
+            {
+                update_output("ERROR: --rules, --combinator and --hybrid-append/--hybrid-prepend cannot be combined.");
+                return "";
+            }
+            if (mode != CrackingMode::ASCENDING)
+                update_output("INFO: Wordlist words are tested in file order; the cracking mode does not apply.");
+            std::string description = "\n" + options.wordlist_path + "\n" + std::to_string(min_length) + "\n" +
+                                      std::to_string(max_length) + "\n" + archivePath;
+            std::string open_error;
+            std::atomic<uint64_t> skipped(0);
+            ExpansionStats rule_stats;
+            CompiledWordlist compiled;
+            Wordlist wordlist;
+
+            // With rules every word stands for rules.size() candidates; slices stay word-aligned
+            RuleSet rules;
+            if (!options.rules_path.empty())
+            {
+                if (!rules.load(options.rules_path, open_error))
+                {
+                    update_output("ERROR: " + open_error);
+                    return "";
+                }
+                update_output("INFO: Loaded " + std::to_string(rules.size()) + " rules from " + options.rules_path +
+                              "; the length range applies to the rule results.");
+                description += "\nrules\n" + options.rules_path + "\n" + std::to_string(rules.size());
+            }
+
+            // Combinator / hybrid: every word stands for components.size() candidates
+            ComponentList components;
+            if (combination)
+            {
+                if (!open_combination_side(options, charset, max_length, components, open_error))
+                {
+                    update_output("ERROR: " + open_error);
+                    return "";
+                }
+                if (!options.combinator_path.empty())
+                {
+                    update_output("INFO: Combinator attack: every word is joined with the " + std::to_string(components.size()) +
+                                  " words of " + options.combinator_path + "; the length range applies to the joined candidates.");
+                    description += "\ncombinator\n" + options.combinator_path + "\n" + std::to_string(components.size());
+                }
+                else
+                {
+                    update_output("INFO: Hybrid attack: " + std::string(options.hybrid_prepend ? "mask + word" : "word + mask") + " with " +
+                                  std::to_string(components.size()) + " mask candidates per word; the length range applies to the joined candidates.");
+                    description += std::string(options.hybrid_prepend ? "\nhybrid-prepend\n" : "\nhybrid-append\n") + options.hybrid_mask +
+                                   (options.increment ? "\nincrement" : "");
+                    for (const auto &custom : options.custom_charsets)
+                        description += "\n" + custom;
+                }
+                if (components.size() == 0)
+                {
+                    update_output("INFO: The second half of the combination is empty; nothing to test.");
+                    return "";
+                }
+            }
+            const bool expanded = !rules.empty() || combination;
+            const uint64_t per_word = !rules.empty() ? rules.size() : (combination ? components.size() : 1);
+            // Longest input word worth reading (the expander filters the results by length)
+            const int word_limit = !rules.empty() ? static_cast<int>(RuleSet::kMaxLength) : max_length;
+            TaskGroup tasks; // After everything the workers borrow, so it is waited for before they go
+            auto launch_expansion = [&](auto source, size_t t, const SliceProgress &slice)
+            {
+                using Source = decltype(source);
+                const size_t first = static_cast<size_t>(slice.next % per_word);
+                if (!rules.empty())
+                    tasks.run(expansion_worker<Source, RuleExpander>, std::move(source),
+                                         RuleExpander(rules, min_length, max_length), per_word, first, RuleSet::kMaxLength,
+                                         std::ref(ctx), std::ref(slice_progress[t]), std::ref(rule_stats));
+                else
+                    tasks.run(expansion_worker<Source, CombinationExpander>, std::move(source),
+                                         CombinationExpander(components, options.combinator_path.empty() && options.hybrid_prepend,
+                                                             min_length, max_length),
+                                         per_word, first, static_cast<size_t>(max_length),
+                                         std::ref(ctx), std::ref(slice_progress[t]), std::ref(rule_stats));
+            };
+            auto scale_slices = [per_word](std::vector<SliceProgress> slices) {
+                for (auto &slice : slices)
+                {
+                    slice.begin *= per_word;
+                    slice.end *= per_word;
+                    slice.next *= per_word;
+                }
+                return slices;
+            };
+            // A word (line) belongs to the position range if its first candidate position does
+            auto first_word_at = [per_word](uint128 position, uint64_t words) {
+                const uint128 word = position / per_word + (position % per_word != 0 ? 1 : 0);
+                return static_cast<uint64_t>(std::min<uint128>(word, words));
+            };
+            if (!options.resume_from.empty() && expanded)
+            {
+                resume_unsupported("--rules, --combinator and hybrid attacks");
+                return "";
+            }
+
+            if (CompiledWordlist::isCompiled(options.wordlist_path))
+            {
+                if (!compiled.open(options.wordlist_path, open_error))
+                {
+                    update_output("ERROR: " + open_error);
+                    return "";
+                }
+                // The length range is one contiguous rank range; slices are ranks relative to its start
+                uint64_t first_rank = 0, end_rank = 0;
+                if (!expanded)
+                    compiled.rankRange(min_length, max_length, first_rank, end_rank);
+                else
+                    compiled.rankRange(1, word_limit, first_rank, end_rank);
+                update_output("INFO: Compiled wordlist mapped: " + options.wordlist_path + " (" + std::to_string(compiled.size()) +
+                              " distinct words" + (compiled.frequencyOrder() ? ", frequency order" : "") + "), " +
+                              std::to_string(end_rank - first_rank) + (!expanded ? " of length " + std::to_string(min_length) + "-" + std::to_string(max_length) : std::string(" used as input words")) + ".");
+                description = "compiled wordlist\n" + std::to_string(compiled.size()) + description;
+                const uint64_t words = end_rank - first_rank;
+                if (words > std::numeric_limits<uint64_t>::max() / per_word)
+                {
+                    update_output("ERROR: Wordlist size times expansions per word overflows 64 bits.");
+                    return "";
+                }
+                // Positions are ranks relative to the length range
+                apply_shard(words * per_word);
+                uint64_t resume_rank = 0;
+                if (!options.resume_from.empty())
+                {
+                    if (!compiled.rank(options.resume_from, resume_rank) || resume_rank < first_rank || resume_rank >= end_rank)
+                    {
+                        update_output("ERROR: --resume-from candidate is not in the compiled wordlist's length range.");
+                        return "";
+                    }
+                    if (!resume_at(resume_rank - first_rank))
+                        return "";
+                }
+                const std::vector<SliceProgress> word_slices = RunState::split(first_word_at(range_begin, words), first_word_at(range_end, words), numThreads);
+                if (!prepare_phase(words * per_word, description, scale_slices(word_slices), false,
+                                   expanded ? "candidates" : "words"))
+                {
+                    update_output("INFO: Saved run state shows this wordlist job was already completed.");
+                }
+                else
+                {
+                    const int slot_length = compiled.maxLength(first_rank, end_rank);
+                    for (size_t t = 0; t < run_state.slices.size(); ++t)
+                    {
+                        if (check_stop_flag()) break;
+                        const SliceProgress &slice = run_state.slices[t];
+                        if (slice.next >= slice.end) continue;
+
+                        if (!expanded)
+                            tasks.run(compiled_wordlist_worker, std::cref(compiled), first_rank, slice.next, slice.end, slot_length,
+                                                 std::ref(ctx), std::ref(slice_progress[t]));
+                        else
+                            launch_expansion(CompiledWordSource{&compiled, first_rank, static_cast<uint64_t>(slice.next / per_word), static_cast<uint64_t>(slice.end / per_word)}, t, slice);
+                    }
+                }
+            }
+            else
+            {
+                if (!wordlist.open(options.wordlist_path, open_error))
+                {
+                    update_output("ERROR: " + open_error);
+                    return "";
+                }
+                update_output("INFO: Wordlist mapped: " + options.wordlist_path + " (" + std::to_string(wordlist.size()) + " bytes, " +
+                              std::to_string(wordlist.countLines()) + " lines)." +
+                              (!expanded ? " Words shorter than " + std::to_string(min_length) + " or longer than " + std::to_string(max_length) + " characters are skipped." : std::string()));
+                // Slices are byte ranges snapped to line starts, so the saved positions are exact file offsets
+                description = "wordlist\n" + std::to_string(wordlist.size()) + description;
+                if (wordlist.size() > std::numeric_limits<uint64_t>::max() / per_word)
+                {
+                    update_output("ERROR: Wordlist size times expansions per word overflows 64 bits.");
+                    return "";
+                }
+                // Positions are byte offsets of lines
+                apply_shard(wordlist.size() * per_word);
+                uint64_t resume_offset = 0;
+                if (!options.resume_from.empty())
+                {
+                    if (!wordlist.find(options.resume_from, resume_offset))
+                    {
+                        update_output("ERROR: --resume-from candidate is not a line of " + options.wordlist_path + ".");
+                        return "";
+                    }
+                    if (!resume_at(resume_offset))
+                        return "";
+                }
+                const std::vector<SliceProgress> word_slices =
+                    wordlist.split(first_word_at(range_begin, wordlist.size()), first_word_at(range_end, wordlist.size()), numThreads);
+                if (!prepare_phase(wordlist.size() * per_word, description, scale_slices(word_slices), false,
+                                   expanded ? "positions" : "bytes"))
+                {
+                    update_output("INFO: Saved run state shows this wordlist job was already completed.");
+                }
+                else
+                {
+                    for (size_t t = 0; t < run_state.slices.size(); ++t)
+                    {
+                        if (check_stop_flag()) break;
+                        const SliceProgress &slice = run_state.slices[t];
+                        if (slice.next >= slice.end) continue;
+
+                        if (!expanded)
+                            tasks.run(wordlist_worker, std::cref(wordlist), slice.next, slice.end, min_length, max_length,
+                                                 std::ref(ctx), std::ref(slice_progress[t]), std::ref(skipped));
+                        else
+                            launch_expansion(TextWordSource{WordlistReader(wordlist, slice.next / per_word, slice.end / per_word, 1, word_limit)},
+                                             t, slice);
+                    }
+                }
+            }
+
+            if (!tasks.empty())
+            {
+                update_output("INFO: Waiting for wordlist workers...");
+                tasks.wait();
+                update_output("INFO: Wordlist workers finished.");
+                if (skipped.load() > 0)
+                    update_output("INFO: " + std::to_string(skipped.load()) + " words skipped because of their length.");
+                if (rule_stats.dropped.load() > 0)
+                    update_output("INFO: " + std::to_string(rule_stats.dropped.load()) +
+                                  (rules.empty() ? " joined candidates dropped (outside the length range)." : " rule results dropped (rejected by the rule or outside the length range)."));
+                if (!rules.empty() && rule_stats.results.load() > 0)
+                {
+                    char ratio[32];
+                    std::snprintf(ratio, sizeof(ratio), "%.2f%%", 100.0 * rule_stats.duplicates.load() / rule_stats.results.load());
+                    update_output("INFO: Rule file " + options.rules_path + ": " + std::to_string(rule_stats.duplicates.load()) + " of " +
+                                  std::to_string(rule_stats.results.load()) + " results were duplicates (" + ratio + ") and skipped.");
+                }
+                save_run_state();
+                checkpoint_filter_func();
+            }
+        } // End Wordlist Mode
+        else if (!pattern.empty())
         {
             // --- PATTERN MATCHING MODE ---
             update_output("INFO: Pattern matching mode enabled.");
-            auto segments = parse_pattern(pattern);
-            auto info = calculate_pattern_info(segments);
-            int initial_fixed_length = info.fixed_length;
-            int num_stars = info.num_stars;
+            if (!options.markov_path.empty())
+                update_output("WARN: --markov only applies to plain charset brute force (no pattern or constraints); ignoring it.");
+            ParsedPattern parsed;
+            std::string parse_error;
+            if (!parse_pattern(pattern, charset, options.custom_charsets, parsed, parse_error))
+            {
+                update_output("ERROR: " + parse_error);
+                return "";
+            }
+            int initial_fixed_length = parsed.fixedLength();
+            int longest_fixed_length = parsed.maxFixedLength();
+            int num_stars = parsed.numStars();
+            bool increment = options.increment && num_stars == 0 && !parsed.hasChoices();
+            if (options.increment && !increment)
+                update_output("WARN: --increment only applies to patterns without '*' or groups; ignoring it.");
 
             // Adjust min/max length based on pattern constraints
-            if (min_length < initial_fixed_length)
+            if (min_length < initial_fixed_length && !increment)
             {
                 update_output("INFO: Adjusted min_length from " + std::to_string(min_length) + " to pattern minimum " + std::to_string(initial_fixed_length));
                 min_length = initial_fixed_length;
             }
-            if (num_stars == 0) { // No wildcards means fixed length
-                if (max_length != initial_fixed_length) {
-                    update_output("INFO: Adjusted max_length to " + std::to_string(initial_fixed_length) + " (pattern has fixed length)");
-                    max_length = initial_fixed_length;
+            if (num_stars == 0) { // No wildcards means bounded length (or its prefixes with --increment)
+                if (max_length != longest_fixed_length) {
+                    update_output("INFO: Adjusted max_length to " + std::to_string(longest_fixed_length) + " (pattern has bounded length)");
+                    max_length = longest_fixed_length;
                 }
-                 if (min_length != initial_fixed_length) { // Should be caught above, but double-check
+                if (!increment && min_length > initial_fixed_length && !parsed.hasChoices()) { // Should be caught above, but double-check
                     min_length = initial_fixed_length;
                 }
             }
@@ -924,242 +1700,183 @@ std::string brute_force_worker_combined(
                 max_length = min_length;
             }
 
+            // Compile once: per-length counts, prefix sums and layouts (automaton for multi-star)
+            PatternPlan plan;
+            if (!plan.compile(parsed, min_length, max_length, increment, options.constraints))
+            {
+                update_output("ERROR: " + plan.error());
+                return "";
+            }
+            if (plan.automaton())
+                update_output("INFO: Pattern compiled to " + std::to_string(plan.automaton()->numStates()) + " automaton states (duplicate-free enumeration).");
+
             if (mode == CrackingMode::RANDOM_LCG)
             {
-                if (num_stars > 1)
-                {
-                    update_output("WARN: Random mode is currently unsupported for multi-star patterns. Falling back to ASCENDING order.");
-                    mode = CrackingMode::ASCENDING; // Fallback for multi-star random
+                // --- RANDOM PATTERN MODE ---
+                std::optional<uint128> totalOpt = plan.total();
+                uint128 total_pattern_combinations = totalOpt.value_or(0);
+                bool calculation_ok = totalOpt.has_value();
+                if (!calculation_ok)
+                    update_output("ERROR: Total pattern combination calculation overflowed.");
+
+                if (check_stop_flag()) { /* Stop requested, nothing to start */ }
+                else if (!calculation_ok) {
+                    update_output("INFO: Calculation issue or stop detected. Falling back to ASCENDING length order if needed.");
+                    mode = CrackingMode::ASCENDING; // Fallback if calculation failed
                 }
-                else
-                {
-                    // --- RANDOM PATTERN MODE ---
-                    update_output("INFO: Calculating total combinations for random pattern mode...");
-                    uint64 total_pattern_combinations = 0;
-                    std::map<int, uint64_t> per_length_counts;
-                    bool calculation_ok = true;
-
-                    for (int L = min_length; L <= max_length; ++L)
-                    {
-                        // *** ADD STOP CHECK *** before potentially long calculation
-                        if (check_stop_flag()) { calculation_ok = false; break; }
-
-                        std::optional<uint64_t> countOpt = calculate_pattern_combinations(segments, charsetSize, L);
-                        if (!countOpt)
-                        {
-                            update_output("ERROR: Pattern combination calculation failed (overflow?) for length " + std::to_string(L));
-                            calculation_ok = false;
-                            break;
-                        }
-                        uint64_t count_this_length = countOpt.value();
-                        if (count_this_length > 0)
-                        {
-                            per_length_counts[L] = count_this_length;
-                            if (total_pattern_combinations > std::numeric_limits<uint64>::max() - count_this_length)
-                            {
-                                update_output("ERROR: Total pattern combination calculation overflowed.");
-                                calculation_ok = false;
-                                break;
-                            }
-                            total_pattern_combinations += count_this_length;
+                else if (total_pattern_combinations == 0) {
+                    update_output("INFO: Pattern generates 0 combinations in the specified length range.");
+                    apply_shard(0);
+                    // No work to do, will exit naturally
+                }
+                else {
+                    update_output("INFO: Total pattern combinations in range: " + to_string(total_pattern_combinations));
+                    apply_shard(total_pattern_combinations);
+                    if (!options.resume_from.empty()) {
+                        uint128 resume_rank = 0;
+                        if (!plan.rankGlobal(options.resume_from, resume_rank)) {
+                            resume_not_in_keyspace();
+                            return "";
                         }
+                        if (!resume_random_counter(total_pattern_combinations, resume_rank))
+                            return "";
                     }
-
-                    if (check_stop_flag()) { /* Handled by break */ }
-                    else if (!calculation_ok) {
-                        update_output("INFO: Calculation issue or stop detected. Falling back to ASCENDING length order if needed.");
-                        mode = CrackingMode::ASCENDING; // Fallback if calculation failed
-                    }
-                    else if (total_pattern_combinations == 0) {
-                        update_output("INFO: Pattern generates 0 combinations in the specified length range.");
-                        // No work to do, will exit naturally
+                    // --- Keyed permutation of pattern indices (no index table, any space size) ---
+                    if (!prepare_random_phase(total_pattern_combinations, keyspace_job_description("random", min_length, max_length))) {
+                        update_output("INFO: Saved run state shows this random pattern job was already completed.");
                     }
                     else {
-                        update_output("INFO: Total pattern combinations in range: " + std::to_string(total_pattern_combinations));
-                        const uint64 MAX_REASONABLE_INDICES_RAM = (4ULL * 1024 * 1024 * 1024) / sizeof(uint64); // Approx 4GB RAM limit for index vector
-                        if (total_pattern_combinations > MAX_REASONABLE_INDICES_RAM) {
-                            update_output("ERROR: Pattern space too large for random mode RAM usage ("
-                                          + std::to_string(total_pattern_combinations * sizeof(uint64) / (1024*1024)) + " MB needed). Falling back to ASCENDING order.");
-                            mode = CrackingMode::ASCENDING; // Fallback if too large for RAM
-                        }
-                        else {
-                            // --- Generate and Shuffle Indices for Random Pattern ---
-                            update_output("INFO: Generating and shuffling " + std::to_string(total_pattern_combinations) + " pattern indices...");
-                            std::vector<uint64> indices(total_pattern_combinations);
-                            std::iota(indices.begin(), indices.end(), 0ULL);
-
-                            // *** ADD STOP CHECK *** before potentially long shuffle
-                            if (check_stop_flag()) { /* Will skip shuffling and threads */ }
-                            else {
-                                uint64 seed_value;
-                                std::random_device rd;
-                                if (rd.entropy() > 0) { seed_value = static_cast<uint64>(rd()) << 32 | rd(); }
-                                else { seed_value = static_cast<uint64>(std::chrono::high_resolution_clock::now().time_since_epoch().count()); }
-                                std::mt19937_64 rng(seed_value);
-                                std::shuffle(indices.begin(), indices.end(), rng);
-                                update_output("INFO: Pattern indices shuffled.");
-
-                                // *** ADD STOP CHECK *** after shuffling, before threads
-                                if (check_stop_flag()) { /* Will skip threads */ }
-                                else {
-                                    uint64 itemsPerThread = (total_pattern_combinations + numThreads - 1) / numThreads;
-                                    if (itemsPerThread == 0) itemsPerThread = 1;
-
-                                    std::vector<std::thread> threads;
-                                    threads.reserve(numThreads);
-                                    for (unsigned int t = 0; t < numThreads; ++t) {
-                                        if (check_stop_flag()) break; // Check before spawning each thread
-                                        uint64 startVecIdx = t * itemsPerThread;
-                                        uint64 endVecIdx = std::min(startVecIdx + itemsPerThread, total_pattern_combinations);
-                                        if (startVecIdx >= endVecIdx) break;
-
-                                        threads.emplace_back(shuffled_pattern_worker, startVecIdx, endVecIdx,
-                                                             std::cref(indices), std::cref(segments), std::cref(charset),
-                                                             min_length, max_length, std::cref(per_length_counts), std::cref(archivePath),
-                                                             std::ref(foundFlag), std::ref(foundPassword_internal), std::ref(foundMutex),
-                                                             filter, filterMutex, std::cref(stop_flag_path), std::ref(stop_requested));
-                                    }
-
-                                    update_output("INFO: Waiting for shuffled pattern worker threads...");
-                                    for (auto &th : threads) { if (th.joinable()) th.join(); }
-                                    update_output("INFO: Shuffled pattern worker threads joined.");
-                                    checkpoint_filter_func(); // Checkpoint after joining
-                                }
-                            }
+                        FeistelPermutation permutation(total_pattern_combinations, run_state.seed);
+                        update_output("INFO: Pattern indices will be visited in keyed pseudo-random order.");
+
+                        TaskGroup tasks;
+                        for (size_t t = 0; t < run_state.slices.size(); ++t) {
+                            if (check_stop_flag()) break; // Check before spawning each thread
+                            const SliceProgress &slice = run_state.slices[t];
+                            if (slice.next >= slice.end) continue;
+
+                            tasks.run(permuted_pattern_worker, slice.next, slice.end,
+                                                 std::cref(permutation), std::cref(plan), std::ref(ctx),
+                                                 std::ref(slice_progress[t]));
                         }
+
+                        update_output("INFO: Waiting for permuted pattern workers...");
+                        tasks.wait();
+                        update_output("INFO: Permuted pattern workers finished.");
+                        save_run_state();
+                        checkpoint_filter_func(); // Checkpoint after joining
                     }
                 }
             } // End of RANDOM_LCG pattern mode specific logic
 
             // --- ASCENDING/DESCENDING PATTERN MODE (or fallback) ---
             if (mode == CrackingMode::ASCENDING || mode == CrackingMode::DESCENDING) {
-                int start_len = (mode == CrackingMode::ASCENDING) ? min_length : max_length;
-                int end_len   = (mode == CrackingMode::ASCENDING) ? max_length : min_length;
-                int step      = (mode == CrackingMode::ASCENDING) ? 1 : -1;
-
-                int current_len = start_len;
-                // Main loop iterating through lengths for pattern mode
-                while ((step == 1 ? current_len <= end_len : current_len >= end_len)
-                       && !foundFlag.load(std::memory_order_acquire)
-                       && !check_stop_flag()) // *** ADD STOP CHECK *** here
-                {
-                    int L = current_len;
-                    std::optional<uint64_t> combinationsOpt = calculate_pattern_combinations(segments, charsetSize, L);
-                    std::string combo_str = "N/A";
-                    uint64_t totalCombinationsThisLength = 0;
-
-                    if (!combinationsOpt) {
-                        update_output("WARN: Cannot calculate combinations (overflow?) for pattern length " + std::to_string(L) + ". Skipping.");
-                        current_len += step;
-                        continue;
-                    }
-
-                    totalCombinationsThisLength = combinationsOpt.value();
-                    if (totalCombinationsThisLength == 0) {
-                        // update_output("DEBUG: Pattern length " + std::to_string(L) + " yields 0 combinations."); // Optional debug
-                        current_len += step;
-                        continue;
-                    }
-                    combo_str = std::to_string(totalCombinationsThisLength);
-
-                    update_output("INFO: Testing pattern matching passwords of length " + std::to_string(L) +
-                                  " (Combinations: " + combo_str + ")...");
-
-                    uint64 itemsPerThread = (totalCombinationsThisLength + numThreads - 1) / numThreads;
-                    if (itemsPerThread == 0) itemsPerThread = 1;
-
-                    std::vector<std::thread> threads;
-                    threads.reserve(numThreads);
-                    for (unsigned int t = 0; t < numThreads; ++t) {
-                         if (check_stop_flag()) break; // Check before spawning each thread
-                        uint64 startIdx = t * itemsPerThread;
-                        uint64 endIdx = std::min(startIdx + itemsPerThread, totalCombinationsThisLength);
-                        if (startIdx >= endIdx) break;
-
-                        threads.emplace_back(pattern_index_worker, startIdx, endIdx,
-                                             std::cref(segments), std::cref(charset), L, std::cref(archivePath),
-                                             std::ref(foundFlag), std::ref(foundPassword_internal), std::ref(foundMutex),
-                                             filter, filterMutex, std::cref(stop_flag_path), std::ref(stop_requested));
-                    }
-
-                    update_output("INFO: Waiting for pattern worker threads for length " + std::to_string(L) + "...");
-                    for (auto &th : threads) { if (th.joinable()) th.join(); }
-                    update_output("INFO: Pattern worker threads joined for length " + std::to_string(L) + ".");
-                    checkpoint_filter_func(); // Checkpoint after joining threads for this length
-
-                    // No need to check foundFlag or stop_requested again here, the outer loop does it.
-                    current_len += step; // Move to next length
-                }
+                const bool ok = run_sequential(
+                    "pattern matching passwords", [&](int length) { return plan.count(length); },
+                    [&](const std::string &password, uint128 &rank) { return plan.rank(password, rank); },
+                    [&](int length, BlockQueue &queue) { pattern_index_worker(queue, plan, length, ctx); },
+                    [&](int length, uint128 rank) {
+                        std::string candidate;
+                        plan.unrank(rank, length, candidate);
+                        return candidate;
+                    });
+                if (!ok)
+                    return "";
             } // End Asc/Desc Pattern Mode
         } // End Pattern Matching Mode (!pattern.empty())
         else
         {
             // --- STANDARD BRUTE-FORCE MODE (No Pattern) ---
-            if (mode == CrackingMode::ASCENDING || mode == CrackingMode::DESCENDING) {
-                int start_len = (mode == CrackingMode::ASCENDING) ? min_length : max_length;
-                int end_len   = (mode == CrackingMode::ASCENDING) ? max_length : min_length;
-                int step      = (mode == CrackingMode::ASCENDING) ? 1 : -1;
-
-                // Main loop iterating through lengths for standard mode
-                for (int length = start_len;
-                     (step == 1 ? length <= end_len : length >= end_len)
-                     && !foundFlag.load(std::memory_order_acquire)
-                     && !check_stop_flag(); // *** ADD STOP CHECK *** here
-                     length += step)
-                {
-                    uint64 totalCombinationsThisLength = 0;
-                    try {
-                        totalCombinationsThisLength = calculate_combinations(length);
-                    } catch (const std::overflow_error &e) {
-                        update_output("WARN: Combination calculation overflow for length " + std::to_string(length) + ". Skipping.");
-                        continue; // Skip this length if calculation fails
-                    }
-
-                    if (totalCombinationsThisLength == 0) continue;
-
-                    update_output("INFO: Testing passwords of length " + std::to_string(length) +
-                                  " (Combinations: " + std::to_string(totalCombinationsThisLength) + ")...");
-
-                    uint64 itemsPerThread = (totalCombinationsThisLength + numThreads - 1) / numThreads;
-                    if (itemsPerThread == 0) itemsPerThread = 1;
-
-                    std::vector<std::thread> threads;
-                    threads.reserve(numThreads);
-                    for (unsigned int t = 0; t < numThreads; ++t) {
-                        if (check_stop_flag()) break; // Check before spawning each thread
-                        uint64 startIdx = t * itemsPerThread;
-                        uint64 endIdx = std::min(startIdx + itemsPerThread, totalCombinationsThisLength);
-                        if (startIdx >= endIdx) break;
-
-                        threads.emplace_back(sequential_password_worker, length, startIdx, endIdx,
-                                             std::cref(charset), std::cref(archivePath),
-                                             std::ref(foundFlag), std::ref(foundPassword_internal), std::ref(foundMutex),
-                                             filter, filterMutex, std::cref(stop_flag_path), std::ref(stop_requested));
+            if (!options.markov_path.empty()) {
+                // --- MARKOV MODE: most likely candidates first, level sum groups over all lengths ---
+                if (mode != CrackingMode::ASCENDING)
+                    update_output("INFO: Markov mode orders candidates by probability; the cracking mode does not apply.");
+                if (!options.resume_from.empty()) {
+                    resume_unsupported("--markov");
+                    return "";
+                }
+                MarkovModel model;
+                std::string model_error;
+                if (!model.load(options.markov_path, model_error)) {
+                    update_output("ERROR: " + model_error);
+                    return "";
+                }
+                MarkovPlan plan;
+                if (!plan.compile(model, charset, min_length, max_length, options.markov_threshold)) {
+                    update_output("ERROR: " + plan.error());
+                    return "";
+                }
+                const uint64_t total = plan.total().value_or(0);
+                update_output("INFO: Markov model " + options.markov_path + ": " + std::to_string(total) + " candidates up to level sum " +
+                              std::to_string(plan.maxLevelSum()) + (options.markov_threshold >= 0 ? " (--markov-threshold)" : "") + ".");
+                for (int level = 10; level < plan.maxLevelSum(); level += 10)
+                    update_output("INFO:   level sum <= " + std::to_string(level) + ": " + std::to_string(plan.countUpTo(level)) + " candidates");
+
+                std::string description = "markov\n" + charset + "\n" + std::to_string(min_length) + "\n" + std::to_string(max_length) + "\n" +
+                                          archivePath + "\n" + options.markov_path + "\n" + std::to_string(options.markov_threshold);
+                apply_shard(total);
+                if (total == 0) {
+                    update_output("INFO: No candidates within the Markov threshold.");
+                }
+                else if (!prepare_phase(total, description, split_range(total), false, "candidates", "Markov order")) {
+                    update_output("INFO: Saved run state shows this Markov job was already completed.");
+                }
+                else {
+                    TaskGroup tasks;
+                    for (size_t t = 0; t < run_state.slices.size(); ++t) {
+                        if (check_stop_flag()) break;
+                        const SliceProgress &slice = run_state.slices[t];
+                        if (slice.next >= slice.end) continue;
+                        tasks.run(markov_worker, std::cref(plan), slice.next, slice.end, max_length,
+                                             std::ref(ctx), std::ref(slice_progress[t]));
                     }
-
-                    update_output("INFO: Waiting for worker threads for length " + std::to_string(length) + "...");
-                    for (auto &th : threads) { if (th.joinable()) th.join(); }
-                    update_output("INFO: Worker threads joined for length " + std::to_string(length) + ".");
-                    checkpoint_filter_func(); // Checkpoint after joining threads for this length
-
-                    // No need to check foundFlag or stop_requested again here, the outer loop does it.
+                    update_output("INFO: Waiting for Markov workers...");
+                    tasks.wait();
+                    update_output("INFO: Markov workers finished.");
+                    save_run_state();
+                    checkpoint_filter_func();
                 }
+            } // End Markov Mode
+            else if (mode == CrackingMode::ASCENDING || mode == CrackingMode::DESCENDING) {
+                auto count = [&](int length) -> std::optional<uint128> {
+                    try {
+                        return calculate_combinations(length);
+                    } catch (const std::overflow_error &) {
+                        return std::nullopt;
+                    }
+                };
+                const bool ok = run_sequential(
+                    "passwords", count,
+                    [&](const std::string &password, uint128 &rank) {
+                        // Global index minus the shorter lengths
+                        if (!getIndexByPassword(password, charset, rank))
+                            return false;
+                        for (int length = 1; length < static_cast<int>(password.size()); ++length)
+                            rank -= count(length).value_or(0);
+                        return true;
+                    },
+                    [&](int length, BlockQueue &queue) { sequential_password_worker(length, queue, charset, ctx); },
+                    [&](int length, uint128 rank) {
+                        OdometerGenerator generator(charset, length);
+                        return generator.seek(rank) ? generator.current() : std::string();
+                    });
+                if (!ok)
+                    return "";
             } // End Asc/Desc Standard Mode
             else { // Standard RANDOM_LCG Mode
                 update_output("INFO: Calculating total combinations for random mode...");
-                uint64 total_passwords_prefix = 0;
-                uint64 total_passwords_target = 0;
+                uint128 total_passwords_prefix = 0;
+                uint128 total_passwords_target = 0;
                 bool calculation_ok = true;
 
                 for (int len = 1; len < min_length; ++len) {
                     // *** ADD STOP CHECK ***
                     if (check_stop_flag()) { calculation_ok = false; break; }
                     try {
-                        uint64 comb = calculate_combinations(len);
-                        if (total_passwords_prefix > (std::numeric_limits<uint64>::max)() - comb) {
+                        uint128 comb = calculate_combinations(len);
+                        if (!checked_add(total_passwords_prefix, comb, total_passwords_prefix)) {
                             throw std::overflow_error("Overflow calculating total prefix password count.");
                         }
-                        total_passwords_prefix += comb;
                     } catch (const std::exception& e) {
                          update_output("ERROR: " + std::string(e.what()));
                          calculation_ok = false; break;
@@ -1171,11 +1888,10 @@ std::string brute_force_worker_combined(
                          // *** ADD STOP CHECK ***
                         if (check_stop_flag()) { calculation_ok = false; break; }
                         try {
-                            uint64 comb = calculate_combinations(len);
-                             if (total_passwords_target > (std::numeric_limits<uint64>::max)() - comb) {
+                            uint128 comb = calculate_combinations(len);
+                            if (!checked_add(total_passwords_target, comb, total_passwords_target)) {
                                 throw std::overflow_error("Overflow calculating total target password count.");
                             }
-                            total_passwords_target += comb;
                         } catch (const std::exception& e) {
                             update_output("ERROR: " + std::string(e.what()));
                             calculation_ok = false; break;
@@ -1183,62 +1899,52 @@ std::string brute_force_worker_combined(
                     }
                 }
 
-                if (check_stop_flag()) { /* Handled by break */ }
+                if (check_stop_flag()) { /* Stop requested, nothing to start */ }
                 else if (!calculation_ok) {
                     update_output("INFO: Calculation issue or stop detected during random mode setup.");
-                    // Will exit naturally as target_count might be 0 or RAM check will fail
+                    // Will exit naturally as target_count might be 0
                 }
                 else if (total_passwords_target == 0) {
                     update_output("WARN: Calculated total passwords in target range is zero.");
+                    apply_shard(0);
                 } else {
-                    update_output("INFO: Total passwords to test (lengths " + std::to_string(min_length) + " to " + std::to_string(max_length) + "): " + std::to_string(total_passwords_target));
-
-                    const uint64 MAX_REASONABLE_INDICES_RAM = (4ULL * 1024 * 1024 * 1024) / sizeof(uint64);
-                    if (total_passwords_target > MAX_REASONABLE_INDICES_RAM) {
-                        update_output("ERROR: Target password space too large for shuffled index mode RAM usage.");
-                        // Cannot proceed with random mode
-                    } else {
-                        update_output("INFO: Generating and shuffling target indices...");
-                        std::vector<uint64> indices(total_passwords_target);
-                        std::iota(indices.begin(), indices.end(), 0ULL);
-
-                        // *** ADD STOP CHECK *** before potentially long shuffle
-                        if (check_stop_flag()) { /* Skip shuffling and threads */ }
-                        else {
-                            uint64 seed_value;
-                            std::random_device rd;
-                            if (rd.entropy() > 0) { seed_value = static_cast<uint64>(rd()) << 32 | rd(); }
-                            else { seed_value = static_cast<uint64>(std::chrono::high_resolution_clock::now().time_since_epoch().count()); }
-                            std::mt19937_64 rng(seed_value);
-                            std::shuffle(indices.begin(), indices.end(), rng);
-                            update_output("INFO: Index vector generated and shuffled.");
-
-                             // *** ADD STOP CHECK *** after shuffling, before threads
-                            if (check_stop_flag()) { /* Skip threads */ }
-                            else {
-                                uint64 itemsPerThread = (total_passwords_target + numThreads - 1) / numThreads;
-                                if (itemsPerThread == 0) itemsPerThread = 1;
-
-                                std::vector<std::thread> threads;
-                                threads.reserve(numThreads);
-                                for (unsigned int t = 0; t < numThreads; ++t) {
-                                    if (check_stop_flag()) break; // Check before spawning each thread
-                                    uint64 startVecIdx = t * itemsPerThread;
-                                    uint64 endVecIdx = std::min(startVecIdx + itemsPerThread, total_passwords_target);
-                                    if (startVecIdx >= endVecIdx) break;
-
-                                    threads.emplace_back(shuffled_index_worker, startVecIdx, endVecIdx,
-                                                         std::cref(indices), total_passwords_prefix,
-                                                         std::cref(charset), max_length, std::cref(archivePath),
-                                                         std::ref(foundFlag), std::ref(foundPassword_internal), std::ref(foundMutex),
-                                                         filter, filterMutex, std::cref(stop_flag_path), std::ref(stop_requested));
-                                }
-                                update_output("INFO: Waiting for shuffled index worker threads...");
-                                for (auto &th : threads) { if (th.joinable()) th.join(); }
-                                update_output("INFO: Shuffled index worker threads joined.");
-                                checkpoint_filter_func(); // Checkpoint after joining
-                            }
+                    update_output("INFO: Total passwords to test (lengths " + std::to_string(min_length) + " to " + std::to_string(max_length) + "): " + to_string(total_passwords_target));
+                    apply_shard(total_passwords_target);
+                    if (!options.resume_from.empty()) {
+                        const int resume_len = static_cast<int>(options.resume_from.size());
+                        uint128 global_rank = 0;
+                        if (resume_len < min_length || resume_len > max_length || !getIndexByPassword(options.resume_from, charset, global_rank)) {
+                            resume_not_in_keyspace();
+                            return "";
+                        }
+                        if (!resume_random_counter(total_passwords_target, global_rank - total_passwords_prefix))
+                            return "";
+                    }
+
+                    // --- Keyed permutation of target indices (no index table, any space size) ---
+                    if (!prepare_random_phase(total_passwords_target, keyspace_job_description("random", min_length, max_length))) {
+                        update_output("INFO: Saved run state shows this random job was already completed.");
+                    }
+                    else {
+                        FeistelPermutation permutation(total_passwords_target, run_state.seed);
+                        update_output("INFO: Target indices will be visited in keyed pseudo-random order.");
+
+                        TaskGroup tasks;
+                        for (size_t t = 0; t < run_state.slices.size(); ++t) {
+                            if (check_stop_flag()) break; // Check before spawning each thread
+                            const SliceProgress &slice = run_state.slices[t];
+                            if (slice.next >= slice.end) continue;
+
+                            tasks.run(permuted_index_worker, slice.next, slice.end,
+                                                 std::cref(permutation), total_passwords_prefix,
+                                                 std::cref(charset), max_length, std::ref(ctx),
+                                                 std::ref(slice_progress[t]));
                         }
+                        update_output("INFO: Waiting for permuted index workers...");
+                        tasks.wait();
+                        update_output("INFO: Permuted index workers finished.");
+                        save_run_state();
+                        checkpoint_filter_func(); // Checkpoint after joining
                     }
                 }
             } // End Random Standard Mode
@@ -1247,6 +1953,7 @@ std::string brute_force_worker_combined(
     catch (const std::exception &e)
     {
         update_output("FATAL ERROR: " + std::string(e.what()));
+        save_run_state();
         // Attempt final save even on exception if filter is valid
         if (filter && filterMutex && !skipListFilePath.empty() && filter->isValid()) {
              update_output("INFO: Attempting final save of skip list state after error...");
@@ -1328,4 +2035,4 @@ std::string brute_force_worker_combined(
         update_output("INFO: Exhausted search space without finding password.");
         return ""; // Return empty string indicating not found
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
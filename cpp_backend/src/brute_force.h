@@ -1,15 +1,20 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <atomic>
 #include <mutex>
 #include <thread>
 #include <vector>
 #include <cstdint> // For uint64_t
-#include <map>
+#include <array>
+#include "pattern_syntax.h" // For kCustomCharsetSlots
+#include "password_constraints.h"
+#include "uint128.h"
 
 // Forward declaration for BloomFilter
 class BloomFilter;
+class ComponentList;
 
 // Enum to represent the cracking order/mode
 enum class CrackingMode {
@@ -18,6 +23,37 @@ enum class CrackingMode {
     RANDOM_LCG // Internally uses shuffled indices
 };
 
+// Optional run parameters beyond charset/lengths/mode (filled from CLI options in main.cpp)
+struct CrackOptions {
+    std::string pattern;          // --pattern: optional pattern for wildcard matching
+    std::string wordlist_path;    // --wordlist: dictionary attack over this file instead of a generated keyspace
+    std::string rules_path;       // --rules: mangling rules applied to every wordlist word
+    std::string combinator_path;  // --combinator: every wordlist word joined with every word of this list
+    std::string hybrid_mask;      // --hybrid-append / --hybrid-prepend: mask joined with every wordlist word
+    bool hybrid_prepend = false;  // Mask goes in front of the word (--hybrid-prepend)
+    std::string markov_path;      // --markov: model from `markov train`, brute force in descending probability
+    int markov_threshold = -1;    // --markov-threshold: highest level sum to enumerate (-1 = all)
+    std::string pcfg_path;        // --pcfg: grammar from `pcfg train`, guesses in descending probability
+    std::vector<std::string> typo_bases; // --typo (repeatable): guesses whose edit-distance neighbourhood is searched
+    int typo_distance = 1;        // --typo-distance: largest Damerau-Levenshtein distance from a base
+    bool typo_keyboard = false;   // --typo-keyboard: within one distance, QWERTY-adjacent slips first
+    bool common_passwords = false; // --common-passwords: built-in most common passwords before a length-range or pattern run
+    bool archive_tokens = false;  // --archive-tokens: guesses from the archive's file names, comment and dates, tested first
+    std::array<std::string, kCustomCharsetSlots> custom_charsets; // --custom-charset1..4 (expanded), used by ?1..?4
+    bool increment = false;       // --increment: star-free patterns also try their shorter prefixes
+    PasswordConstraints constraints; // --min-digits, --max-repeat, --forbid, ...: policy pruned during enumeration
+    bool has_seed = false;        // --seed given: random mode order is reproducible
+    uint64_t seed = 0;
+    uint128 start_index = 0;      // --start-index: first position of the run order to test
+    uint128 end_index = kUint128Max; // --end-index: positions from here on are not tested
+    std::string resume_from;      // --resume-from: start at this candidate's position instead
+    unsigned shard_index = 0;     // --shard i/N: this instance tests piece i of N of every phase
+    unsigned shard_count = 1;
+    std::string stop_flag_path;   // <skip-file>.stop, watched for graceful termination
+    std::string state_path;       // <skip-file>.state, resumable run state (empty = disabled)
+    uint128 *phase_domain = nullptr; // Receives the position count of the main phase (coordinator leases)
+};
+
 // Function to output status messages (defined in main.cpp)
 extern void update_output(const std::string& message);
 
@@ -31,43 +67,21 @@ std::string brute_force_worker_combined(
     BloomFilter* filter,
     std::mutex* filterMutex,
     int checkpointInterval,
-    const std::string& pattern = ""  // Optional pattern for wildcard matching
+    const CrackOptions& options
 );
 
-void generate_suffix_combinations(
-    const std::string& charset,
-    std::string& suffix,
-    size_t idx,
-    const std::string& current_pwd,
-    size_t segment_idx,
-    int pos,
-    int length,
-    const std::vector<std::string>& segments,
-    std::atomic<bool>& foundFlag,
-    std::string& foundPassword_out,
-    std::mutex& foundMutex,
-    BloomFilter* filter,
-    std::mutex* filterMutex,
-    const std::string& archivePath,
-    const std::string& stop_flag_path,
-    std::atomic<bool>& stop_requested);
+// Builds the second half of a combinator or hybrid attack (options.combinator_path or
+// options.hybrid_mask) for results of at most max_length characters. Returns false and sets
+// `error` if the list cannot be opened or the mask is invalid.
+bool open_combination_side(const CrackOptions& options, const std::string& charset, int max_length,
+                           ComponentList& out, std::string& error);
 
 // External variable for the 7z path (defined in main.cpp)
 extern std::string sevenZipPath;
 
 // Helper function to convert a GLOBAL index (starting from length 1) to a password string.
 // No change needed here, the caller (random mode) will adjust the index.
-bool getPasswordByIndex(uint64_t index, const std::string& charset, int max_length, std::string& out_password);
+bool getPasswordByIndex(uint128 index, const std::string& charset, int max_length, std::string& out_password);
 
-// --- NEW Declaration ---
-// Translates a global index (across all valid pattern lengths) to a password
-bool getPatternPasswordByGlobalIndex(
-    uint64_t global_pattern_index, // Index within the total pattern space
-    const std::vector<std::string>& segments,
-    const std::string& charset,
-    int min_len,
-    int max_len,
-    const std::map<int, uint64_t>& per_length_counts, // Pre-calculated counts per length
-    std::string& out_password
-);
-// --- END NEW ---
\ No newline at end of file
+// Inverse of getPasswordByIndex: GLOBAL index of `password`. Returns false if a character is not in the charset.
+bool getIndexByPassword(std::string_view password, const std::string& charset, uint128& out_index);
@@ -0,0 +1,153 @@
+#include "candidate_batch.h"
+#include <cstring> // For std::memcpy, std::memset
+
+CandidateBatch::CandidateBatch(size_t max_length, size_t capacity)
+    : m_capacity(capacity == 0 ? 1 : capacity), m_size(0)
+{
+    size_t chunks_per_slot = (max_length + kSlotAlignment - 1) / kSlotAlignment;
+    if (chunks_per_slot == 0)
+        chunks_per_slot = 1;
+    m_slot_width = chunks_per_slot * kSlotAlignment;
+    m_slots.resize(m_capacity * chunks_per_slot);
+    m_lengths.resize(m_capacity, 0);
+    m_ranks.resize(m_capacity, 0);
+}
+
+char *CandidateBatch::emplace(size_t length, uint128 rank)
+{
+    if (m_size == m_capacity || length > m_slot_width)
+        return nullptr;
+    char *bytes = slot(m_size);
+    // Keep the slot tail zeroed so fixed-width kernels can read whole slots
+    std::memset(bytes + length, 0, m_slot_width - length);
+    m_lengths[m_size] = static_cast<uint32_t>(length);
+    m_ranks[m_size] = rank;
+    ++m_size;
+    return bytes;
+}
+
+void CandidateBatch::resizeLast(size_t length)
+{
+    if (m_size == 0 || length > m_slot_width)
+        return;
+    const size_t last = m_size - 1;
+    if (length < m_lengths[last])
+        std::memset(slot(last) + length, 0, m_lengths[last] - length);
+    m_lengths[last] = static_cast<uint32_t>(length);
+}
+
+bool CandidateBatch::push(std::string_view candidate, uint128 rank)
+{
+    char *bytes = emplace(candidate.size(), rank);
+    if (!bytes)
+        return false;
+    std::memcpy(bytes, candidate.data(), candidate.size());
+    return true;
+}
+
+// UTF-8 to UTF-16 with the well-formed byte ranges of Unicode Table 3-7. The second byte's range
+// depends on the lead, which rules out overlong forms, surrogates and code points above U+10FFFF.
+static void decode_utf8_to_utf16(const unsigned char *p, const unsigned char *end, std::u16string &out)
+{
+    out.clear();
+    while (p < end)
+    {
+        const unsigned char lead = *p++;
+        if (lead < 0x80)
+        {
+            out.push_back(static_cast<char16_t>(lead));
+            continue;
+        }
+        uint32_t cp = 0;
+        int extra = 0;
+        unsigned char low = 0x80, high = 0xBF; // Allowed range of the second byte
+        if (lead >= 0xC2 && lead <= 0xDF) { cp = lead & 0x1F; extra = 1; }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            cp = lead & 0x0F;
+            extra = 2;
+            if (lead == 0xE0) low = 0xA0;  // Overlong below U+0800
+            if (lead == 0xED) high = 0x9F; // Surrogates U+D800..U+DFFF
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            cp = lead & 0x07;
+            extra = 3;
+            if (lead == 0xF0) low = 0x90;  // Overlong below U+10000
+            if (lead == 0xF4) high = 0x8F; // Above U+10FFFF
+        }
+        else
+        {
+            out.push_back(0xFFFD); // 0x80..0xC1 or 0xF5..0xFF cannot start a sequence
+            continue;
+        }
+        bool valid = true;
+        for (int k = 0; k < extra; ++k)
+        {
+            if (p == end || *p < low || *p > high)
+            {
+                valid = false; // The offending byte is not consumed; it starts the next sequence
+                break;
+            }
+            cp = (cp << 6) | (*p++ & 0x3F);
+            low = 0x80;
+            high = 0xBF;
+        }
+        if (!valid)
+        {
+            out.push_back(0xFFFD);
+        }
+        else if (cp >= 0x10000)
+        {
+            cp -= 0x10000;
+            out.push_back(static_cast<char16_t>(0xD800 + (cp >> 10)));
+            out.push_back(static_cast<char16_t>(0xDC00 + (cp & 0x3FF)));
+        }
+        else
+        {
+            out.push_back(static_cast<char16_t>(cp));
+        }
+    }
+}
+
+void CandidateBatch::utf16le(size_t i, std::u16string &out) const
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data(i));
+    decode_utf8_to_utf16(p, p + m_lengths[i], out);
+}
+
+bool CandidateBatch::utf16leSelfCheck()
+{
+    struct Sample
+    {
+        const char *utf8;
+        std::u16string utf16;
+    };
+    const Sample samples[] = {
+        {"a", u"a"},
+        {"\xC3\xA9", u"\u00E9"},
+        {"\xE2\x82\xAC", u"\u20AC"},
+        {"\xF0\x9F\x98\x80", u"\U0001F600"},                      // Surrogate pair D83D DE00
+        {"\xC0\xAF", u"\uFFFD\uFFFD"},                             // 0xC0 lead, stray continuation
+        {"\xC1\xBF", u"\uFFFD\uFFFD"},
+        {"\xE0\x80\xAF", u"\uFFFD\uFFFD\uFFFD"},                   // Overlong 3-byte '/'
+        {"\xF0\x80\x80\xAF", u"\uFFFD\uFFFD\uFFFD\uFFFD"},         // Overlong 4-byte '/'
+        {"\xED\xA0\x80", u"\uFFFD\uFFFD\uFFFD"},                   // Encoded surrogate U+D800
+        {"\xF4\x90\x80\x80", u"\uFFFD\uFFFD\uFFFD\uFFFD"},         // U+110000
+        {"\xF5\x80", u"\uFFFD\uFFFD"},
+        {"\xFF" "a", u"\uFFFD" "a"},
+        {"\xE2\x82", u"\uFFFD"},                                   // Truncated at the end
+        {"\xE2\x82" "A", u"\uFFFD" "A"},                           // Truncated before ASCII
+    };
+    CandidateBatch batch(8, 1);
+    std::u16string out;
+    for (const Sample &sample : samples)
+    {
+        batch.clear();
+        batch.push(sample.utf8, 0);
+        batch.utf16le(0, out);
+        if (out != sample.utf16)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef> // For size_t
+#include <cstdint> // For uint64_t, uint32_t
+#include "uint128.h"
+
+// Fixed-capacity, structure-of-arrays block of password candidates.
+// This is the unit generators fill and filters/verifiers consume: candidate bytes live in one
+// contiguous buffer of fixed-width, cache-line aligned slots (zero padded past each length),
+// with lengths and ranks kept in parallel arrays. No per-candidate heap allocation is needed
+// to move a candidate from a generator to the skip filter and the verifier.
+class CandidateBatch {
+public:
+    static constexpr size_t kDefaultCapacity = 256;
+    static constexpr size_t kSlotAlignment = 64; // Slot width is rounded up to a multiple of this
+
+    // max_length: longest candidate the batch has to hold (determines the slot width)
+    explicit CandidateBatch(size_t max_length, size_t capacity = kDefaultCapacity);
+
+    // Appends a copy of `candidate`. Returns false if the batch is full or the candidate is too long.
+    bool push(std::string_view candidate, uint128 rank);
+
+    // Reserves the next slot for in-place writing and returns a pointer to its bytes,
+    // or nullptr if the batch is full or `length` exceeds the slot width.
+    char* emplace(size_t length, uint128 rank);
+
+    // Sets the length of the last candidate after it was written in place (at most the slot width).
+    void resizeLast(size_t length);
+
+    // Drops the last candidate, e.g. when an in-place transform rejected it.
+    void popBack() { if (m_size > 0) --m_size; }
+
+    void clear() { m_size = 0; }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    size_t slotWidth() const { return m_slot_width; }
+    bool empty() const { return m_size == 0; }
+    bool full() const { return m_size == m_capacity; }
+
+    // Accessors for candidate i (i < size())
+    std::string_view view(size_t i) const { return std::string_view(data(i), m_lengths[i]); }
+    const char* data(size_t i) const { return reinterpret_cast<const char*>(m_slots.data()) + i * m_slot_width; }
+    uint32_t length(size_t i) const { return m_lengths[i]; }
+    uint128 rank(size_t i) const { return m_ranks[i]; }
+
+    // UTF-16LE code units of candidate i (decoded from UTF-8), built on demand.
+    // 7-Zip's AES key derivation hashes the password in this encoding.
+    // Every maximal invalid subsequence (bad lead byte, overlong form, surrogate,
+    // above U+10FFFF, truncated) becomes one U+FFFD.
+    void utf16le(size_t i, std::u16string& out) const;
+
+    // Decodes fixed UTF-8 samples, valid and invalid, against their expected UTF-16LE
+    static bool utf16leSelfCheck();
+
+private:
+    struct alignas(kSlotAlignment) SlotChunk {
+        char bytes[kSlotAlignment];
+    };
+
+    char* slot(size_t i) { return reinterpret_cast<char*>(m_slots.data()) + i * m_slot_width; }
+
+    size_t m_capacity;
+    size_t m_slot_width;
+    size_t m_size;
+    std::vector<SlotChunk> m_slots;   // capacity * slot width bytes, one aligned block
+    std::vector<uint32_t> m_lengths;  // Candidate lengths in bytes
+    std::vector<uint128> m_ranks;     // Generator rank of each candidate
+};
@@ -0,0 +1,197 @@
+#include "candidate_generator.h"
+#include "candidate_batch.h"
+#include "pattern_automaton.h"
+
+OdometerGenerator::OdometerGenerator(const std::string &charset, int length)
+    : m_sets(1, charset)
+{
+    if (length < 0)
+        length = 0;
+    m_buffer.assign(length, charset.empty() ? '\0' : charset[0]);
+    m_positions.resize(length);
+    for (int i = 0; i < length; ++i)
+        m_positions[i] = i;
+    m_digit_sets.assign(length, 0);
+    m_digits.assign(length, 0);
+}
+
+OdometerGenerator::OdometerGenerator(const std::string &charset, const std::string &templ, const std::vector<int> &wildcard_positions)
+    : OdometerGenerator(std::vector<std::string>(1, charset), templ, wildcard_positions, std::vector<int>(wildcard_positions.size(), 0))
+{
+}
+
+OdometerGenerator::OdometerGenerator(const std::vector<std::string> &sets, const std::string &templ, const std::vector<int> &wildcard_positions,
+                                     const std::vector<int> &wildcard_sets)
+    : m_sets(sets), m_buffer(templ), m_positions(wildcard_positions), m_digits(wildcard_positions.size(), 0)
+{
+    m_digit_sets.reserve(wildcard_sets.size());
+    for (int set : wildcard_sets)
+        m_digit_sets.push_back(static_cast<uint32_t>(set));
+    for (size_t i = 0; i < m_positions.size(); ++i)
+    {
+        const std::string &set = m_sets[m_digit_sets[i]];
+        if (!set.empty())
+            m_buffer[m_positions[i]] = set[0];
+    }
+}
+
+bool OdometerGenerator::seek(uint128 index)
+{
+    m_exhausted = true;
+    size_t i = m_positions.size();
+    // Rightmost digits first: 128-bit division only while the remaining index needs it
+    for (; i > 0 && !fits_u64(index); --i)
+    {
+        const std::string &set = m_sets[m_digit_sets[i - 1]];
+        if (set.empty())
+            return false;
+        uint32_t digit = static_cast<uint32_t>(index % set.size());
+        index /= set.size();
+        m_digits[i - 1] = digit;
+        m_buffer[m_positions[i - 1]] = set[digit];
+    }
+    if (!fits_u64(index))
+        return false;
+    uint64_t current = static_cast<uint64_t>(index);
+    for (; i-- > 0;)
+    {
+        const std::string &set = m_sets[m_digit_sets[i]];
+        uint64_t radix = static_cast<uint64_t>(set.size());
+        if (radix == 0)
+            return false;
+        uint32_t digit = static_cast<uint32_t>(current % radix);
+        current /= radix;
+        m_digits[i] = digit;
+        m_buffer[m_positions[i]] = set[digit];
+    }
+    // Anything left over means the index did not fit into this length's keyspace
+    m_exhausted = (current != 0);
+    return !m_exhausted;
+}
+
+bool OdometerGenerator::next()
+{
+    for (size_t i = m_positions.size(); i-- > 0;)
+    {
+        const std::string &set = m_sets[m_digit_sets[i]];
+        uint32_t digit = m_digits[i] + 1;
+        if (digit < set.size())
+        {
+            m_digits[i] = digit;
+            m_buffer[m_positions[i]] = set[digit];
+            return true;
+        }
+        // Carry: reset this digit and move one position to the left
+        m_digits[i] = 0;
+        m_buffer[m_positions[i]] = set[0];
+    }
+    return false;
+}
+
+size_t OdometerGenerator::fill(CandidateBatch &batch, uint128 first_rank, uint128 max_count)
+{
+    size_t appended = 0;
+    while (appended < max_count && !m_exhausted && !batch.full())
+    {
+        if (!batch.push(m_buffer, first_rank + appended))
+            break;
+        ++appended;
+        if (!next())
+            m_exhausted = true;
+    }
+    return appended;
+}
+
+AutomatonGenerator::AutomatonGenerator(const PatternAutomaton &automaton, int length)
+    : m_automaton(automaton)
+{
+    if (length < 0)
+        length = 0;
+    m_buffer.assign(length, '\0');
+    m_states.assign(length + 1, PatternAutomaton::kDead);
+    m_symbols.assign(length, 0);
+    m_states[0] = m_automaton.start();
+    m_exhausted = !complete_from(0);
+}
+
+bool AutomatonGenerator::complete_from(size_t pos)
+{
+    const size_t symbols = m_automaton.alphabet().size();
+    const int length = static_cast<int>(m_buffer.size());
+    for (size_t i = pos; i < m_buffer.size(); ++i)
+    {
+        const int remaining = length - static_cast<int>(i) - 1;
+        size_t a = 0;
+        while (a < symbols && m_automaton.completions(m_automaton.transition(m_states[i], a), remaining) == 0)
+            ++a;
+        if (a == symbols)
+            return false;
+        m_symbols[i] = static_cast<uint32_t>(a);
+        m_buffer[i] = m_automaton.alphabet()[a];
+        m_states[i + 1] = m_automaton.transition(m_states[i], a);
+    }
+    return m_automaton.completions(m_states[0], length) > 0;
+}
+
+bool AutomatonGenerator::seek(uint128 index)
+{
+    const size_t symbols = m_automaton.alphabet().size();
+    const int length = static_cast<int>(m_buffer.size());
+    m_exhausted = true;
+    if (index >= m_automaton.completions(m_states[0], length))
+        return false;
+    for (size_t i = 0; i < m_buffer.size(); ++i)
+    {
+        const int remaining = length - static_cast<int>(i) - 1;
+        size_t a = 0;
+        for (; a < symbols; ++a)
+        {
+            uint128 ways = m_automaton.completions(m_automaton.transition(m_states[i], a), remaining);
+            if (index < ways)
+                break;
+            index -= ways;
+        }
+        if (a == symbols)
+            return false;
+        m_symbols[i] = static_cast<uint32_t>(a);
+        m_buffer[i] = m_automaton.alphabet()[a];
+        m_states[i + 1] = m_automaton.transition(m_states[i], a);
+    }
+    m_exhausted = false;
+    return true;
+}
+
+bool AutomatonGenerator::next()
+{
+    const size_t symbols = m_automaton.alphabet().size();
+    const int length = static_cast<int>(m_buffer.size());
+    for (size_t i = m_buffer.size(); i-- > 0;)
+    {
+        const int remaining = length - static_cast<int>(i) - 1;
+        for (size_t a = m_symbols[i] + 1; a < symbols; ++a)
+        {
+            int32_t t = m_automaton.transition(m_states[i], a);
+            if (m_automaton.completions(t, remaining) == 0)
+                continue;
+            m_symbols[i] = static_cast<uint32_t>(a);
+            m_buffer[i] = m_automaton.alphabet()[a];
+            m_states[i + 1] = t;
+            return complete_from(i + 1);
+        }
+    }
+    return false;
+}
+
+size_t AutomatonGenerator::fill(CandidateBatch &batch, uint128 first_rank, uint128 max_count)
+{
+    size_t appended = 0;
+    while (appended < max_count && !m_exhausted && !batch.full())
+    {
+        if (!batch.push(m_buffer, first_rank + appended))
+            break;
+        ++appended;
+        if (!next())
+            m_exhausted = true;
+    }
+    return appended;
+}
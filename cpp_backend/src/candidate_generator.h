@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint> // For uint64_t, uint32_t
+#include <cstddef> // For size_t
+#include "uint128.h"
+
+class CandidateBatch;
+class PatternAutomaton;
+
+// Fixed-length candidate generator ("odometer").
+// The start index is unranked once with div/mod, after which every call to next()
+// increments the rightmost wildcard digit in place and propagates the carry leftwards.
+// Steady state is O(1) amortized per candidate with no division and no allocation.
+// Ordering matches getPasswordByIndex: the last wildcard position changes fastest.
+class OdometerGenerator {
+public:
+    // Plain brute force: every position of a `length`-character password is a wildcard.
+    OdometerGenerator(const std::string& charset, int length);
+
+    // Pattern layout: literal characters are taken from `templ`, the listed positions are wildcards.
+    OdometerGenerator(const std::string& charset, const std::string& templ, const std::vector<int>& wildcard_positions);
+
+    // Mask layout: wildcard i enumerates sets[wildcard_sets[i]] (mixed radix).
+    OdometerGenerator(const std::vector<std::string>& sets, const std::string& templ, const std::vector<int>& wildcard_positions,
+                      const std::vector<int>& wildcard_sets);
+
+    // Unranks `index` (local to this length) into the buffer. Returns false if out of range.
+    // Digit weights are mixed radix: each wildcard counts in the size of its own set.
+    // 128-bit division is only used for the leading digits while the index exceeds 64 bits.
+    bool seek(uint128 index);
+
+    // Advances to the next candidate. Returns false when the odometer wraps past the last one.
+    bool next();
+
+    // Appends up to `max_count` candidates, starting with the current one, ranked from `first_rank`.
+    // Leaves the generator on the first candidate not emitted. Returns the number appended.
+    size_t fill(CandidateBatch& batch, uint128 first_rank, uint128 max_count);
+
+    // Current candidate; the reference stays valid for the generator's lifetime.
+    const std::string& current() const { return m_buffer; }
+
+    size_t numWildcards() const { return m_positions.size(); }
+
+    // True once next() has wrapped past the last candidate (or seek() was out of range).
+    bool exhausted() const { return m_exhausted; }
+
+private:
+    std::vector<std::string> m_sets;  // Character sets the digits draw from
+    std::string m_buffer;             // Candidate being built in place
+    std::vector<int> m_positions;     // Buffer offsets of the wildcard digits, left to right
+    std::vector<uint32_t> m_digit_sets; // Index into m_sets for each wildcard digit
+    std::vector<uint32_t> m_digits;   // Current charset index for each wildcard digit
+    bool m_exhausted = false;         // Set once next() has wrapped around
+};
+
+// Duplicate-free generator for multi-star patterns, driven by a PatternAutomaton.
+// Walks the passwords of one length in lexicographic alphabet order. next() keeps the automaton
+// state reached after every prefix, so advancing only revisits the changed suffix: it bumps the
+// rightmost position that still has a symbol with accepted completions and refills the tail
+// with the smallest viable symbols.
+class AutomatonGenerator {
+public:
+    // The automaton must outlive the generator and have been built for at least `length`.
+    AutomatonGenerator(const PatternAutomaton& automaton, int length);
+
+    // Unranks `index` (local to this length). Returns false if out of range.
+    bool seek(uint128 index);
+
+    // Advances to the next candidate. Returns false after the last one.
+    bool next();
+
+    // Same contract as OdometerGenerator::fill.
+    size_t fill(CandidateBatch& batch, uint128 first_rank, uint128 max_count);
+
+    const std::string& current() const { return m_buffer; }
+    bool exhausted() const { return m_exhausted; }
+
+private:
+    // Fills positions from `pos` on with the smallest symbols that still lead to acceptance
+    bool complete_from(size_t pos);
+
+    const PatternAutomaton& m_automaton;
+    std::string m_buffer;
+    std::vector<int32_t> m_states;    // m_states[i] = automaton state before position i
+    std::vector<uint32_t> m_symbols;  // Alphabet index chosen at each position
+    bool m_exhausted = false;
+};
@@ -0,0 +1,114 @@
+#include "combinator.h"
+#include "candidate_batch.h"
+#include <algorithm> // For std::max
+#include <cstring>   // For std::memcpy
+
+bool ComponentList::openWordlist(const std::string &path, int max_length, std::string &error)
+{
+    const int longest = std::max(1, max_length);
+    if (CompiledWordlist::isCompiled(path))
+    {
+        if (!m_compiled.open(path, error))
+            return false;
+        // Buckets are ascending by length, so the usable words are one rank range
+        uint64_t end_rank = 0;
+        m_compiled.rankRange(1, longest, m_first_rank, end_rank);
+        m_kind = Kind::Compiled;
+        m_size = end_rank - m_first_rank;
+        m_max_length = static_cast<size_t>(std::max(0, m_compiled.maxLength(m_first_rank, end_rank)));
+        return true;
+    }
+
+    if (!m_text.open(path, error))
+        return false;
+    // One pass builds the line index; the views point into the mapping
+    WordlistReader reader(m_text, 0, m_text.size(), 1, longest);
+    std::string_view word;
+    uint64_t offset = 0;
+    while (reader.next(word, offset))
+    {
+        m_words.push_back(word);
+        m_max_length = std::max(m_max_length, word.size());
+    }
+    m_kind = Kind::Text;
+    m_size = m_words.size();
+    return true;
+}
+
+bool ComponentList::compileMask(const ParsedPattern &mask, int max_length, bool increment, std::string &error)
+{
+    const int min_length = increment ? 1 : mask.fixedLength();
+    const int longest = mask.numStars() > 0 ? std::max(min_length, max_length) : mask.maxFixedLength();
+    if (!m_plan.compile(mask, min_length, longest, increment))
+    {
+        error = m_plan.error();
+        return false;
+    }
+    if (!m_plan.total().has_value())
+    {
+        error = "Mask keyspace does not fit into 64 bits.";
+        return false;
+    }
+    m_kind = Kind::Mask;
+    m_size = *m_plan.total();
+    m_max_length = static_cast<size_t>(m_plan.maxLength());
+    return true;
+}
+
+std::string_view ComponentList::get(uint64_t index, std::string &scratch) const
+{
+    switch (m_kind)
+    {
+    case Kind::Text:
+        return m_words[static_cast<size_t>(index)];
+    case Kind::Compiled:
+        return m_compiled.word(m_first_rank + index);
+    case Kind::Mask:
+        if (!m_plan.unrankGlobal(index, scratch))
+            scratch.clear();
+        return scratch;
+    default:
+        return std::string_view();
+    }
+}
+
+CombinationExpander::CombinationExpander(const ComponentList &list, bool prepend, int min_length, int max_length)
+    : m_list(list), m_prepend(prepend), m_min_length(min_length < 0 ? 0 : static_cast<size_t>(min_length)),
+      m_max_length(max_length < 0 ? 0 : static_cast<size_t>(max_length)), m_next(list.size())
+{
+}
+
+void CombinationExpander::setWord(std::string_view word, uint64_t word_index, size_t first_element)
+{
+    m_word.assign(word.data(), word.size());
+    m_word_index = word_index;
+    m_next = first_element;
+}
+
+size_t CombinationExpander::fill(CandidateBatch &batch)
+{
+    size_t appended = 0;
+    while (!done() && !batch.full())
+    {
+        const uint64_t element = m_next++;
+        std::string_view part = m_list.get(element, m_scratch);
+        const size_t length = m_word.size() + part.size();
+        if (length < m_min_length || length > m_max_length)
+        {
+            ++m_dropped;
+            continue;
+        }
+        char *slot = batch.emplace(length, m_word_index * m_list.size() + element);
+        if (!slot)
+        {
+            --m_next; // Slot width too small: cannot happen with a max_length batch
+            break;
+        }
+        const std::string_view first = m_prepend ? part : std::string_view(m_word);
+        const std::string_view second = m_prepend ? std::string_view(m_word) : part;
+        std::memcpy(slot, first.data(), first.size());
+        std::memcpy(slot + first.size(), second.data(), second.size());
+        ++appended;
+    }
+    return appended;
+}
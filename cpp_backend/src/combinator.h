@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint> // For uint64_t
+#include <cstddef> // For size_t
+#include "wordlist.h"
+#include "compiled_wordlist.h"
+#include "pattern_plan.h"
+
+class CandidateBatch;
+
+// Indexed right-hand side of a combinator attack (second wordlist) or the mask of a hybrid attack.
+// Element j is a wordlist line (text lists are indexed once into views of the mapping, compiled
+// lists are addressed by rank) or the mask candidate with global rank j.
+class ComponentList {
+public:
+    // Maps a text or compiled wordlist; words longer than `max_length` are left out
+    bool openWordlist(const std::string& path, int max_length, std::string& error);
+
+    // Compiles a mask in pattern syntax (?l ?u ?d ?s ?a, ?1-?4, groups, ...); with `increment`
+    // every prefix of a star-free mask is included as well
+    bool compileMask(const ParsedPattern& mask, int max_length, bool increment, std::string& error);
+
+    uint64_t size() const { return m_size; }
+    size_t maxLength() const { return m_max_length; }
+
+    // Element `index` (< size()); `scratch` backs the view for masks
+    std::string_view get(uint64_t index, std::string& scratch) const;
+
+private:
+    enum class Kind { None, Text, Compiled, Mask };
+
+    Kind m_kind = Kind::None;
+    Wordlist m_text;
+    std::vector<std::string_view> m_words; // Text lists only
+    CompiledWordlist m_compiled;
+    uint64_t m_first_rank = 0;             // Compiled lists only
+    PatternPlan m_plan;                    // Masks only
+    uint64_t m_size = 0;
+    size_t m_max_length = 0;
+};
+
+// Joins one word at a time with every element of a ComponentList (word + element, or element +
+// word with `prepend`), straight into candidate batch slots. The rank of a candidate is
+// word_index * list.size() + element, so a run can resume inside a word.
+// Results outside [min_length, max_length] are dropped.
+class CombinationExpander {
+public:
+    CombinationExpander(const ComponentList& list, bool prepend, int min_length, int max_length);
+
+    // Starts on `word`, beginning with element `first_element`
+    void setWord(std::string_view word, uint64_t word_index, size_t first_element = 0);
+
+    // Appends results for the current word until the batch is full or every element was used.
+    // The batch slot width must be at least max_length. Returns the number appended.
+    size_t fill(CandidateBatch& batch);
+
+    // True once the current word was joined with every element (also before the first setWord)
+    bool done() const { return m_next >= m_list.size(); }
+
+    // Rank of the first (word, element) pair not joined yet
+    uint64_t position() const { return m_word_index * m_list.size() + m_next; }
+
+    // Results dropped so far because of their length
+    uint64_t dropped() const { return m_dropped; }
+
+private:
+    const ComponentList& m_list;
+    bool m_prepend;
+    size_t m_min_length;
+    size_t m_max_length;
+    std::string m_word;
+    std::string m_scratch;
+    uint64_t m_word_index = 0;
+    uint64_t m_next;
+    uint64_t m_dropped = 0;
+};
@@ -0,0 +1,91 @@
+#include "common_passwords.h"
+
+// Newline-terminated words, most common first. Front coding or similar schemes save almost
+// nothing here (neighbours in popularity order rarely share a prefix), so the blob is plain.
+static constexpr char kCommonPasswords[] =
+    "123456\npassword\n12345678\nqwerty\n123456789\n12345\n1234\n111111\n1234567\ndragon\n123123\nbaseball\n"
+    "abc123\nfootball\nmonkey\nletmein\n696969\nshadow\nmaster\n666666\nqwertyuiop\n123321\nmustang\n"
+    "1234567890\nmichael\n654321\nsuperman\n1qaz2wsx\n7777777\n121212\n000000\nqazwsx\n123qwe\nkiller\n"
+    "trustno1\njordan\njennifer\nzxcvbnm\nasdfgh\nhunter\nbuster\nsoccer\nharley\nbatman\nandrew\ntigger\n"
+    "sunshine\niloveyou\n2000\ncharlie\nrobert\nthomas\nhockey\nranger\ndaniel\nstarwars\nklaster\n112233\n"
+    "george\ncomputer\nmichelle\njessica\npepper\n1111\nzxcvbn\n555555\n11111111\n131313\nfreedom\n777777\n"
+    "pass\nmaggie\n159753\naaaaaa\nginger\nprincess\njoshua\ncheese\namanda\nsummer\nlove\nashley\nnicole\n"
+    "chelsea\nbiteme\nmatthew\naccess\nyankees\n987654321\ndallas\naustin\nthunder\ntaylor\nmatrix\n"
+    "password1\nqwerty123\n1q2w3e4r\n1q2w3e\nqwe123\nadmin\nroot\ntest\nguest\npassw0rd\np@ssw0rd\nPassword\n"
+    "Password1\nPassword123\npassword123\nwelcome\nwelcome1\nabc12345\nchangeme\ndefault\nzaq12wsx\nletmein1\n"
+    "aa123456\na123456\n123456789a\nqwerty1\n1234qwer\nAa123456\nasd123\nzaq1xsw2\nqwertyu\n1q2w3e4r5t\n"
+    "123456a\n12345a\n1qazxsw2\nq1w2e3r4\niloveyou1\nprincess1\nsunshine1\nmonkey1\nfootball1\nbaseball1\n"
+    "superman1\ndragon1\nmaster1\nshadow1\nmichael1\ncharlie1\njordan23\n000000000\n1234561\n12341234\n"
+    "123654\n123456789012\n12345678910\n0123456789\n0123456\n987654\n999999\n888888\n222222\n333333\n444444\n"
+    "55555\n54321\n11111\n00000\n1111111\n123\nabcdef\nabcd1234\nasdfghjkl\nasdf1234\nzxcvbnm1\nqweasd\n"
+    "qweasdzxc\nrockyou\nbabygirl\nlovely\niloveu\nchocolate\nanthony\nfriends\nbutterfly\npurple\nangel\n"
+    "liverpool\njustin\nloveme\nsecret\nandrea\ncarlos\nbubbles\nhannah\nloveyou\npretty\nbasketball\nangels\n"
+    "tweety\nflower\nplayboy\nhello\nelizabeth\nhottie\ntinkerbell\nsamantha\nbarbie\nlovers\nteamo\njasmine\n"
+    "brandon\nmelissa\neminem\ndanielle\nforever\nfamily\njonathan\nwhatever\nvanessa\ncookie\nnaruto\n"
+    "sweety\nspongebob\njoseph\njunior\nsoftball\nyellow\ndaniela\nlauren\nmickey\nprincesa\nalexandra\n"
+    "alexis\njesus\nestrella\nmiguel\nwilliam\nbeautiful\nmylove\nangela\npoohbear\npatrick\niloveme\nsakura\n"
+    "adrian\nalexander\ndestiny\nchristian\nsayang\namerica\ndancer\nmonica\nrichard\ndiamond\ncarolina\n"
+    "steven\nrangers\nlouise\norange\n789456\nshorty\nnathan\nsnoopy\ngabriel\ncherry\nsandra\nalejandro\n"
+    "brittany\nalejandra\npatricia\nrachel\ntequiero\narsenal\ndolphin\nantonio\nheather\ndavid\nstephanie\n"
+    "peanut\nblink182\nsweetie\nbeauty\nvictoria\nhoney\nfernando\npokemon\ncorazon\nchicken\ncristina\n"
+    "rainbow\nkisses\nmanuel\nmyspace\nrebelde\nangel1\nricardo\nbabygurl\nheaven\nmartin\ngreenday\n"
+    "november\nalyssa\nmadison\nmother\n123abc\nmahalkita\nseptember\ndecember\nmorgan\nmariposa\nmaria\n"
+    "gabriela\niloveyou2\nbailey\njeremy\npamela\nkimberly\ngemini\nshannon\npictures\nsophie\njessie\n"
+    "hellokitty\nclaudia\nbabygirl1\nangelica\nmahalko\nvictor\nhorses\ntiffany\nmariana\neduardo\nandres\n"
+    "courtney\nbooboo\nkissme\nronaldo\nprecious\noctober\ninuyasha\npeaches\nveronica\nchris\nadriana\n"
+    "cutie\njames\nbanana\nprince\nfriend\njesus1\ncrystal\nceltic\nedward\noliver\ndiana\nsamsung\nangelo\n"
+    "kenneth\nscooby\ncarmen\n456789\nsebastian\nrebecca\njackie\nspiderman\nchristopher\nkarina\njohnny\n"
+    "hotmail\nschool\nbarcelona\naugust\norlando\nsamuel\ncameron\nslipknot\ncutiepie\n50cent\nbonita\nkevin\n"
+    "maganda\nbabyboy\ncasper\nbrenda\nadidas\nkitten\nkaren\nisabel\nnatalie\ncuteako\njavier\n789456123\n"
+    "sarah\nbowwow\nportugal\nlaura\nmarvin\ndenise\ntigers\nvolleyball\njasper\nrockstar\njanuary\nalicia\n"
+    "nicholas\nflowers\ncristian\ntintin\nbianca\nchrisbrown\nchester\n101010\nsmokey\nsilver\ninternet\n"
+    "sweet\nstrawberry\ngarfield\ndennis\npanget\nfrancis\ncassie\nbenfica\nlove123\nlollipop\nolivia\n"
+    "cancer\ncamila\nsuperstar\nharrypotter\nihateyou\ncharles\nmonique\nmidnight\nvincent\nchristine\n"
+    "apples\nscorpio\nlorena\nandreea\nmercedes\nkatherine\ncharmed\nabigail\nrafael\nicecream\nmexico\n"
+    "brianna\nnirvana\naaliyah\npookie\njohncena\nlovelove\nbenjamin\ngangsta\nbrooke\nhiphop\nmybaby\n"
+    "sergio\nmetallica\njulian\ntravis\nmyspace1\nbabyblue\nsabrina\njeffrey\nstephen\ndakota\ncatherine\n"
+    "badboy\nfernanda\nwestlife\nblondie\nsasuke\nsmiley\njackson\nsimple\nmelanie\nsteaua\ndolphins\n"
+    "roberto\nfluffy\nteresa\npiglet\nronald\nminnie\nnewyork\njason\nraymond\nsantiago\njayson\n88888888\n"
+    "5201314\njerome\nmuffin\ngatita\nbabyko\n246810\nsweetheart\nchivas\nladybug\nkitty\npopcorn\nalberto\n"
+    "valeria\ncookies\nleslie\njenny\nnicole1\nleonardo\njayjay\nliliana\ndexter\n232323\namores\nrockon\n"
+    "christ\nbabydoll\nanthony1\nmarcus\nfatima\nmiamor\nlover\nchris1\nsingle\neeyore\nlalala\n252525\n"
+    "scooter\nnatasha\nskittles\nbrooklyn\ncolombia\n159357\nteddybear\nwinnie\nhappy\nmanutd\nbritney\n"
+    "katrina\nchristina\npasaway\ncocacola\nmahal\ngrace\nlinda\nalbert\ntatiana\nlondon\ncantik\nlakers\n"
+    "marie\nteiubesc\n147258369\ncharlotte\nnatalia\nfrancisco\namorcito\nsmile\npaola\nangelito\nmanchester\n"
+    "hahaha\nelephant\nmommy1\nshelby\n147258\nkelsey\ngenesis\namigos\nsnickers\nxavier\nturtle\nmarlon\n"
+    "linkinpark\nclaire\nstupid\n147852\nmarina\ngarcia\ndiego\nbrandy\nsharon\nbonnie\nspider\niverson\n"
+    "andrei\njustine\nfrankie\npimpin\ndisney\nrabbit\nfashion\nsoccer1\nred123\nbestfriend\nengland\n"
+    "hermosa\n456123\nbandit\ndanny\nallison\nemily\n102030\nlucky1\nsporting\nmiranda\nhearts\ncamille\n"
+    "wilson\npotter\npumpkin\niloveu2\nnumber1\nkatie\nguitar\n212121\ntruelove\njayden\nsavannah\nhottie1\n"
+    "phoenix\nmonster\nplayer\nganda\npeople\nscotland\nnelson\njasmin\ntimothy\nonelove\nilovehim\nshakira\n"
+    "estrellita\nbubble\nsmiles\nbrandon1\nsparky\nbarney\nsweets\nparola\nevelyn\nfamilia\nlove12\nnikki\n"
+    "motorola\nflorida\nomarion\nmonkeys\nloverboy\nelijah\njoanna\ncanada\nronnie\nmamita\nemmanuel\n"
+    "999999999\nbroken\nrodrigo\nmaryjane\nwestside\ncalifornia\nlucky\nmauricio\njamaica\njustin1\namigas\n"
+    "preciosa\nshopping\nflores\nmariah\nisabella\ntennis\ntrinity\njorge\nsunflower\nkathleen\nbradley\n"
+    "cupcake\nhector\nmartinez\nelaine\nrobbie\nfriendship\nengland1\nstars\ntaurus\n";
+
+static constexpr size_t count_words(const char *blob)
+{
+    size_t count = 0;
+    for (; *blob; ++blob)
+        count += (*blob == '\n');
+    return count;
+}
+
+static constexpr size_t kCommonPasswordCount = count_words(kCommonPasswords);
+
+size_t common_password_count()
+{
+    return kCommonPasswordCount;
+}
+
+std::vector<std::string_view> common_passwords()
+{
+    std::vector<std::string_view> words;
+    words.reserve(kCommonPasswordCount);
+    const std::string_view blob(kCommonPasswords, sizeof(kCommonPasswords) - 1);
+    size_t begin = 0;
+    for (size_t end = blob.find('\n'); end != std::string_view::npos; begin = end + 1, end = blob.find('\n', begin))
+        words.push_back(blob.substr(begin, end - begin));
+    return words;
+}
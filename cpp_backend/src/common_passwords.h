@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstddef> // For size_t
+
+// Most common passwords of public leak rankings (RockYou, yearly "worst passwords" lists),
+// compiled into the binary as one constexpr blob in popularity order. Used by --common-passwords
+// to test the likeliest guesses before a length-range or pattern run starts.
+
+// Number of embedded passwords
+size_t common_password_count();
+
+// The embedded passwords, most common first (views into static storage)
+std::vector<std::string_view> common_passwords();
@@ -0,0 +1,564 @@
+#include "compiled_wordlist.h"
+#include "candidate_batch.h"
+#include <algorithm> // For std::sort, std::upper_bound, std::min, std::find_if
+#include <cstdio>    // For FILE, std::remove
+#include <cstring>   // For std::memcmp, std::memcpy
+#include <fstream>
+#include <numeric>   // For std::iota
+#include <queue>
+
+extern void update_output(const std::string &message); // Defined in main.cpp
+
+static const char kMagic[8] = {'A', 'P', 'C', 'W', 'O', 'R', 'D', 'S'};
+static const uint32_t kVersion = 1;
+static const size_t kHeaderSize = 32;
+static const size_t kBucketEntrySize = 24;
+static const size_t kMaxWordLength = 255; // Longer lines are skipped when compiling
+
+// --- Little-endian field access ---
+static uint32_t read_u32(const char *p)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i)
+        value = (value << 8) | static_cast<unsigned char>(p[i]);
+    return value;
+}
+
+static uint64_t read_u64(const char *p)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | static_cast<unsigned char>(p[i]);
+    return value;
+}
+
+static void put_u32(std::string &out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+static void put_u64(std::string &out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+// 64-bit safe absolute seek
+static bool seek_to(FILE *file, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+bool CompiledWordlist::isCompiled(const std::string &path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    return ifs.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool CompiledWordlist::open(const std::string &path, std::string &error)
+{
+    m_buckets.clear();
+    m_total = 0;
+    m_flags = 0;
+    if (!m_file.open(path, error))
+        return false;
+    const char *data = m_file.data();
+    const uint64_t size = m_file.size();
+    if (size < kHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0)
+    {
+        error = "Not a compiled wordlist: " + path;
+        return false;
+    }
+    if (read_u32(data + 8) != kVersion)
+    {
+        error = "Unsupported compiled wordlist version in: " + path;
+        return false;
+    }
+    m_flags = read_u32(data + 12);
+    const uint64_t declared_total = read_u64(data + 16);
+    const uint64_t num_buckets = read_u32(data + 24);
+    if (size < kHeaderSize + num_buckets * kBucketEntrySize)
+    {
+        error = "Truncated compiled wordlist: " + path;
+        return false;
+    }
+    for (uint64_t i = 0; i < num_buckets; ++i)
+    {
+        const char *entry = data + kHeaderSize + i * kBucketEntrySize;
+        Bucket bucket;
+        bucket.length = read_u32(entry);
+        bucket.count = read_u64(entry + 8);
+        bucket.offset = read_u64(entry + 16);
+        bucket.first_rank = m_total;
+        bool ordered = m_buckets.empty() || bucket.length > m_buckets.back().length;
+        bool fits = bucket.length > 0 && bucket.offset <= size && bucket.count <= (size - bucket.offset) / bucket.length;
+        if (!ordered || !fits)
+        {
+            error = "Corrupted bucket table in compiled wordlist: " + path;
+            return false;
+        }
+        m_total += bucket.count;
+        if (bucket.count > 0)
+            m_buckets.push_back(bucket);
+    }
+    if (m_total != declared_total)
+    {
+        error = "Word count mismatch in compiled wordlist: " + path;
+        return false;
+    }
+    return true;
+}
+
+void CompiledWordlist::rankRange(int min_length, int max_length, uint64_t &first, uint64_t &end) const
+{
+    first = end = m_total;
+    bool found_first = false;
+    for (const Bucket &bucket : m_buckets)
+    {
+        if (!found_first && static_cast<int64_t>(bucket.length) >= min_length)
+        {
+            first = bucket.first_rank;
+            found_first = true;
+        }
+        if (static_cast<int64_t>(bucket.length) > max_length)
+        {
+            end = bucket.first_rank;
+            break;
+        }
+    }
+    if (end < first)
+        end = first;
+}
+
+int CompiledWordlist::maxLength(uint64_t first, uint64_t end) const
+{
+    if (first >= end || end > m_total)
+        return 0;
+    return static_cast<int>(bucketOf(end - 1).length);
+}
+
+const CompiledWordlist::Bucket &CompiledWordlist::bucketOf(uint64_t rank) const
+{
+    // Last bucket whose first rank is <= rank
+    auto it = std::upper_bound(m_buckets.begin(), m_buckets.end(), rank,
+                               [](uint64_t r, const Bucket &bucket) { return r < bucket.first_rank; });
+    return *(it - 1);
+}
+
+std::string_view CompiledWordlist::word(uint64_t rank) const
+{
+    const Bucket &bucket = bucketOf(rank);
+    return std::string_view(m_file.data() + bucket.offset + (rank - bucket.first_rank) * bucket.length, bucket.length);
+}
+
+bool CompiledWordlist::rank(std::string_view word, uint64_t &out_rank) const
+{
+    auto bucket = std::find_if(m_buckets.begin(), m_buckets.end(), [&](const Bucket &b) { return b.length == word.size(); });
+    if (bucket == m_buckets.end() || word.empty())
+        return false;
+    const char *data = m_file.data() + bucket->offset;
+    const size_t length = word.size();
+    uint64_t low = 0, high = bucket->count;
+    if (frequencyOrder())
+    {
+        for (; low < high; ++low)
+        {
+            if (std::memcmp(data + low * length, word.data(), length) == 0)
+                break;
+        }
+    }
+    else
+    {
+        // Byte order: first word not less than `word`
+        while (low < high)
+        {
+            const uint64_t mid = low + (high - low) / 2;
+            if (std::memcmp(data + mid * length, word.data(), length) < 0)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+    }
+    if (low >= bucket->count || std::memcmp(data + low * length, word.data(), length) != 0)
+        return false;
+    out_rank = bucket->first_rank + low;
+    return true;
+}
+
+size_t CompiledWordlist::fill(CandidateBatch &batch, uint64_t rank, uint64_t end) const
+{
+    if (rank >= end || rank >= m_total)
+        return 0;
+    const Bucket &bucket = bucketOf(rank);
+    const uint64_t limit = std::min(end, bucket.first_rank + bucket.count);
+    const char *word = m_file.data() + bucket.offset + (rank - bucket.first_rank) * bucket.length;
+    size_t appended = 0;
+    for (; rank < limit && !batch.full(); ++rank, word += bucket.length)
+    {
+        char *slot = batch.emplace(bucket.length, rank);
+        if (!slot)
+            break;
+        std::memcpy(slot, word, bucket.length);
+        ++appended;
+    }
+    return appended;
+}
+
+// ================================================================
+// ===                 WORDLIST COMPILER (EXTERNAL SORT)        ===
+// ================================================================
+// Records are fixed width per word length: [uint64 count, native endian][word bytes].
+namespace
+{
+    using RecordLess = bool (*)(const char *, const char *, size_t word_length);
+
+    uint64_t record_count(const char *record)
+    {
+        uint64_t count;
+        std::memcpy(&count, record, sizeof(count));
+        return count;
+    }
+
+    void set_record_count(char *record, uint64_t count)
+    {
+        std::memcpy(record, &count, sizeof(count));
+    }
+
+    bool by_word(const char *a, const char *b, size_t word_length)
+    {
+        return std::memcmp(a + 8, b + 8, word_length) < 0;
+    }
+
+    // Most frequent first; equal counts keep byte order
+    bool by_frequency(const char *a, const char *b, size_t word_length)
+    {
+        uint64_t ca = record_count(a), cb = record_count(b);
+        if (ca != cb)
+            return ca > cb;
+        return by_word(a, b, word_length);
+    }
+
+    // Sorted runs of records, appended to one temporary file
+    class RunStore
+    {
+    public:
+        struct Run
+        {
+            uint64_t offset;
+            uint64_t records;
+        };
+
+        ~RunStore()
+        {
+            if (m_file)
+            {
+                std::fclose(m_file);
+                std::remove(m_path.c_str());
+            }
+        }
+
+        bool open(const std::string &path)
+        {
+            m_path = path;
+            m_file = std::fopen(path.c_str(), "w+b");
+            return m_file != nullptr;
+        }
+
+        bool append(const char *records, size_t bytes, uint64_t count, Run &run)
+        {
+            run.offset = m_end;
+            run.records = count;
+            if (!seek_to(m_file, m_end) || std::fwrite(records, 1, bytes, m_file) != bytes)
+                return false;
+            m_end += bytes;
+            return true;
+        }
+
+        bool read(uint64_t offset, char *out, size_t bytes)
+        {
+            return seek_to(m_file, offset) && std::fread(out, 1, bytes, m_file) == bytes;
+        }
+
+    private:
+        FILE *m_file = nullptr;
+        std::string m_path;
+        uint64_t m_end = 0;
+    };
+
+    // Buffered sequential reader of one run
+    class RunCursor
+    {
+    public:
+        RunCursor(RunStore &store, RunStore::Run run, size_t width)
+            : m_store(&store), m_next_offset(run.offset), m_left(run.records), m_width(width),
+              m_capacity(std::max<size_t>(1, (64 * 1024) / width))
+        {
+        }
+
+        // Moves to the next record; false at the end of the run or on a read error (see failed())
+        bool advance()
+        {
+            if (++m_index < m_buffered)
+                return true;
+            if (m_left == 0)
+                return false;
+            m_buffered = static_cast<size_t>(std::min<uint64_t>(m_left, m_capacity));
+            m_buffer.resize(m_buffered * m_width);
+            if (!m_store->read(m_next_offset, &m_buffer[0], m_buffer.size()))
+            {
+                m_failed = true;
+                return false;
+            }
+            m_next_offset += m_buffer.size();
+            m_left -= m_buffered;
+            m_index = 0;
+            return true;
+        }
+
+        const char *record() const { return m_buffer.data() + m_index * m_width; }
+        bool failed() const { return m_failed; }
+
+    private:
+        RunStore *m_store;
+        uint64_t m_next_offset;
+        uint64_t m_left;
+        size_t m_width;
+        size_t m_capacity;
+        std::string m_buffer;
+        size_t m_buffered = 0;
+        size_t m_index = 0;
+        bool m_failed = false;
+    };
+
+    // Sorts the records of `chunk` and appends them to the store as one run (no-op if empty).
+    // With `combine`, records with equal words collapse into one with the summed count.
+    bool write_run(RunStore &store, std::string &chunk, size_t word_length, RecordLess less, bool combine,
+                   std::vector<RunStore::Run> &runs)
+    {
+        const size_t width = 8 + word_length;
+        const size_t count = chunk.size() / width;
+        if (count == 0)
+            return true;
+        std::vector<size_t> order(count);
+        std::iota(order.begin(), order.end(), size_t(0));
+        const char *base = chunk.data();
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return less(base + a * width, base + b * width, word_length);
+        });
+        std::string sorted;
+        sorted.reserve(chunk.size());
+        for (size_t i : order)
+        {
+            const char *record = base + i * width;
+            if (combine && !sorted.empty() && std::memcmp(&sorted[sorted.size() - word_length], record + 8, word_length) == 0)
+            {
+                char *last = &sorted[sorted.size() - width];
+                set_record_count(last, record_count(last) + record_count(record));
+                continue;
+            }
+            sorted.append(record, width);
+        }
+        chunk.clear();
+        RunStore::Run run;
+        if (!store.append(sorted.data(), sorted.size(), sorted.size() / width, run))
+            return false;
+        runs.push_back(run);
+        return true;
+    }
+
+    // K-way merge of `runs` in `less` order, calling sink(record) once per record.
+    // With `combine`, consecutive equal words are merged first (runs must be sorted by word).
+    template <typename Sink>
+    bool merge_runs(RunStore &store, const std::vector<RunStore::Run> &runs, size_t word_length, RecordLess less, bool combine,
+                    Sink sink)
+    {
+        const size_t width = 8 + word_length;
+        std::vector<RunCursor> cursors;
+        for (const auto &run : runs)
+            cursors.emplace_back(store, run, width);
+        // Min-heap of cursor indices; ties go to the earlier run so the merge is stable
+        auto greater = [&](size_t a, size_t b) {
+            if (less(cursors[b].record(), cursors[a].record(), word_length))
+                return true;
+            if (less(cursors[a].record(), cursors[b].record(), word_length))
+                return false;
+            return a > b;
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+        for (size_t i = 0; i < cursors.size(); ++i)
+        {
+            if (cursors[i].advance())
+                heap.push(i);
+            else if (cursors[i].failed())
+                return false;
+        }
+        std::string pending;
+        while (!heap.empty())
+        {
+            size_t i = heap.top();
+            heap.pop();
+            const char *record = cursors[i].record();
+            if (combine && !pending.empty() && std::memcmp(pending.data() + 8, record + 8, word_length) == 0)
+            {
+                set_record_count(&pending[0], record_count(pending.data()) + record_count(record));
+            }
+            else
+            {
+                if (!pending.empty() && !sink(pending.data()))
+                    return false;
+                pending.assign(record, width);
+            }
+            if (cursors[i].advance())
+                heap.push(i);
+            else if (cursors[i].failed())
+                return false;
+        }
+        return pending.empty() || sink(pending.data());
+    }
+}
+
+bool compile_wordlist(const std::string &input_path, const std::string &output_path, bool frequency_order,
+                      uint64_t memory_bytes, std::string &error)
+{
+    Wordlist input;
+    if (!input.open(input_path, error))
+        return false;
+    RunStore store;
+    if (!store.open(output_path + ".tmp"))
+    {
+        error = "Cannot create temporary file: " + output_path + ".tmp";
+        return false;
+    }
+    const uint64_t budget = std::max<uint64_t>(memory_bytes, 1 << 20);
+
+    // --- Pass 1: split lines by length into sorted, locally deduplicated runs ---
+    std::vector<std::string> chunks(kMaxWordLength + 1);
+    std::vector<std::vector<RunStore::Run>> word_runs(kMaxWordLength + 1);
+    uint64_t buffered = 0, lines = 0, too_long = 0;
+    auto spill = [&]() -> bool {
+        for (size_t length = 1; length <= kMaxWordLength; ++length)
+        {
+            if (!write_run(store, chunks[length], length, by_word, true, word_runs[length]))
+                return false;
+        }
+        buffered = 0;
+        return true;
+    };
+    const char *data = input.data();
+    const char *end = data + input.size();
+    char count_one[8];
+    set_record_count(count_one, 1);
+    for (const char *line = data; line < end;)
+    {
+        const char *newline = find_newline(line, end);
+        size_t length = static_cast<size_t>(newline - line);
+        const char *word = line;
+        line = (newline < end) ? newline + 1 : end;
+        if (length > 0 && word[length - 1] == '\r')
+            --length;
+        if (length == 0)
+            continue;
+        ++lines;
+        if (length > kMaxWordLength)
+        {
+            ++too_long;
+            continue;
+        }
+        chunks[length].append(count_one, 8).append(word, length);
+        buffered += 8 + length;
+        if (buffered >= budget && !spill())
+        {
+            error = "Failed to write temporary run file (disk full?)";
+            return false;
+        }
+    }
+    if (!spill())
+    {
+        error = "Failed to write temporary run file (disk full?)";
+        return false;
+    }
+    chunks.clear();
+    chunks.shrink_to_fit();
+    if (too_long > 0)
+        update_output("WARN: " + std::to_string(too_long) + " lines longer than " + std::to_string(kMaxWordLength) + " bytes skipped.");
+
+    // --- Pass 2: merge the runs of each length into its bucket ---
+    std::vector<uint32_t> lengths;
+    for (size_t length = 1; length <= kMaxWordLength; ++length)
+    {
+        if (!word_runs[length].empty())
+            lengths.push_back(static_cast<uint32_t>(length));
+    }
+    FILE *out = std::fopen(output_path.c_str(), "wb");
+    if (!out)
+    {
+        error = "Cannot create output file: " + output_path;
+        return false;
+    }
+    const uint64_t data_start = kHeaderSize + lengths.size() * kBucketEntrySize;
+    std::string placeholder(static_cast<size_t>(data_start), '\0');
+    bool ok = std::fwrite(placeholder.data(), 1, placeholder.size(), out) == placeholder.size();
+    uint64_t position = data_start, total = 0;
+    std::vector<uint64_t> counts(lengths.size(), 0), offsets(lengths.size(), 0);
+    for (size_t b = 0; b < lengths.size() && ok; ++b)
+    {
+        const size_t length = lengths[b];
+        offsets[b] = position;
+        auto emit_word = [&](const char *record) -> bool {
+            if (std::fwrite(record + 8, 1, length, out) != length)
+                return false;
+            ++counts[b];
+            return true;
+        };
+        if (!frequency_order)
+        {
+            ok = merge_runs(store, word_runs[length], length, by_word, true, emit_word);
+        }
+        else
+        {
+            // Distinct words with their totals, re-sorted by count (externally if needed)
+            std::string chunk;
+            std::vector<RunStore::Run> frequency_runs;
+            ok = merge_runs(store, word_runs[length], length, by_word, true, [&](const char *record) -> bool {
+                chunk.append(record, 8 + length);
+                return chunk.size() < budget || write_run(store, chunk, length, by_frequency, false, frequency_runs);
+            });
+            ok = ok && write_run(store, chunk, length, by_frequency, false, frequency_runs) &&
+                 merge_runs(store, frequency_runs, length, by_frequency, false, emit_word);
+        }
+        position += counts[b] * length;
+        total += counts[b];
+    }
+
+    // Header and bucket table now that every count is known
+    std::string header(kMagic, sizeof(kMagic));
+    put_u32(header, kVersion);
+    put_u32(header, frequency_order ? CompiledWordlist::kFlagFrequencyOrder : 0);
+    put_u64(header, total);
+    put_u32(header, static_cast<uint32_t>(lengths.size()));
+    put_u32(header, 0);
+    for (size_t b = 0; b < lengths.size(); ++b)
+    {
+        put_u32(header, lengths[b]);
+        put_u32(header, 0);
+        put_u64(header, counts[b]);
+        put_u64(header, offsets[b]);
+    }
+    ok = ok && seek_to(out, 0) && std::fwrite(header.data(), 1, header.size(), out) == header.size();
+    ok = (std::fclose(out) == 0) && ok;
+    if (!ok)
+    {
+        std::remove(output_path.c_str());
+        error = "Failed to write compiled wordlist: " + output_path;
+        return false;
+    }
+    update_output("INFO: Compiled " + std::to_string(lines) + " lines into " + std::to_string(total) + " distinct words in " +
+                  std::to_string(lengths.size()) + " length buckets" + (frequency_order ? " (frequency order)." : "."));
+    return true;
+}
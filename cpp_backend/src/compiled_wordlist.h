@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint> // For uint64_t, uint32_t
+#include <cstddef> // For size_t
+#include "wordlist.h" // For the read-only mapping
+
+class CandidateBatch;
+
+// Preprocessed wordlist written by `wordlist compile` (see compile_wordlist).
+// Layout, all integers little-endian:
+//   0   char[8]  magic "APCWORDS"
+//   8   uint32   version (1)
+//   12  uint32   flags (1 = words of each length are ordered by descending input frequency)
+//   16  uint64   number of words
+//   24  uint32   number of length buckets
+//   28  uint32   reserved (0)
+//   32  bucket table, ascending length: { uint32 length, uint32 reserved, uint64 count, uint64 data offset }
+//   ... bucket data: `count` words of exactly `length` bytes each, no separators
+// Words are distinct. Rank r is the r-th word when the buckets are read in table order, so a
+// rank locates its word in O(log buckets) and every length range is one contiguous rank range.
+class CompiledWordlist {
+public:
+    static constexpr uint32_t kFlagFrequencyOrder = 1;
+
+    // True if the file starts with the compiled wordlist magic
+    static bool isCompiled(const std::string& path);
+
+    // Maps the file and validates the header and bucket table
+    bool open(const std::string& path, std::string& error);
+
+    uint64_t size() const { return m_total; }
+    bool frequencyOrder() const { return (m_flags & kFlagFrequencyOrder) != 0; }
+
+    // Rank range [first, end) of the words with min_length <= length <= max_length
+    void rankRange(int min_length, int max_length, uint64_t& first, uint64_t& end) const;
+
+    // Longest word with a rank in [first, end) (0 if the range is empty)
+    int maxLength(uint64_t first, uint64_t end) const;
+
+    // Word with the given rank (rank < size())
+    std::string_view word(uint64_t rank) const;
+
+    // Inverse of word(): binary search within the length bucket, or a scan in frequency order.
+    // Returns false if the list does not contain `word`.
+    bool rank(std::string_view word, uint64_t& out_rank) const;
+
+    // Appends words starting at `rank` until the batch is full, `end` is reached or the length
+    // bucket ends, so every batch holds words of one length. Returns the number appended.
+    size_t fill(CandidateBatch& batch, uint64_t rank, uint64_t end) const;
+
+private:
+    struct Bucket {
+        uint32_t length = 0;
+        uint64_t count = 0;
+        uint64_t offset = 0;     // File offset of the first word
+        uint64_t first_rank = 0; // Words in earlier buckets
+    };
+
+    // Bucket holding `rank` (rank < size())
+    const Bucket& bucketOf(uint64_t rank) const;
+
+    Wordlist m_file;
+    std::vector<Bucket> m_buckets;
+    uint64_t m_total = 0;
+    uint32_t m_flags = 0;
+};
+
+// `wordlist compile`: deduplicates the text wordlist `input_path` (one word per line, LF or CRLF)
+// and writes it to `output_path` in the format above. Words are grouped by length; within a
+// length they are in byte order, or by descending number of occurrences with `frequency_order`.
+// Lists larger than `memory_bytes` are sorted externally through sorted runs in a temporary file
+// next to the output. Progress goes through update_output. Returns false and sets `error` on failure.
+bool compile_wordlist(const std::string& input_path, const std::string& output_path, bool frequency_order,
+                      uint64_t memory_bytes, std::string& error);
@@ -0,0 +1,642 @@
+#include "coordinator.h"
+#include "tcp_socket.h"
+#include <algorithm> // For std::min, std::find
+#include <atomic>
+#include <cctype>    // For std::tolower
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>    // For std::remove
+#include <deque>
+#include <fstream>
+#include <iostream>  // For the FOUND: marker on stdout
+#include <list>
+#include <map>
+#include <mutex>
+#include <random>    // For std::random_device (job seed)
+#include <sstream>
+#include <thread>
+#include <utility>   // For std::pair
+
+extern void update_output(const std::string &message); // Defined in main.cpp
+
+// --- Protocol (one text line per message, every request gets one reply line) ---
+//   HELLO <name>                 -> JOB <n>, followed by the n job arguments, one per line
+//   LEASE                        -> RANGE <id> <begin> <end> <first> | WAIT <seconds> | STOP
+//   HEARTBEAT <id>               -> OK | STOP (the job is over) | LOST (the lease was reassigned)
+//   COMPLETE <id> <domain>       -> OK | STOP   (domain: position count of the job's main phase)
+//   FOUND <id> <password>        -> OK
+//   RELEASE <id>                 -> OK | STOP   (lease left unfinished, hand it out again)
+//   FAIL <id> <message>          -> OK          (the job cannot run, end it everywhere)
+//   BYE                          -> connection closed
+// <first> is 1 for the lease that starts the job's range; only that one runs the pre-passes.
+
+static const char *kPrepassOptions[] = {"--common-passwords", "--archive-tokens"};
+
+// Reads the rest of a line after a fixed number of words (passwords may contain spaces)
+static std::string rest_of_line(const std::string &line, int words)
+{
+    size_t position = 0;
+    for (int i = 0; i < words && position != std::string::npos; ++i)
+    {
+        position = line.find(' ', position);
+        if (position != std::string::npos)
+            ++position;
+    }
+    return position == std::string::npos ? std::string() : line.substr(position);
+}
+
+// ================================================================
+// ===                        COORDINATOR                       ===
+// ================================================================
+
+namespace
+{
+
+struct Lease
+{
+    uint128 begin = 0;
+    uint128 end = 0;
+    std::string worker;
+    const void *connection = nullptr; // Leases of a closed connection are handed out again
+    std::chrono::steady_clock::time_point heartbeat;
+};
+
+class Coordinator
+{
+public:
+    enum class Outcome { Running, Found, Exhausted, Failed };
+
+    Coordinator(const CoordinatorOptions &options, std::vector<std::string> job, uint128 begin, uint128 end)
+        : m_options(options), m_job(std::move(job)), m_start(begin), m_next(begin), m_end(end)
+    {
+    }
+
+    // Answers one connection's requests until it closes
+    void serve(TcpStream &stream)
+    {
+        std::string worker = "?";
+        std::string line;
+        while (stream.readLine(line))
+        {
+            std::istringstream in(line);
+            std::string command;
+            in >> command;
+            if (command == "BYE")
+                break;
+            if (command == "HELLO")
+            {
+                worker = rest_of_line(line, 1);
+                update_output("INFO: Worker '" + worker + "' connected.");
+                if (!stream.sendLine("JOB " + std::to_string(m_job.size())))
+                    break;
+                bool sent = true;
+                for (const auto &arg : m_job)
+                    sent = sent && stream.sendLine(arg);
+                if (!sent)
+                    break;
+                continue;
+            }
+            uint64_t id = 0;
+            in >> id;
+            std::string reply;
+            if (command == "LEASE")
+                reply = lease(worker, &stream);
+            else if (command == "HEARTBEAT")
+                reply = heartbeat(id);
+            else if (command == "COMPLETE")
+            {
+                std::string domain_text;
+                uint128 domain = 0;
+                in >> domain_text;
+                reply = parse_uint128(domain_text, domain) ? complete(id, domain, worker) : "ERROR bad domain";
+            }
+            else if (command == "FOUND")
+                reply = found(id, rest_of_line(line, 2), worker);
+            else if (command == "RELEASE")
+                reply = release(id);
+            else if (command == "FAIL")
+                reply = fail(id, rest_of_line(line, 2), worker);
+            else
+                reply = "ERROR unknown request";
+            if (!stream.sendLine(reply))
+                break;
+        }
+        disconnected(&stream, worker);
+    }
+
+    // Hands out again every lease whose worker missed the heartbeat timeout
+    void expireLeases()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = m_leases.begin(); it != m_leases.end();)
+        {
+            if (now - it->second.heartbeat > std::chrono::seconds(m_options.lease_timeout_seconds))
+            {
+                update_output("WARN: Lease #" + std::to_string(it->first) + " of worker '" + it->second.worker +
+                              "' timed out; it will be handed out again.");
+                m_free.emplace_back(it->second.begin, it->second.end);
+                m_expired[it->first] = m_free.back();
+                it = m_leases.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    Outcome outcome()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_outcome;
+    }
+
+    std::string password()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_password;
+    }
+
+private:
+    std::string lease(const std::string &worker, const void *connection)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_outcome != Outcome::Running)
+            return "STOP";
+        uint128 begin = 0, end = 0;
+        if (!m_free.empty())
+        {
+            begin = m_free.front().first;
+            end = m_free.front().second;
+            m_free.pop_front();
+        }
+        else if (m_next < m_end)
+        {
+            begin = m_next;
+            end = (m_end - m_next > m_options.lease_size) ? m_next + m_options.lease_size : m_end;
+            m_next = end;
+        }
+        else if (!m_leases.empty())
+        {
+            return "WAIT 1"; // Only running leases left; one of them may still be handed back
+        }
+        else
+        {
+            finish(Outcome::Exhausted);
+            return "STOP";
+        }
+        const uint64_t id = m_next_id++;
+        m_leases[id] = Lease{begin, end, worker, connection, std::chrono::steady_clock::now()};
+        update_output("INFO: Lease #" + std::to_string(id) + " (positions " + to_string(begin) + " to " + to_string(end) + ") -> worker '" + worker + "'.");
+        return "RANGE " + std::to_string(id) + " " + to_string(begin) + " " + to_string(end) + (begin == m_start ? " 1" : " 0");
+    }
+
+    std::string heartbeat(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_outcome != Outcome::Running)
+            return "STOP";
+        auto it = m_leases.find(id);
+        if (it == m_leases.end())
+            return "LOST";
+        it->second.heartbeat = std::chrono::steady_clock::now();
+        return "OK";
+    }
+
+    std::string complete(uint64_t id, uint128 domain, const std::string &worker)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_leases.find(id);
+        if (it != m_leases.end())
+        {
+            m_done += it->second.end - it->second.begin;
+            m_leases.erase(it);
+        }
+        else
+        {
+            // A worker that missed its heartbeats may still finish the lease before hearing about it
+            auto expired = m_expired.find(id);
+            if (expired != m_expired.end())
+            {
+                if (forget(expired->second))
+                    m_done += expired->second.second - expired->second.first;
+                m_expired.erase(expired);
+            }
+        }
+        if (domain < m_end)
+        {
+            // Workers learn the size of the position space; nothing past it is leased
+            m_end = domain;
+            update_output("INFO: The job ends at position " + to_string(domain) + ".");
+            for (auto &range : m_free)
+                range.second = std::min(range.second, m_end);
+            for (auto &expired : m_expired)
+                expired.second.second = std::min(expired.second.second, m_end);
+            m_free.erase(std::remove_if(m_free.begin(), m_free.end(), [](const std::pair<uint128, uint128> &range) { return range.first >= range.second; }),
+                         m_free.end());
+        }
+        update_output("INFO: Lease #" + std::to_string(id) + " completed by worker '" + worker + "' (" + to_string(m_done) + " positions done).");
+        if (m_outcome == Outcome::Running && m_next >= m_end && m_free.empty() && m_leases.empty())
+            finish(Outcome::Exhausted);
+        return m_outcome == Outcome::Running ? "OK" : "STOP";
+    }
+
+    std::string found(uint64_t id, const std::string &password, const std::string &worker)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_leases.erase(id);
+        if (m_outcome == Outcome::Running)
+        {
+            m_password = password;
+            update_output("INFO: Worker '" + worker + "' found the password in lease #" + std::to_string(id) + "; stopping all workers.");
+            finish(Outcome::Found);
+        }
+        return "OK";
+    }
+
+    std::string release(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_leases.find(id);
+        if (it != m_leases.end())
+        {
+            m_free.emplace_front(it->second.begin, it->second.end);
+            m_leases.erase(it);
+        }
+        return m_outcome == Outcome::Running ? "OK" : "STOP";
+    }
+
+    std::string fail(uint64_t id, const std::string &message, const std::string &worker)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_leases.erase(id);
+        if (m_outcome == Outcome::Running)
+        {
+            update_output("ERROR: Worker '" + worker + "' cannot run the job: " + message);
+            finish(Outcome::Failed);
+        }
+        return "OK";
+    }
+
+    void disconnected(const void *connection, const std::string &worker)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_leases.begin(); it != m_leases.end();)
+        {
+            if (it->second.connection == connection)
+            {
+                update_output("WARN: Worker '" + worker + "' disconnected during lease #" + std::to_string(it->first) +
+                              "; it will be handed out again.");
+                m_free.emplace_front(it->second.begin, it->second.end);
+                it = m_leases.erase(it);
+            }
+            else
+                ++it;
+        }
+        update_output("INFO: Worker '" + worker + "' disconnected.");
+    }
+
+    // Takes a range that is waiting to be handed out again off the list; false if it was leased already
+    bool forget(const std::pair<uint128, uint128> &range)
+    {
+        auto it = std::find(m_free.begin(), m_free.end(), range);
+        if (it == m_free.end())
+            return false;
+        m_free.erase(it);
+        return true;
+    }
+
+    void finish(Outcome outcome)
+    {
+        m_outcome = outcome;
+        if (outcome == Outcome::Exhausted)
+            update_output("INFO: Every lease is complete.");
+    }
+
+    const CoordinatorOptions &m_options;
+    const std::vector<std::string> m_job;
+    const uint128 m_start;
+    std::mutex m_mutex;
+    uint128 m_next;   // First position not leased yet
+    uint128 m_end;    // End of the job's range, lowered once a worker reports the phase size
+    uint128 m_done = 0;
+    uint64_t m_next_id = 1;
+    std::deque<std::pair<uint128, uint128>> m_free; // Ranges handed back, leased again first
+    std::map<uint64_t, Lease> m_leases;
+    std::map<uint64_t, std::pair<uint128, uint128>> m_expired; // Timed-out leases, in case they complete late
+    Outcome m_outcome = Outcome::Running;
+    std::string m_password;
+};
+
+} // namespace
+
+// Checks the job arguments, takes its --start-index/--end-index as the leased range and drops
+// the options that belong to each worker. Returns false and sets `error` for unusable jobs.
+static bool prepare_job(std::vector<std::string> &args, uint128 &begin, uint128 &end, std::string &error)
+{
+    if (args.size() < 5)
+    {
+        error = "The job needs <charset> <min_length> <max_length> <archive_path> <mode> [options...].";
+        return false;
+    }
+    begin = 0;
+    end = kUint128Max;
+    bool has_seed = false;
+    std::vector<std::string> kept(args.begin(), args.begin() + 5);
+    for (size_t i = 5; i < args.size(); ++i)
+    {
+        const std::string &arg = args[i];
+        const bool has_value = i + 1 < args.size();
+        if ((arg == "--start-index" || arg == "--end-index") && has_value)
+        {
+            if (!parse_uint128(args[i + 1], arg == "--start-index" ? begin : end))
+            {
+                error = "Invalid " + arg + " value ('" + args[i + 1] + "').";
+                return false;
+            }
+            ++i;
+        }
+        else if ((arg == "-s" || arg == "--skip-file" || arg == "-c" || arg == "--checkpoint-interval" || arg == "--stop-file") && has_value)
+        {
+            update_output("INFO: Ignoring " + arg + " in the job; skip lists and stop files belong to each worker.");
+            ++i;
+        }
+        else if (arg == "--pcfg" || arg == "--shard" || arg == "--resume-from")
+        {
+            error = arg + " cannot be used with a coordinator (PCFG guesses have no positions to lease; leases replace --shard and --resume-from).";
+            return false;
+        }
+        else
+        {
+            if (arg == "--seed")
+                has_seed = true;
+            kept.push_back(arg);
+        }
+    }
+    std::string mode = kept[4];
+    std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (mode == "random" && !has_seed)
+    {
+        // Every lease has to cut the same shuffled order
+        std::random_device device;
+        const uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+        kept.push_back("--seed");
+        kept.push_back(std::to_string(seed));
+        update_output("INFO: Random order seed for all workers: " + std::to_string(seed) + ".");
+    }
+    if (begin >= end)
+    {
+        error = "--start-index must be below --end-index.";
+        return false;
+    }
+    args = std::move(kept);
+    return true;
+}
+
+int run_coordinator(const CoordinatorOptions &options)
+{
+    std::vector<std::string> job = options.job_args;
+    uint128 begin = 0, end = 0;
+    std::string error;
+    if (!prepare_job(job, begin, end, error))
+    {
+        update_output("ERROR: " + error);
+        return 2;
+    }
+    TcpListener listener;
+    if (!listener.listen(options.bind_address, options.port, error))
+    {
+        update_output("ERROR: " + error);
+        return 6;
+    }
+    update_output("INFO: Coordinator listening on " + options.bind_address + ":" + std::to_string(listener.port()) + " (lease " +
+                  to_string(options.lease_size) + " positions, lease timeout " + std::to_string(options.lease_timeout_seconds) + " s).");
+
+    Coordinator coordinator(options, job, begin, end);
+    std::mutex connections_mutex;
+    std::list<TcpStream> connections; // Stable addresses: each one is served by its own thread
+    std::vector<std::thread> threads;
+    std::atomic<int> open_connections(0);
+
+    // Accept workers until the job is over, then give the rest a lease timeout to hear about it
+    auto over_since = std::chrono::steady_clock::time_point();
+    for (;;)
+    {
+        coordinator.expireLeases();
+        if (coordinator.outcome() != Coordinator::Outcome::Running)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (over_since == std::chrono::steady_clock::time_point())
+                over_since = now;
+            if (open_connections.load() == 0 || now - over_since > std::chrono::seconds(options.lease_timeout_seconds))
+                break;
+        }
+        TcpStream stream = listener.accept(200);
+        if (!stream.valid())
+            continue;
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        connections.push_back(std::move(stream));
+        TcpStream &connection = connections.back();
+        ++open_connections;
+        threads.emplace_back([&coordinator, &connection, &open_connections]() {
+            coordinator.serve(connection);
+            --open_connections;
+        });
+    }
+    listener.close();
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        for (auto &connection : connections)
+            connection.shutdown();
+    }
+    for (auto &th : threads) { if (th.joinable()) th.join(); }
+
+    switch (coordinator.outcome())
+    {
+    case Coordinator::Outcome::Found:
+        std::cout << "FOUND:" << coordinator.password() << std::endl;
+        update_output("INFO: Password found!");
+        return 0;
+    case Coordinator::Outcome::Failed:
+        return 5;
+    default:
+        update_output("INFO: Password not found within the specified constraints.");
+        return 1;
+    }
+}
+
+// ================================================================
+// ===                          WORKER                          ===
+// ================================================================
+
+static bool file_exists(const std::string &path)
+{
+    std::ifstream file(path);
+    return file.good();
+}
+
+static void touch_file(const std::string &path)
+{
+    std::ofstream file(path);
+}
+
+int run_worker(const WorkerOptions &options, const LeaseRunner &run_lease)
+{
+    TcpStream stream;
+    std::string error;
+    if (!stream.connect(options.host, options.port, error))
+    {
+        update_output("ERROR: " + error);
+        return 6;
+    }
+    std::mutex link_mutex; // Main thread and heartbeat thread share the connection, one request at a time
+    auto request = [&](const std::string &line, std::string &reply) {
+        std::lock_guard<std::mutex> lock(link_mutex);
+        return stream.sendLine(line) && stream.readLine(reply);
+    };
+
+    // --- Job definition ---
+    std::vector<std::string> job;
+    std::string reply;
+    size_t count = 0;
+    if (!request("HELLO " + options.name, reply) || reply.compare(0, 4, "JOB ") != 0 || !(std::istringstream(reply.substr(4)) >> count))
+    {
+        update_output("ERROR: No job from coordinator " + options.host + ":" + std::to_string(options.port) + ".");
+        return 6;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string arg;
+        if (!stream.readLine(arg))
+        {
+            update_output("ERROR: Connection lost while receiving the job.");
+            return 6;
+        }
+        job.push_back(arg);
+    }
+    if (job.size() < 5)
+    {
+        update_output("ERROR: Coordinator sent an incomplete job.");
+        return 6;
+    }
+    if (!options.archive_path.empty())
+        job[3] = options.archive_path;
+    std::string job_text;
+    for (const auto &arg : job)
+        job_text += " " + arg;
+    update_output("INFO: Worker '" + options.name + "' joined the job:" + job_text);
+    std::remove(options.stop_file.c_str()); // Left over from an earlier run
+
+    bool found_here = false;
+    for (;;)
+    {
+        if (file_exists(options.stop_file))
+        {
+            update_output("INFO: Stop file detected; leaving the job.");
+            std::remove(options.stop_file.c_str());
+            request("BYE", reply);
+            return found_here ? 0 : 1;
+        }
+        if (!request("LEASE", reply))
+        {
+            update_output("ERROR: Connection to the coordinator lost.");
+            return 6;
+        }
+        std::istringstream in(reply);
+        std::string command;
+        in >> command;
+        if (command == "WAIT")
+        {
+            int seconds = 1;
+            in >> seconds;
+            std::this_thread::sleep_for(std::chrono::seconds(std::max(1, seconds)));
+            continue;
+        }
+        if (command != "RANGE")
+        {
+            update_output("INFO: Coordinator ended the job.");
+            request("BYE", reply);
+            return found_here ? 0 : 1;
+        }
+        std::string id, begin, end;
+        int first = 0;
+        in >> id >> begin >> end >> first;
+
+        std::vector<std::string> args;
+        for (const auto &arg : job)
+        {
+            const bool prepass = std::find(std::begin(kPrepassOptions), std::end(kPrepassOptions), arg) != std::end(kPrepassOptions);
+            if (!prepass || first)
+                args.push_back(arg);
+        }
+        args.insert(args.end(), {"--start-index", begin, "--end-index", end, "--stop-file", options.stop_file});
+        update_output("INFO: Running lease #" + id + " (positions " + begin + " to " + end + ").");
+
+        // Heartbeats keep the lease; a STOP or LOST reply interrupts the local run through the stop file
+        std::mutex heartbeat_mutex;
+        std::condition_variable heartbeat_wake;
+        bool lease_over = false;
+        std::atomic<bool> interrupted(false), link_lost(false), job_over(false);
+        std::thread heartbeat([&]() {
+            std::unique_lock<std::mutex> lock(heartbeat_mutex);
+            while (!heartbeat_wake.wait_for(lock, std::chrono::seconds(options.heartbeat_seconds), [&]() { return lease_over; }))
+            {
+                std::string answer;
+                const bool ok = request("HEARTBEAT " + id, answer);
+                if (ok && answer == "OK")
+                    continue;
+                link_lost = !ok;
+                job_over = ok && answer == "STOP";
+                interrupted = true;
+                touch_file(options.stop_file);
+                return;
+            }
+        });
+        const LeaseRun run = run_lease(args);
+        {
+            std::lock_guard<std::mutex> lock(heartbeat_mutex);
+            lease_over = true;
+        }
+        heartbeat_wake.notify_one();
+        heartbeat.join();
+        if (interrupted)
+            std::remove(options.stop_file.c_str());
+
+        if (run.exit_code == 0)
+        {
+            found_here = true;
+            if (!request("FOUND " + id + " " + run.password, reply))
+                update_output("ERROR: Could not report the password to the coordinator; it is printed above.");
+            continue;
+        }
+        if (link_lost)
+        {
+            update_output("ERROR: Connection to the coordinator lost.");
+            return 6;
+        }
+        if (run.exit_code != 1 || (!interrupted && !run.domain_known && !file_exists(options.stop_file)))
+        {
+            request("FAIL " + id + " exit code " + std::to_string(run.exit_code) + " on '" + options.name + "'", reply);
+            return 5;
+        }
+        if (interrupted)
+        {
+            // Job over (the next LEASE says so) or the lease went to another worker
+            if (job_over)
+                request("RELEASE " + id, reply);
+            continue;
+        }
+        if (file_exists(options.stop_file))
+        {
+            update_output("INFO: Stop file detected; handing lease #" + id + " back.");
+            request("RELEASE " + id, reply);
+            std::remove(options.stop_file.c_str());
+            request("BYE", reply);
+            return found_here ? 0 : 1;
+        }
+        if (!request("COMPLETE " + id + " " + to_string(run.domain), reply))
+        {
+            update_output("ERROR: Connection to the coordinator lost.");
+            return 6;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint> // For uint16_t
+#include "uint128.h"
+
+// Distributed runs: a coordinator owns the job (the normal CLI arguments) and hands out leases,
+// contiguous pieces of its position range (see --start-index), to worker processes over TCP.
+// Workers run every lease through the normal local cracking path with --start-index/--end-index,
+// heartbeat while they work and report the lease complete or the password. Leases without a
+// heartbeat are handed out again, and the first hit stops every worker.
+
+struct CoordinatorOptions {
+    std::string bind_address = "127.0.0.1"; // --bind: 0.0.0.0 also accepts workers from other machines
+    uint16_t port = 0;
+    uint128 lease_size = 1000000;           // --lease: positions per lease
+    int lease_timeout_seconds = 30;         // --lease-timeout: reassign a lease after this long without a heartbeat
+    std::vector<std::string> job_args;      // <charset> <min> <max> <archive> <mode> [options...]
+};
+
+// Serves workers until the password is found, every lease is complete or a worker reports that
+// the job cannot run. Exit codes: 0 found (prints FOUND:<password>), 1 not found, 2 job argument
+// error, 5 the job failed on a worker, 6 network error.
+int run_coordinator(const CoordinatorOptions& options);
+
+struct WorkerOptions {
+    std::string host;
+    uint16_t port = 0;
+    std::string name;          // --name: shown in the coordinator log
+    std::string archive_path;  // --archive: local path of the archive if it differs from the job's
+    std::string stop_file;     // --stop-file: touch to stop this worker; also interrupts a lease on a broadcast stop
+    int heartbeat_seconds = 5; // --heartbeat
+};
+
+// Outcome of one local run over a lease
+struct LeaseRun {
+    int exit_code = 1;         // As the normal CLI: 0 found, 1 not found, anything else an error
+    std::string password;      // Set when found
+    bool domain_known = false; // The run reached its main phase,
+    uint128 domain = 0;        // whose position space has this size
+};
+
+// Runs the cracking job for the given arguments (without the program name)
+typedef std::function<LeaseRun(const std::vector<std::string>& args)> LeaseRunner;
+
+// Connects, fetches the job and runs leases until the coordinator ends the job. Exit codes:
+// 0 this worker found the password, 1 the job ended without a hit here (or a local stop),
+// 5 the job failed, 6 network error.
+int run_worker(const WorkerOptions& options, const LeaseRunner& run_lease);
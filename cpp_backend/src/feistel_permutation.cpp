@@ -0,0 +1,83 @@
+#include "feistel_permutation.h"
+
+// SplitMix64 finalizer: cheap, well-mixed 64-bit hash used for key schedule and round function
+static uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+FeistelPermutation::FeistelPermutation(uint128 domain_size, uint64_t key)
+    : m_domain(domain_size)
+{
+    // Bits needed to represent domain_size - 1, at least 2 so each half has one bit
+    unsigned bits = 0;
+    uint128 max_value = (domain_size > 0) ? domain_size - 1 : 0;
+    while (bits < 128 && (max_value >> bits) != 0)
+        ++bits;
+    if (bits < 2)
+        bits = 2;
+    m_half_bits = (bits + 1) / 2;
+    m_half_mask = (m_half_bits >= 64) ? ~0ULL : ((1ULL << m_half_bits) - 1);
+
+    uint64_t state = key;
+    for (int r = 0; r < kRounds; ++r)
+    {
+        state = splitmix64(state);
+        m_round_keys[r] = state;
+    }
+}
+
+uint64_t FeistelPermutation::round_function(uint64_t half, int round) const
+{
+    return splitmix64(half ^ m_round_keys[round]) & m_half_mask;
+}
+
+uint128 FeistelPermutation::encrypt(uint128 value) const
+{
+    uint64_t left = static_cast<uint64_t>(value >> m_half_bits) & m_half_mask;
+    uint64_t right = static_cast<uint64_t>(value) & m_half_mask;
+    for (int r = 0; r < kRounds; ++r)
+    {
+        uint64_t next_right = left ^ round_function(right, r);
+        left = right;
+        right = next_right;
+    }
+    return (static_cast<uint128>(left) << m_half_bits) | right;
+}
+
+uint128 FeistelPermutation::decrypt(uint128 value) const
+{
+    uint64_t left = static_cast<uint64_t>(value >> m_half_bits) & m_half_mask;
+    uint64_t right = static_cast<uint64_t>(value) & m_half_mask;
+    for (int r = kRounds; r-- > 0;)
+    {
+        uint64_t previous_left = right ^ round_function(left, r);
+        right = left;
+        left = previous_left;
+    }
+    return (static_cast<uint128>(left) << m_half_bits) | right;
+}
+
+uint128 FeistelPermutation::permute(uint128 counter) const
+{
+    if (m_domain <= 1)
+        return 0;
+    uint128 value = encrypt(counter);
+    while (value >= m_domain)
+        value = encrypt(value); // Cycle walking back into [0, domain)
+    return value;
+}
+
+uint128 FeistelPermutation::invert(uint128 rank) const
+{
+    if (m_domain <= 1)
+        return 0;
+    // Walking backwards through the same cycle stops at the counter permute() started from
+    uint128 value = decrypt(rank);
+    while (value >= m_domain)
+        value = decrypt(value);
+    return value;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint> // For uint64_t
+#include "uint128.h"
+
+// Keyed pseudo-random permutation of [0, domain_size) with O(1) memory.
+// A balanced Feistel network runs on the smallest even-width bit domain covering domain_size;
+// outputs falling outside the range are re-encrypted ("cycle walking") until they land inside,
+// which keeps the map a bijection on [0, domain_size). The covering domain is less than four
+// times larger, so the expected number of walks per call is below four.
+// Random mode maps a plain counter through this to get a shuffled rank, so any counter range
+// is a valid, disjoint slice of the shuffled order. Domains up to 2^128 are supported (halves of
+// up to 64 bits); below 2^64 the mapping is the same as with 64-bit arithmetic.
+class FeistelPermutation {
+public:
+    static constexpr int kRounds = 6;
+
+    FeistelPermutation(uint128 domain_size, uint64_t key);
+
+    // Maps counter (< domainSize()) to its shuffled rank (< domainSize()).
+    uint128 permute(uint128 counter) const;
+
+    // Inverse of permute(): the counter that visits `rank` (< domainSize()).
+    uint128 invert(uint128 rank) const;
+
+    uint128 domainSize() const { return m_domain; }
+
+private:
+    uint128 encrypt(uint128 value) const;
+    uint128 decrypt(uint128 value) const;
+    uint64_t round_function(uint64_t half, int round) const;
+
+    uint128 m_domain;
+    unsigned m_half_bits;     // Width of each Feistel half
+    uint64_t m_half_mask;
+    uint64_t m_round_keys[kRounds];
+};
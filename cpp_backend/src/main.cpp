@@ -1,5 +1,17 @@
 #include "brute_force.h" // Uses CrackingMode now
 #include "bloom_filter.h"// Include Bloom Filter header
+#include "wordlist.h"    // Line count sizes the skip list in wordlist mode
+#include "compiled_wordlist.h" // `wordlist compile` subcommand, compiled lists in wordlist mode
+#include "rule_engine.h"   // Rule count scales the skip list estimate
+#include "combinator.h"    // Combinator / hybrid size scales the skip list estimate
+#include "markov_model.h"  // `markov train` subcommand
+#include "pcfg.h"          // `pcfg train` subcommand, guess count sizes the skip list
+#include "typo_neighborhood.h" // Neighbourhood size sizes the skip list for --typo
+#include "common_passwords.h" // Pre-pass words are added to the skip list estimate
+#include "archive_tokens.h"   // Archive metadata pre-pass bound for the skip list estimate
+#include "run_state.h"        // `state show` subcommand
+#include "candidate_batch.h"  // `selftest` subcommand
+#include "coordinator.h"      // `coordinate` / `work` subcommands
 #include <iostream>
 #include <string>
 #include <vector>
@@ -7,8 +19,9 @@
 #include <cstdio>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>   // For uint16_t (coordinator port)
 #include <mutex>     // Include mutex for Bloom Filter access
-#include <limits>    // For numeric_limits
+#include <random>    // For std::random_device (default worker name)
 
 // Platform-specific includes
 #ifdef _WIN32
@@ -137,23 +150,272 @@ bool check_executable(const std::string& path) {
 #endif
 }
 
+// Skip list capacity for --pcfg (~115 MB at 1% FP); large grammars are never run to the end
+static const uint64_t kMaxPcfgFilterItems = 100000000;
+
+// Slot index for --custom-charsetN / -N (N = 1..4), or -1 if `arg` is neither
+static int custom_charset_slot(const std::string& arg) {
+    for (int n = 1; n <= kCustomCharsetSlots; ++n) {
+        if (arg == "--custom-charset" + std::to_string(n) || arg == "-" + std::to_string(n))
+            return n - 1;
+    }
+    return -1;
+}
+
+// Character class of --min-<class> / --max-<class> ("lower", "upper", "digits", "symbols"), or -1
+static int constraint_class(const std::string& arg, const std::string& prefix) {
+    static const char* names[PasswordConstraints::kNumClasses] = {"lower", "upper", "digits", "symbols"};
+    for (int k = 0; k < PasswordConstraints::kNumClasses; ++k) {
+        if (arg == prefix + names[k])
+            return k;
+    }
+    return -1;
+}
+
+// Non-negative integer option value; warns and returns false if `text` is not one
+static bool parse_constraint_value(const std::string& option, const char* text, int& out) {
+    try {
+        size_t consumed = 0;
+        int value = std::stoi(text, &consumed);
+        if (consumed != std::string(text).size() || value < 0) throw std::invalid_argument("not a non-negative integer");
+        out = value;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "WARN: Invalid value for " << option << " ('" << text << "'), ignoring it. Error: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+// `wordlist compile <input> <output> [--frequency] [--memory <MB>]`
+// Exit codes: 0 compiled, 2 argument error, 5 compile failure.
+static int run_wordlist_command(int argc, char *argv[]) {
+    if (argc < 5 || std::string(argv[2]) != "compile") {
+        std::cerr << "Usage: " << argv[0] << " wordlist compile <input.txt> <output> [--frequency] [--memory <MB>]" << std::endl;
+        return 2;
+    }
+    bool frequency_order = false;
+    uint64_t memory_mb = 512;
+    for (int i = 5; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--frequency") {
+            frequency_order = true;
+        } else if (arg == "--memory" && i + 1 < argc) {
+            try {
+                memory_mb = std::stoull(argv[++i]);
+            } catch (const std::exception& e) {
+                std::cerr << "WARN: Invalid memory value ('" << argv[i] << "'), using 512 MB. Error: " << e.what() << std::endl;
+                memory_mb = 512;
+            }
+        } else {
+            std::cerr << "WARN: Ignoring unknown or misplaced optional argument: '" << arg << "'" << std::endl;
+        }
+    }
+    update_output("INFO: Compiling wordlist " + std::string(argv[3]) + " -> " + argv[4] + " (sort memory " + std::to_string(memory_mb) + " MB)");
+    std::string error;
+    if (!compile_wordlist(argv[3], argv[4], frequency_order, memory_mb * 1024 * 1024, error)) {
+        update_output("ERROR: " + error);
+        return 5;
+    }
+    return 0;
+}
+
+
+// `state show <file.state>`: what a (possibly dead) run covered and which positions are still untested,
+// as --start-index/--end-index pairs another instance can take over.
+// Exit codes: 0 shown, 2 argument error, 5 unreadable state file.
+static int run_state_command(int argc, char *argv[]) {
+    if (argc < 4 || std::string(argv[2]) != "show") {
+        std::cerr << "Usage: " << argv[0] << " state show <file.state>" << std::endl;
+        return 2;
+    }
+    RunState state;
+    if (!state.load(argv[3])) {
+        update_output("ERROR: Cannot read run state file: " + std::string(argv[3]));
+        return 5;
+    }
+    uint128 untested = 0;
+    const std::vector<SliceProgress> remaining = state.remaining();
+    for (const auto& range : remaining)
+        untested += range.end - range.begin;
+    update_output("INFO: Job " + state.job_key + ", " + (state.order.empty() ? std::string("unknown order") : state.order) +
+                  (state.shard.empty() ? std::string() : ", shard " + state.shard) + ", positions " + to_string(state.range_begin) +
+                  " to " + to_string(state.range_end) + " of " + to_string(state.domain) + ", seed " + std::to_string(state.seed) + ".");
+    update_output("INFO: " + to_string(untested) + " positions untested in " + std::to_string(remaining.size()) + " range(s).");
+    if (state.order == "PCFG order") {
+        // PCFG slices count interleaved guesses, not positions
+        update_output("INFO: Continue with the same arguments (and --shard) and this state file as <skip-file>.state.");
+        return 0;
+    }
+    const std::string seed = state.order == "random order" ? " --seed " + std::to_string(state.seed) : std::string();
+    for (const auto& range : remaining)
+        update_output("INFO:   --start-index " + to_string(range.begin) + " --end-index " + to_string(range.end) + seed);
+    return 0;
+}
+
+
+// `selftest`: built-in checks that need no archive (UTF-8 to UTF-16LE candidate view)
+// Exit codes: 0 passed, 5 a check failed.
+static int run_selftest_command() {
+    if (!CandidateBatch::utf16leSelfCheck()) {
+        update_output("ERROR: Self-check failed: UTF-16LE candidate view.");
+        return 5;
+    }
+    update_output("INFO: Self-check passed.");
+    return 0;
+}
+
+
+// `markov train <corpus.txt> <model>`: per-position bigram levels for --markov
+// Exit codes: 0 trained, 2 argument error, 5 training failure.
+static int run_markov_command(int argc, char *argv[]) {
+    if (argc < 5 || std::string(argv[2]) != "train") {
+        std::cerr << "Usage: " << argv[0] << " markov train <corpus.txt> <model>" << std::endl;
+        return 2;
+    }
+    update_output("INFO: Training Markov model " + std::string(argv[3]) + " -> " + argv[4]);
+    std::string error;
+    if (!train_markov_model(argv[3], argv[4], error)) {
+        update_output("ERROR: " + error);
+        return 5;
+    }
+    return 0;
+}
+
+
+// `pcfg train <corpus.txt> <grammar> [--max-terminals <n>]`: structures and terminals for --pcfg
+// Exit codes: 0 trained, 2 argument error, 5 training failure.
+static int run_pcfg_command(int argc, char *argv[]) {
+    if (argc < 5 || std::string(argv[2]) != "train") {
+        std::cerr << "Usage: " << argv[0] << " pcfg train <corpus.txt> <grammar> [--max-terminals <n>]" << std::endl;
+        return 2;
+    }
+    int max_terminals = 0;
+    for (int i = 5; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-terminals" && i + 1 < argc) {
+            parse_constraint_value(arg, argv[++i], max_terminals);
+        } else {
+            std::cerr << "WARN: Ignoring unknown or misplaced optional argument: '" << arg << "'" << std::endl;
+        }
+    }
+    update_output("INFO: Training PCFG grammar " + std::string(argv[3]) + " -> " + argv[4]);
+    std::string error;
+    if (!train_pcfg_grammar(argv[3], argv[4], static_cast<size_t>(max_terminals), error)) {
+        update_output("ERROR: " + error);
+        return 5;
+    }
+    return 0;
+}
+
+
+// The cracking run: `<charset> <min_length> <max_length> <archive_path> <mode> [options...]`.
+// Exit codes: 0 found, 1 not found, 2 argument error, 3 7z not found, 4 path error.
+// `lease_run` (coordinator workers) also receives the password and the main phase's size.
+static int run_crack_command(int argc, char *argv[], LeaseRun *lease_run = nullptr) {
+    // A worker runs one lease after another in this process
+    skipListFilePath.clear();
+    checkpointIntervalSeconds = 0;
 
-int main(int argc, char *argv[]) {
     // --- Argument Parsing ---
     if (argc < 6) {
         std::cerr << "ERROR: Insufficient arguments." << std::endl;
         std::cerr << "Usage: " << (argc > 0 ? argv[0] : "ArchivePasswordCrackerCLI")
                   << " <charset> <min_length> <max_length> <archive_path> <ascending|descending|random>"
-                  << " [--skip-file <path>] [--checkpoint-interval <seconds>]" << std::endl;
+                  << " [--skip-file <path>] [--checkpoint-interval <seconds>] [--stop-file <path>] [--pattern <pattern>] [--wordlist <file> [--rules <file> | --combinator <file> | --hybrid-append <mask> | --hybrid-prepend <mask>]] [--markov <model> [--markov-threshold <level sum>]] [--pcfg <grammar>] [--typo <guess> ... [--typo-distance <k>] [--typo-keyboard]] [--common-passwords] [--archive-tokens] [--seed <number>]"
+                  << " [--start-index <n>] [--end-index <n>] [--resume-from <password>] [--shard <i>/<N>]"
+                  << " [--custom-charset1..4 <chars>] [--increment]"
+                  << " [--min-lower|--min-upper|--min-digits|--min-symbols <n>] [--max-lower|--max-upper|--max-digits|--max-symbols <n>]"
+                  << " [--require-one-of <chars>] [--max-repeat <n>] [--forbid <substring>]" << std::endl;
+        std::cerr << "       " << (argc > 0 ? argv[0] : "ArchivePasswordCrackerCLI")
+                  << " coordinate <port> [--bind <address>] [--lease <positions>] [--lease-timeout <seconds>] -- <job arguments>" << std::endl;
+        std::cerr << "       " << (argc > 0 ? argv[0] : "ArchivePasswordCrackerCLI")
+                  << " work <host>:<port> [--name <name>] [--archive <path>] [--stop-file <path>] [--heartbeat <seconds>]" << std::endl;
         update_output("ERROR: Invalid number of required arguments provided to C++ backend. Expected at least 5.");
         return 2; // Argument error exit code
     }
 
-    std::string pattern; // Declare pattern variable
+    CrackOptions options;
+    std::string& pattern = options.pattern;
     for (int i = 6; i < argc; ++i) {
         std::string arg = argv[i];
         if ((arg == "--pattern" || arg == "-p") && i + 1 < argc) {
             pattern = argv[++i];
+        } else if ((arg == "--wordlist" || arg == "-w") && i + 1 < argc) {
+            options.wordlist_path = argv[++i];
+        } else if ((arg == "--rules" || arg == "-r") && i + 1 < argc) {
+            options.rules_path = argv[++i];
+        } else if (arg == "--combinator" && i + 1 < argc) {
+            options.combinator_path = argv[++i];
+        } else if ((arg == "--hybrid-append" || arg == "--hybrid-prepend") && i + 1 < argc) {
+            options.hybrid_mask = argv[++i];
+            options.hybrid_prepend = (arg == "--hybrid-prepend");
+        } else if (arg == "--pcfg" && i + 1 < argc) {
+            options.pcfg_path = argv[++i];
+        } else if (arg == "--typo" && i + 1 < argc) {
+            options.typo_bases.push_back(argv[++i]); // Repeatable
+        } else if (arg == "--typo-distance" && i + 1 < argc) {
+            parse_constraint_value(arg, argv[++i], options.typo_distance);
+        } else if (arg == "--typo-keyboard") {
+            options.typo_keyboard = true;
+        } else if (arg == "--common-passwords") {
+            options.common_passwords = true;
+        } else if (arg == "--archive-tokens") {
+            options.archive_tokens = true;
+        } else if (arg == "--markov" && i + 1 < argc) {
+            options.markov_path = argv[++i];
+        } else if (arg == "--markov-threshold" && i + 1 < argc) {
+            parse_constraint_value(arg, argv[++i], options.markov_threshold);
+        } else if (custom_charset_slot(arg) >= 0 && i + 1 < argc) {
+            // Charset for ?N in the pattern, may itself use ?l ?u ?d ?s ?a
+            options.custom_charsets[custom_charset_slot(arg)] = expand_charset_spec(argv[++i]);
+        } else if (arg == "--increment" || arg == "-i") {
+            options.increment = true;
+        } else if (constraint_class(arg, "--min-") >= 0 && i + 1 < argc) {
+            parse_constraint_value(arg, argv[++i], options.constraints.min_count[constraint_class(arg, "--min-")]);
+        } else if (constraint_class(arg, "--max-") >= 0 && i + 1 < argc) {
+            parse_constraint_value(arg, argv[++i], options.constraints.max_count[constraint_class(arg, "--max-")]);
+        } else if (arg == "--require-one-of" && i + 1 < argc) {
+            // Repeatable; the set may use ?l ?u ?d ?s ?a like a custom charset
+            std::string chars = expand_charset_spec(argv[++i]);
+            if (!chars.empty())
+                options.constraints.required_sets.push_back(chars);
+        } else if (arg == "--max-repeat" && i + 1 < argc) {
+            parse_constraint_value(arg, argv[++i], options.constraints.max_repeat);
+        } else if (arg == "--forbid" && i + 1 < argc) {
+            options.constraints.forbidden.push_back(argv[++i]); // Repeatable
+        } else if (arg == "--seed" && i + 1 < argc) {
+            try {
+                size_t consumed = 0;
+                std::string value = argv[++i];
+                options.seed = std::stoull(value, &consumed, 0);
+                if (consumed != value.size()) throw std::invalid_argument("trailing characters");
+                options.has_seed = true;
+            } catch (const std::exception& e) {
+                std::cerr << "WARN: Invalid seed value ('" << argv[i] << "'), using a random seed. Error: " << e.what() << std::endl;
+                options.has_seed = false;
+            }
+        } else if ((arg == "--start-index" || arg == "--end-index") && i + 1 < argc) {
+            // Positions in the run order; a bad value must not silently widen the range
+            if (!parse_uint128(argv[++i], arg == "--start-index" ? options.start_index : options.end_index)) {
+                update_output("ERROR: Invalid " + arg + " value ('" + std::string(argv[i]) + "'). Expected a non-negative integer.");
+                return 2;
+            }
+        } else if (arg == "--resume-from" && i + 1 < argc) {
+            options.resume_from = argv[++i];
+        } else if (arg == "--shard" && i + 1 < argc) {
+            // i/N with 0 <= i < N: this instance runs piece i of every phase
+            std::string value = argv[++i];
+            size_t slash = value.find('/');
+            uint128 index = 0, count = 0;
+            if (slash == std::string::npos || !parse_uint128(value.substr(0, slash), index) || !parse_uint128(value.substr(slash + 1), count)
+                || count == 0 || count > 1000000 || index >= count) {
+                update_output("ERROR: Invalid --shard value ('" + value + "'). Expected i/N with 0 <= i < N <= 1000000.");
+                return 2;
+            }
+            options.shard_index = static_cast<unsigned>(index);
+            options.shard_count = static_cast<unsigned>(count);
+        } else if (arg == "--stop-file" && i + 1 < argc) {
+            options.stop_flag_path = argv[++i]; // Instead of <skip-file>.stop
         } else if ((arg == "--skip-file" || arg == "-s") && i + 1 < argc) {
             skipListFilePath = argv[++i];
         } else if ((arg == "--checkpoint-interval" || arg == "-c") && i + 1 < argc) {
@@ -174,6 +436,33 @@ int main(int argc, char *argv[]) {
     if (!pattern.empty()) {
         update_output("INFO: Using pattern: " + pattern);
     }
+    if (!options.rules_path.empty() && options.wordlist_path.empty()) {
+        update_output("WARN: --rules only applies to --wordlist; ignoring it.");
+    }
+    if ((!options.combinator_path.empty() || !options.hybrid_mask.empty()) && options.wordlist_path.empty()) {
+        update_output("WARN: --combinator and --hybrid-append/--hybrid-prepend need --wordlist as the first half; ignoring them.");
+    }
+    if (options.typo_distance > TypoNeighborhood::kMaxDistance) {
+        update_output("WARN: --typo-distance is limited to " + std::to_string(TypoNeighborhood::kMaxDistance) + "; using that.");
+        options.typo_distance = TypoNeighborhood::kMaxDistance;
+    }
+    if (!options.resume_from.empty() && options.start_index != 0) {
+        update_output("ERROR: --resume-from and --start-index both set the start position; use one of them.");
+        return 2;
+    }
+    if (options.start_index >= options.end_index) {
+        update_output("ERROR: --start-index must be below --end-index.");
+        return 2;
+    }
+    if (!options.constraints.empty()) {
+        update_output("INFO: Password constraints active; candidates violating them are pruned, not tested.");
+    }
+    if (!skipListFilePath.empty()) {
+        // Stop flag and run state live next to the skip list, even if the filter gets disabled below
+        if (options.stop_flag_path.empty())
+            options.stop_flag_path = skipListFilePath + ".stop";
+        options.state_path = skipListFilePath + ".state";
+    }
     std::string charset = argv[1];
     int min_length = 0;
     int max_length = 0;
@@ -221,6 +510,11 @@ int main(int argc, char *argv[]) {
         return 2;
     }
 
+    if (options.shard_count > 1 && crack_mode == CrackingMode::RANDOM_LCG && !options.has_seed) {
+        update_output("ERROR: --shard in random mode needs --seed, so that every shard splits the same shuffled order.");
+        return 2;
+    }
+
     // --- Parse Optional Arguments ---
 
     // --- Find 7z executable --- (MODIFIED BLOCK STARTS HERE) ---
@@ -350,34 +644,90 @@ int main(int argc, char *argv[]) {
             }
 
             // Calculate estimated items ONLY for the target range min_length..max_length
-            uint64_t estimated_items_in_range = 0;
+            // 128-bit: long lengths of a large charset exceed 2^64 but are still rejected by size below, not by overflow
+            uint128 estimated_items_in_range = 0;
             uint64_t cs = static_cast<uint64_t>(charset.size());
             bool overflow_occurred = false;
 
-            if (cs > 0)
+            if (!options.pcfg_path.empty())
+            {
+                // PCFG runs are stopped long before a large grammar is exhausted: cap the estimate
+                PcfgGrammar grammar;
+                std::string open_error;
+                if (grammar.load(options.pcfg_path, open_error))
+                    estimated_items_in_range = std::min<uint64_t>(grammar.guesses(), kMaxPcfgFilterItems);
+                else
+                {
+                    update_output("ERROR: " + open_error);
+                    overflow_occurred = true;
+                }
+            }
+            else if (!options.typo_bases.empty())
+            {
+                // The neighbourhood is small enough to build twice; its size is exact
+                TypoNeighborhood neighborhood;
+                std::string typo_error;
+                if (neighborhood.build(options.typo_bases, charset, options.typo_distance, options.typo_keyboard, min_length, max_length, typo_error))
+                    estimated_items_in_range = neighborhood.size();
+                else
+                {
+                    update_output("ERROR: " + typo_error);
+                    overflow_occurred = true;
+                }
+            }
+            else if (!options.wordlist_path.empty())
+            {
+                // Every line (or compiled word) is at most one candidate
+                Wordlist wordlist;
+                CompiledWordlist compiled;
+                std::string open_error;
+                if (CompiledWordlist::isCompiled(options.wordlist_path) && compiled.open(options.wordlist_path, open_error))
+                    estimated_items_in_range = compiled.size();
+                else if (open_error.empty() && wordlist.open(options.wordlist_path, open_error))
+                    estimated_items_in_range = wordlist.countLines();
+                else
+                {
+                    update_output("ERROR: " + open_error);
+                    overflow_occurred = true;
+                }
+                // With rules every word yields up to one candidate per rule
+                RuleSet rules;
+                if (!overflow_occurred && !options.rules_path.empty() && rules.load(options.rules_path, open_error))
+                {
+                    if (!checked_mul(estimated_items_in_range, rules.size(), estimated_items_in_range))
+                        overflow_occurred = true;
+                }
+                // Combinator / hybrid: every word joined with every element of the second half
+                ComponentList components;
+                if (!overflow_occurred && (!options.combinator_path.empty() || !options.hybrid_mask.empty()) &&
+                    open_combination_side(options, charset, max_length, components, open_error) && components.size() > 0)
+                {
+                    if (!checked_mul(estimated_items_in_range, components.size(), estimated_items_in_range))
+                        overflow_occurred = true;
+                }
+            }
+            else if (cs > 0)
             {
                 for (int len = min_length; len <= max_length; ++len)
                 {
-                    uint64_t combinations_this_len = 1;
+                    uint128 combinations_this_len = 1;
                     for (int i = 0; i < len; ++i)
                     {
-                        if (combinations_this_len > std::numeric_limits<uint64_t>::max() / cs)
+                        if (!checked_mul(combinations_this_len, cs, combinations_this_len))
                         {
                             overflow_occurred = true;
                             update_output("ERROR: Overflow calculating combinations for length " + std::to_string(len) + ".");
                             break;
                         }
-                        combinations_this_len *= cs;
                     }
                     if (overflow_occurred)
                         break;
-                    if (estimated_items_in_range > std::numeric_limits<uint64_t>::max() - combinations_this_len)
+                    if (!checked_add(estimated_items_in_range, combinations_this_len, estimated_items_in_range))
                     {
                         overflow_occurred = true;
                         update_output("ERROR: Overflow calculating total estimated items in range.");
                         break;
                     }
-                    estimated_items_in_range += combinations_this_len;
                 }
             }
             else
@@ -385,6 +735,11 @@ int main(int argc, char *argv[]) {
                 update_output("WARN: Charset size is zero, cannot estimate items for Bloom filter.");
                 overflow_occurred = true;
             }
+            // The pre-passes add at most the whole embedded list and the metadata guess cap
+            const uint64_t prepass_items = (options.common_passwords ? common_password_count() : 0) +
+                                           (options.archive_tokens ? kMaxArchiveTokenGuesses : 0);
+            if (!overflow_occurred)
+                checked_add(estimated_items_in_range, prepass_items, estimated_items_in_range);
 
             if (overflow_occurred)
             {
@@ -401,15 +756,16 @@ int main(int argc, char *argv[]) {
                 { // Avoid division by zero or log(0) issues
                     m_exact_check = -(static_cast<double>(estimated_items_in_range) * std::log(fp_rate)) / (std::log(2.0) * std::log(2.0));
                 }
-                uint64_t tentative_num_bits = static_cast<uint64_t>(std::ceil(m_exact_check));
+                // Clamped so the conversion stays defined near 2^128; anything that large is rejected below
+                uint128 tentative_num_bits = static_cast<uint128>(std::ceil(std::min(m_exact_check, 1e38)));
                 if (tentative_num_bits < 8)
                     tentative_num_bits = 8; // Apply min size
 
                 // Define a reasonable memory limit (e.g., 4GB for the bit vector)
                 const uint64_t MAX_FILTER_BITS = 4ULL * 1024 * 1024 * 1024 * 8; // 4 Gigabytes in bits
                 // Calculate required MB for logging
-                uint64_t required_bytes = (tentative_num_bits + 7) / 8;
-                uint64_t required_mb = required_bytes / (1024 * 1024);
+                uint128 required_bytes = (tentative_num_bits + 7) / 8;
+                uint128 required_mb = required_bytes / (1024 * 1024);
 
                 if (tentative_num_bits == 0 || estimated_items_in_range == 0)
                 {
@@ -418,17 +774,17 @@ int main(int argc, char *argv[]) {
                 }
                 else if (tentative_num_bits > MAX_FILTER_BITS)
                 {
-                    update_output("ERROR: Required Bloom filter size (" + std::to_string(required_mb) + " MB for " + std::to_string(tentative_num_bits) + " bits) exceeds limit (" + std::to_string(MAX_FILTER_BITS / 8 / (1024 * 1024)) + " MB). Disabling skip list.");
+                    update_output("ERROR: Required Bloom filter size (" + to_string(required_mb) + " MB for " + to_string(tentative_num_bits) + " bits) exceeds limit (" + std::to_string(MAX_FILTER_BITS / 8 / (1024 * 1024)) + " MB). Disabling skip list.");
                     skipListFilePath = ""; // Disable skip list BEFORE allocation attempt
                 }
                 else
                 {
                     // Proceed with filter creation only if size is acceptable
-                    update_output("INFO: Initializing new Bloom filter for approx. " + std::to_string(estimated_items_in_range) + " items with FP rate ~" + std::to_string(fp_rate) + " (Requires ~" + std::to_string(required_mb) + " MB)");
+                    update_output("INFO: Initializing new Bloom filter for approx. " + to_string(estimated_items_in_range) + " items with FP rate ~" + std::to_string(fp_rate) + " (Requires ~" + to_string(required_mb) + " MB)");
                     try
                     {
                         // Now actually create the filter
-                        skipFilter = BloomFilter(estimated_items_in_range, fp_rate);
+                        skipFilter = BloomFilter(static_cast<uint64_t>(estimated_items_in_range), fp_rate); // Fits: size checked above
                         if (skipFilter.isValid())
                         {
                             update_output("INFO: New filter created. Bits: " + std::to_string(skipFilter.getNumBits()) + ", Hashes: " + std::to_string(skipFilter.getNumHashes()));
@@ -442,7 +798,7 @@ int main(int argc, char *argv[]) {
                     }
                     catch (const std::bad_alloc &)
                     {
-                        update_output("ERROR: Memory allocation failed for Bloom filter (" + std::to_string(required_mb) + " MB requested). Disabling skip list.");
+                        update_output("ERROR: Memory allocation failed for Bloom filter (" + to_string(required_mb) + " MB requested). Disabling skip list.");
                         skipListFilePath = ""; // Disable on allocation failure
                     }
                     catch (const std::exception &e)
@@ -465,14 +821,22 @@ int main(int argc, char *argv[]) {
     }
 
     // --- Run Brute Force ---
+    uint128 phase_domain = kUint128Max;
+    options.phase_domain = &phase_domain;
     std::string found_pwd = brute_force_worker_combined(
         charset, min_length, max_length, archivePath, crack_mode,
         skipListFilePath.empty() ? nullptr : &skipFilter,
         skipListFilePath.empty() ? nullptr : &skipFilterMutex,
         checkpointIntervalSeconds,
-        pattern
+        options
     );
 
+    if (lease_run) {
+        lease_run->password = found_pwd;
+        lease_run->domain_known = phase_domain != kUint128Max;
+        lease_run->domain = phase_domain;
+    }
+
     // --- Report Result to Python ---
     if (!found_pwd.empty()) {
          // Output the special FOUND marker ONLY if found
@@ -485,4 +849,126 @@ int main(int argc, char *argv[]) {
          update_output("INFO: Password not found within the specified constraints.");
          return 1; // Failure - Not Found (within range)
     }
-}
\ No newline at end of file
+}
+
+
+// `coordinate <port> [--bind <address>] [--lease <positions>] [--lease-timeout <seconds>] -- <job arguments>`:
+// hands out leases of the job's positions to `work` processes, see coordinator.h.
+// Exit codes: 0 found, 1 not found, 2 argument error, 5 the job failed on a worker, 6 network error.
+static int run_coordinate_command(int argc, char *argv[]) {
+    CoordinatorOptions options;
+    int port = -1;
+    int i = 2;
+    if (i < argc && std::string(argv[i]) != "--") {
+        try { port = std::stoi(argv[i++]); } catch (const std::exception&) { port = -1; }
+    }
+    for (; i < argc && std::string(argv[i]) != "--"; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bind" && i + 1 < argc) {
+            options.bind_address = argv[++i];
+        } else if (arg == "--lease" && i + 1 < argc) {
+            if (!parse_uint128(argv[++i], options.lease_size) || options.lease_size == 0) {
+                update_output("ERROR: Invalid --lease value ('" + std::string(argv[i]) + "'). Expected a positive integer.");
+                return 2;
+            }
+        } else if (arg == "--lease-timeout" && i + 1 < argc) {
+            if (!parse_constraint_value(arg, argv[++i], options.lease_timeout_seconds) || options.lease_timeout_seconds == 0) {
+                update_output("ERROR: --lease-timeout needs a positive number of seconds.");
+                return 2;
+            }
+        } else {
+            std::cerr << "WARN: Ignoring unknown coordinator argument: '" << arg << "'" << std::endl;
+        }
+    }
+    if (port < 0 || port > 65535 || i >= argc) {
+        std::cerr << "Usage: " << argv[0] << " coordinate <port> [--bind <address>] [--lease <positions>] [--lease-timeout <seconds>]"
+                  << " -- <charset> <min_length> <max_length> <archive_path> <mode> [options...]" << std::endl;
+        return 2;
+    }
+    options.port = static_cast<uint16_t>(port);
+    options.job_args.assign(argv + i + 1, argv + argc);
+    return run_coordinator(options);
+}
+
+// `work <host>:<port> [--name <name>] [--archive <path>] [--stop-file <path>] [--heartbeat <seconds>]`:
+// runs leases from a coordinator through the normal cracking path until the job ends.
+// Exit codes: 0 found here, 1 the job ended without a hit here (or the stop file), 5 the job failed, 6 network error.
+static int run_work_command(int argc, char *argv[]) {
+    WorkerOptions options;
+    std::string address = argc >= 3 ? argv[2] : "";
+    size_t colon = address.rfind(':');
+    int port = -1;
+    if (colon != std::string::npos) {
+        options.host = address.substr(0, colon);
+        try { port = std::stoi(address.substr(colon + 1)); } catch (const std::exception&) { port = -1; }
+    }
+    if (options.host.empty() || port <= 0 || port > 65535) {
+        std::cerr << "Usage: " << argv[0] << " work <host>:<port> [--name <name>] [--archive <path>] [--stop-file <path>] [--heartbeat <seconds>]" << std::endl;
+        return 2;
+    }
+    options.port = static_cast<uint16_t>(port);
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            options.name = argv[++i];
+        } else if (arg == "--archive" && i + 1 < argc) {
+            options.archive_path = argv[++i];
+        } else if (arg == "--stop-file" && i + 1 < argc) {
+            options.stop_file = argv[++i];
+        } else if (arg == "--heartbeat" && i + 1 < argc) {
+            if (!parse_constraint_value(arg, argv[++i], options.heartbeat_seconds) || options.heartbeat_seconds == 0) {
+                update_output("ERROR: --heartbeat needs a positive number of seconds.");
+                return 2;
+            }
+        } else {
+            std::cerr << "WARN: Ignoring unknown worker argument: '" << arg << "'" << std::endl;
+        }
+    }
+    if (options.name.empty()) {
+        std::random_device device;
+        char name[32];
+        std::snprintf(name, sizeof(name), "worker-%08x", static_cast<unsigned>(device()));
+        options.name = name;
+    }
+    if (options.stop_file.empty())
+        options.stop_file = options.name + ".stop";
+
+    const std::string program = argv[0];
+    return run_worker(options, [&program](const std::vector<std::string>& args) {
+        std::vector<std::string> storage(1, program);
+        storage.insert(storage.end(), args.begin(), args.end());
+        std::vector<char*> lease_argv;
+        for (auto& arg : storage)
+            lease_argv.push_back(&arg[0]);
+        lease_argv.push_back(nullptr);
+        LeaseRun run;
+        run.exit_code = run_crack_command(static_cast<int>(storage.size()), lease_argv.data(), &run);
+        return run;
+    });
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && std::string(argv[1]) == "wordlist") {
+        return run_wordlist_command(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "markov") {
+        return run_markov_command(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "pcfg") {
+        return run_pcfg_command(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "state") {
+        return run_state_command(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "selftest") {
+        return run_selftest_command();
+    }
+    if (argc >= 2 && std::string(argv[1]) == "coordinate") {
+        return run_coordinate_command(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "work") {
+        return run_work_command(argc, argv);
+    }
+    return run_crack_command(argc, argv);
+}
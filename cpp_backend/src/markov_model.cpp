@@ -0,0 +1,384 @@
+#include "markov_model.h"
+#include "candidate_batch.h"
+#include "wordlist.h"
+#include <algorithm> // For std::upper_bound, std::min
+#include <cmath>     // For std::log2, std::floor
+#include <cstring>   // For std::memcmp
+#include <fstream>
+#include <limits>    // For std::numeric_limits
+
+extern void update_output(const std::string &message); // Defined in main.cpp
+
+static const char kMagic[8] = {'A', 'P', 'C', 'M', 'A', 'R', 'K', 'V'};
+static const uint32_t kVersion = 1;
+static const size_t kHeaderSize = 24;
+static const size_t kTableSize =
+    static_cast<size_t>(MarkovModel::kPositions) * (MarkovModel::kAlphabet + 1) * MarkovModel::kAlphabet;
+
+// --- Little-endian field access ---
+static uint32_t read_u32(const char *p)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i)
+        value = (value << 8) | static_cast<unsigned char>(p[i]);
+    return value;
+}
+
+static void put_u32(std::string &out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+static uint64_t saturating_add(uint64_t a, uint64_t b)
+{
+    return (a > std::numeric_limits<uint64_t>::max() - b) ? std::numeric_limits<uint64_t>::max() : a + b;
+}
+
+bool MarkovModel::train(const std::string &corpus_path, std::string &error)
+{
+    Wordlist corpus;
+    if (!corpus.open(corpus_path, error))
+        return false;
+
+    std::vector<uint64_t> counts(kTableSize, 0);
+    std::vector<int> symbols;
+    WordlistReader reader(corpus, 0, corpus.size(), 1, 255);
+    std::string_view word;
+    uint64_t offset = 0;
+    m_words = 0;
+    while (reader.next(word, offset))
+    {
+        symbols.clear();
+        for (char c : word)
+        {
+            int s = symbol(static_cast<unsigned char>(c));
+            if (s < 0)
+                break;
+            symbols.push_back(s);
+        }
+        if (symbols.size() != word.size())
+            continue;
+        int previous = kAlphabet;
+        for (size_t i = 0; i < symbols.size(); ++i)
+        {
+            const size_t table = std::min(i, static_cast<size_t>(kPositions - 1));
+            ++counts[(table * (kAlphabet + 1) + previous) * kAlphabet + symbols[i]];
+            previous = symbols[i];
+        }
+        ++m_words;
+    }
+    if (m_words == 0)
+    {
+        error = "No usable training words (printable ASCII) in: " + corpus_path;
+        return false;
+    }
+
+    // Laplace smoothing keeps unseen transitions possible; they land on high levels
+    m_levels.assign(kTableSize, 0);
+    for (size_t row = 0; row < kTableSize / kAlphabet; ++row)
+    {
+        const uint64_t *row_counts = counts.data() + row * kAlphabet;
+        uint64_t row_total = 0;
+        for (int c = 0; c < kAlphabet; ++c)
+            row_total += row_counts[c];
+        for (int c = 0; c < kAlphabet; ++c)
+        {
+            const double p = (static_cast<double>(row_counts[c]) + 1.0) / (static_cast<double>(row_total) + kAlphabet);
+            const double level = std::floor(-std::log2(p));
+            m_levels[row * kAlphabet + c] = static_cast<uint8_t>(std::min(level, static_cast<double>(kLevels - 1)));
+        }
+    }
+    return true;
+}
+
+bool MarkovModel::load(const std::string &path, std::string &error)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+    {
+        error = "Cannot open Markov model: " + path;
+        return false;
+    }
+    char header[kHeaderSize] = {};
+    if (!ifs.read(header, kHeaderSize) || std::memcmp(header, kMagic, sizeof(kMagic)) != 0)
+    {
+        error = "Not a Markov model file (use `markov train`): " + path;
+        return false;
+    }
+    if (read_u32(header + 8) != kVersion || read_u32(header + 12) != kPositions || read_u32(header + 16) != kAlphabet ||
+        read_u32(header + 20) != kLevels)
+    {
+        error = "Unsupported Markov model version or dimensions: " + path;
+        return false;
+    }
+    m_levels.assign(kTableSize, 0);
+    if (!ifs.read(reinterpret_cast<char *>(m_levels.data()), static_cast<std::streamsize>(kTableSize)))
+    {
+        error = "Truncated Markov model: " + path;
+        m_levels.clear();
+        return false;
+    }
+    for (uint8_t level : m_levels)
+    {
+        if (level >= kLevels)
+        {
+            error = "Corrupt Markov model (level out of range): " + path;
+            m_levels.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MarkovModel::save(const std::string &path, std::string &error) const
+{
+    std::string header(kMagic, sizeof(kMagic));
+    put_u32(header, kVersion);
+    put_u32(header, kPositions);
+    put_u32(header, kAlphabet);
+    put_u32(header, kLevels);
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs || !ofs.write(header.data(), static_cast<std::streamsize>(header.size())) ||
+        !ofs.write(reinterpret_cast<const char *>(m_levels.data()), static_cast<std::streamsize>(m_levels.size())))
+    {
+        error = "Cannot write Markov model: " + path;
+        return false;
+    }
+    return true;
+}
+
+int MarkovModel::level(int position, int previous, unsigned char next) const
+{
+    const int s = symbol(next);
+    const int p = (previous < 0) ? kAlphabet : symbol(static_cast<unsigned char>(previous));
+    if (s < 0 || p < 0 || m_levels.empty())
+        return kLevels - 1;
+    const size_t table = static_cast<size_t>(std::min(position, kPositions - 1));
+    return m_levels[(table * (kAlphabet + 1) + static_cast<size_t>(p)) * kAlphabet + static_cast<size_t>(s)];
+}
+
+bool train_markov_model(const std::string &corpus_path, const std::string &model_path, std::string &error)
+{
+    MarkovModel model;
+    if (!model.train(corpus_path, error))
+        return false;
+    if (!model.save(model_path, error))
+        return false;
+    update_output("INFO: Markov model trained on " + std::to_string(model.trainedWords()) + " words and saved to " + model_path);
+    return true;
+}
+
+// ================================================================
+// ===                       MARKOV PLAN                        ===
+// ================================================================
+
+bool MarkovPlan::compile(const MarkovModel &model, const std::string &charset, int min_length, int max_length, int max_level_sum)
+{
+    *this = MarkovPlan();
+    if (charset.empty() || min_length < 1 || max_length < min_length)
+    {
+        m_error = "Markov mode needs a non-empty charset and a valid length range.";
+        return false;
+    }
+    m_charset = charset;
+    m_min_length = min_length;
+    m_max_length = max_length;
+    const int limit = (MarkovModel::kLevels - 1) * max_length;
+    m_max_sum = (max_level_sum < 0) ? limit : std::min(max_level_sum, limit);
+
+    // Level of every (position table, previous, next) over charset indices
+    const size_t n = charset.size();
+    const int tables = std::min(max_length, MarkovModel::kPositions);
+    m_cost.assign(static_cast<size_t>(tables) * (n + 1) * n, 0);
+    for (int t = 0; t < tables; ++t)
+        for (size_t prev = 0; prev <= n; ++prev)
+            for (size_t next = 0; next < n; ++next)
+                m_cost[(static_cast<size_t>(t) * (n + 1) + prev) * n + next] = static_cast<uint8_t>(
+                    model.level(t, prev == n ? -1 : static_cast<unsigned char>(charset[prev]), static_cast<unsigned char>(charset[next])));
+
+    // P[1][c][x] = [cost(0, start, c) == x]; P[k+1][c][x] = sum over b of P[k][b][x - cost(k, b, c)]
+    const size_t sums = static_cast<size_t>(m_max_sum) + 1;
+    m_prefix.assign(static_cast<size_t>(max_length) * n * sums, 0);
+    for (size_t c = 0; c < n; ++c)
+    {
+        const int x = cost(0, static_cast<int>(n), static_cast<int>(c));
+        if (x <= m_max_sum)
+            m_prefix[c * sums + x] = 1;
+    }
+    for (int k = 1; k < max_length; ++k)
+    {
+        const uint64_t *from = m_prefix.data() + static_cast<size_t>(k - 1) * n * sums;
+        uint64_t *to = m_prefix.data() + static_cast<size_t>(k) * n * sums;
+        for (size_t b = 0; b < n; ++b)
+            for (size_t c = 0; c < n; ++c)
+            {
+                const int step = cost(k, static_cast<int>(b), static_cast<int>(c));
+                for (int x = step; x <= m_max_sum; ++x)
+                    to[c * sums + x] = saturating_add(to[c * sums + x], from[b * sums + (x - step)]);
+            }
+    }
+
+    // Groups: level sum ascending, then length ascending
+    uint64_t running = 0;
+    for (int sum = 0; sum <= m_max_sum; ++sum)
+    {
+        for (int length = min_length; length <= max_length; ++length)
+        {
+            uint64_t count = 0;
+            for (size_t c = 0; c < n; ++c)
+                count = saturating_add(count, prefixes(length, static_cast<int>(c), sum));
+            if (count == 0)
+                continue;
+            if (count == std::numeric_limits<uint64_t>::max() || running > std::numeric_limits<uint64_t>::max() - count)
+            {
+                m_error = "Markov keyspace does not fit into 64 bits; lower the max length or use --markov-threshold.";
+                m_groups.clear();
+                return false;
+            }
+            m_groups.push_back(Group{sum, length, running, count});
+            running += count;
+        }
+    }
+    m_total = running;
+    return true;
+}
+
+uint64_t MarkovPlan::countUpTo(int level) const
+{
+    uint64_t count = 0;
+    for (const Group &group : m_groups)
+        if (group.level_sum <= level)
+            count += group.count;
+    return count;
+}
+
+// ================================================================
+// ===                     MARKOV GENERATOR                     ===
+// ================================================================
+
+MarkovGenerator::MarkovGenerator(const MarkovPlan &plan) : m_plan(plan)
+{
+}
+
+uint64_t MarkovGenerator::ways(int i, int c) const
+{
+    if (i == m_length - 1)
+        return m_plan.prefixes(m_length, c, m_plan.m_groups[m_group].level_sum);
+    const int step = m_plan.cost(i + 1, c, m_chars[i + 1]);
+    const int remaining = m_budget[i + 1] - step;
+    return remaining < 0 ? 0 : m_plan.prefixes(i + 1, c, remaining);
+}
+
+int MarkovGenerator::budget(int i, int c) const
+{
+    if (i == m_length - 1)
+        return m_plan.m_groups[m_group].level_sum;
+    return m_budget[i + 1] - m_plan.cost(i + 1, c, m_chars[i + 1]);
+}
+
+void MarkovGenerator::complete_below(int i)
+{
+    const int n = static_cast<int>(m_plan.m_charset.size());
+    for (int j = i - 1; j >= 0; --j)
+    {
+        for (int c = 0; c < n; ++c)
+        {
+            if (ways(j, c) > 0)
+            {
+                m_chars[j] = c;
+                m_budget[j] = budget(j, c);
+                m_buffer[j] = m_plan.m_charset[c];
+                break;
+            }
+        }
+    }
+}
+
+void MarkovGenerator::start_group(size_t group)
+{
+    m_group = group;
+    m_length = m_plan.m_groups[group].length;
+    m_chars.assign(m_length, 0);
+    m_budget.assign(m_length, 0);
+    m_buffer.assign(m_length, '\0');
+    complete_below(m_length);
+}
+
+bool MarkovGenerator::seek(uint64_t rank)
+{
+    const auto &groups = m_plan.m_groups;
+    if (!m_plan.m_total || rank >= *m_plan.m_total)
+    {
+        m_exhausted = true;
+        return false;
+    }
+    auto it = std::upper_bound(groups.begin(), groups.end(), rank,
+                               [](uint64_t value, const MarkovPlan::Group &group) { return value < group.first; });
+    m_group = static_cast<size_t>(std::distance(groups.begin(), it) - 1);
+    m_length = groups[m_group].length;
+    m_chars.assign(m_length, 0);
+    m_budget.assign(m_length, 0);
+    m_buffer.assign(m_length, '\0');
+
+    // The last character is the most significant digit
+    uint64_t local = rank - groups[m_group].first;
+    const int n = static_cast<int>(m_plan.m_charset.size());
+    for (int i = m_length - 1; i >= 0; --i)
+    {
+        for (int c = 0; c < n; ++c)
+        {
+            const uint64_t w = ways(i, c);
+            if (local < w)
+            {
+                m_chars[i] = c;
+                m_budget[i] = budget(i, c);
+                m_buffer[i] = m_plan.m_charset[c];
+                break;
+            }
+            local -= w;
+        }
+    }
+    m_exhausted = false;
+    return true;
+}
+
+bool MarkovGenerator::next()
+{
+    if (m_exhausted)
+        return false;
+    const int n = static_cast<int>(m_plan.m_charset.size());
+    for (int i = 0; i < m_length; ++i)
+    {
+        for (int c = m_chars[i] + 1; c < n; ++c)
+        {
+            if (ways(i, c) > 0)
+            {
+                m_chars[i] = c;
+                m_budget[i] = budget(i, c);
+                m_buffer[i] = m_plan.m_charset[c];
+                complete_below(i);
+                return true;
+            }
+        }
+    }
+    if (m_group + 1 >= m_plan.m_groups.size())
+    {
+        m_exhausted = true;
+        return false;
+    }
+    start_group(m_group + 1);
+    return true;
+}
+
+size_t MarkovGenerator::fill(CandidateBatch &batch, uint64_t first_rank, uint64_t max_count)
+{
+    size_t appended = 0;
+    while (!m_exhausted && appended < max_count && !batch.full())
+    {
+        batch.push(m_buffer, first_rank + appended);
+        ++appended;
+        next();
+    }
+    return appended;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint> // For uint64_t, uint8_t
+#include <cstddef> // For size_t
+
+class CandidateBatch;
+
+// Per-position bigram model trained offline with `markov train` (OMEN-style levels).
+// For every position p (positions from kPositions - 1 on share the last table), previous
+// character and next character, the probability is quantised to a level
+// floor(-log2 p) capped at kLevels - 1: level 0 means p >= 1/2, 1 means p >= 1/4, and so on.
+// A password's level sum is the sum over its characters, so a lower sum means a more likely password.
+// File layout: char[8] "APCMARKV", uint32 version (1), uint32 positions, uint32 alphabet,
+// uint32 levels, then positions * (alphabet + 1) * alphabet level bytes
+// ([position][previous, alphabet = start of word][next]).
+class MarkovModel {
+public:
+    static constexpr int kPositions = 16;
+    static constexpr int kLevels = 11;
+    static constexpr int kAlphabet = 95; // Printable ASCII ' '..'~'; other bytes always get the worst level
+
+    // Counts transitions over a text wordlist (one password per line) and quantises them.
+    // Lines with characters outside printable ASCII are ignored. Returns false and sets `error` on failure.
+    bool train(const std::string& corpus_path, std::string& error);
+
+    bool load(const std::string& path, std::string& error);
+    bool save(const std::string& path, std::string& error) const;
+
+    // Level of `next` at `position` after `previous` (previous < 0 at the start of the word)
+    int level(int position, int previous, unsigned char next) const;
+
+    uint64_t trainedWords() const { return m_words; }
+
+private:
+    static int symbol(unsigned char c) { return (c >= 0x20 && c <= 0x7E) ? c - 0x20 : -1; }
+
+    std::vector<uint8_t> m_levels; // [position][previous][next], see the file layout
+    uint64_t m_words = 0;          // Words counted by train() (not stored in the file)
+};
+
+// Markov-ordered keyspace of a charset over a length range.
+// Candidates are grouped by (level sum, length): level sum ascending, then length ascending,
+// and an optional threshold drops every group above a level sum. Counting is exact, using
+// prefix tables P[k][c][x] (prefixes of k characters ending in c with level sum x), so every
+// candidate has a rank and the keyspace can be sliced and resumed like the other modes. Without
+// a threshold, the ranks are a reordering of the whole charset^length keyspace.
+class MarkovPlan {
+public:
+    // max_level_sum < 0 keeps every candidate. Returns false (see error()) if the keyspace or a
+    // group count does not fit into 64 bits.
+    bool compile(const MarkovModel& model, const std::string& charset, int min_length, int max_length, int max_level_sum = -1);
+
+    std::optional<uint64_t> total() const { return m_total; }
+    const std::string& error() const { return m_error; }
+
+    // Highest level sum enumerated, and the candidates up to and including level sum `level`
+    int maxLevelSum() const { return m_max_sum; }
+    uint64_t countUpTo(int level) const;
+
+private:
+    friend class MarkovGenerator;
+
+    struct Group {
+        int level_sum;
+        int length;
+        uint64_t first; // Rank of the group's first candidate
+        uint64_t count;
+    };
+
+    int cost(int position, int previous, int next) const
+    {
+        const int table = position < MarkovModel::kPositions ? position : MarkovModel::kPositions - 1;
+        return m_cost[(static_cast<size_t>(table) * (m_charset.size() + 1) + static_cast<size_t>(previous)) * m_charset.size() + next];
+    }
+    // P[k][c][x] for k = 1..max_length (saturating at UINT64_MAX)
+    uint64_t prefixes(int k, int last, int sum) const
+    {
+        return m_prefix[(static_cast<size_t>(k - 1) * m_charset.size() + static_cast<size_t>(last)) * (m_max_sum + 1) + sum];
+    }
+
+    std::string m_charset;
+    int m_min_length = 0;
+    int m_max_length = 0;
+    int m_max_sum = 0;
+    std::vector<uint8_t> m_cost;    // [position table][previous, charset size = start][next], charset indices
+    std::vector<uint64_t> m_prefix; // [k - 1][last][sum]
+    std::vector<Group> m_groups;    // Enumeration order
+    std::optional<uint64_t> m_total;
+    std::string m_error;
+};
+
+// Walks a MarkovPlan in rank order. Within a group the last character is the most significant
+// digit, so seek() unranks from the end of the word backwards and next() bumps the first position
+// that still has a larger character with completions, then refills the positions before it with
+// the smallest viable characters. Crossing into the next group restarts from its first candidate.
+class MarkovGenerator {
+public:
+    explicit MarkovGenerator(const MarkovPlan& plan);
+
+    // Unranks a global rank. Returns false if out of range.
+    bool seek(uint64_t rank);
+
+    // Advances to the next candidate. Returns false after the last one.
+    bool next();
+
+    // Same contract as OdometerGenerator::fill.
+    size_t fill(CandidateBatch& batch, uint64_t first_rank, uint64_t max_count);
+
+    const std::string& current() const { return m_buffer; }
+    bool exhausted() const { return m_exhausted; }
+
+private:
+    // Completions of positions 0..i when s[i] = c (positions above i already fixed)
+    uint64_t ways(int i, int c) const;
+    // Remaining level sum for positions 0..i when s[i] = c
+    int budget(int i, int c) const;
+    // Fills positions i-1..0 with the smallest viable characters
+    void complete_below(int i);
+    // Starts group `group` at its first candidate
+    void start_group(size_t group);
+
+    const MarkovPlan& m_plan;
+    size_t m_group = 0;
+    int m_length = 0;
+    std::vector<int> m_chars;   // Charset index at each position
+    std::vector<int> m_budget;  // m_budget[i] = level sum of positions 0..i
+    std::string m_buffer;
+    bool m_exhausted = true;
+};
+
+// `markov train`: trains a model from `corpus_path` and writes it to `model_path`
+bool train_markov_model(const std::string& corpus_path, const std::string& model_path, std::string& error);
@@ -0,0 +1,176 @@
+#include "password_constraints.h"
+#include <algorithm> // For std::max
+#include <queue>
+
+// State layout: [class counts][one flag per required set][last char, run length][Aho-Corasick node]
+static constexpr size_t kCountsOffset = 0;
+
+bool PasswordConstraints::empty() const
+{
+    for (int k = 0; k < kNumClasses; ++k)
+    {
+        if (min_count[k] > 0 || max_count[k] >= 0)
+            return false;
+    }
+    return required_sets.empty() && max_repeat <= 0 && forbidden.empty();
+}
+
+std::string PasswordConstraints::describe() const
+{
+    if (empty())
+        return std::string();
+    std::string text = "constraints";
+    for (int k = 0; k < kNumClasses; ++k)
+        text += " " + std::to_string(min_count[k]) + ":" + std::to_string(max_count[k]);
+    for (const auto &set : required_sets)
+        text += "\nrequire " + set;
+    text += "\nrepeat " + std::to_string(max_repeat);
+    for (const auto &substring : forbidden)
+        text += "\nforbid " + substring;
+    return text;
+}
+
+PasswordConstraints::CharClass PasswordConstraints::classify(unsigned char c)
+{
+    if (c >= 'a' && c <= 'z')
+        return Lower;
+    if (c >= 'A' && c <= 'Z')
+        return Upper;
+    if (c >= '0' && c <= '9')
+        return Digit;
+    return Symbol;
+}
+
+ConstraintMachine::ConstraintMachine(const PasswordConstraints &constraints)
+    : m_constraints(constraints)
+{
+    // A count only needs to be tracked up to the larger of its bounds; beyond that every
+    // prefix behaves the same (or has already been rejected by the maximum)
+    for (int k = 0; k < PasswordConstraints::kNumClasses; ++k)
+        m_count_cap[k] = std::max(m_constraints.min_count[k], m_constraints.max_count[k]);
+
+    for (const auto &set : m_constraints.required_sets)
+    {
+        std::vector<bool> member(256, false);
+        for (char c : set)
+            member[static_cast<unsigned char>(c)] = true;
+        m_required.push_back(member);
+    }
+
+    // Aho-Corasick automaton over the forbidden substrings (empty substrings are ignored)
+    m_ac_goto.assign(1, std::vector<int32_t>(256, -1));
+    m_ac_match.assign(1, 0);
+    for (const auto &substring : m_constraints.forbidden)
+    {
+        if (substring.empty())
+            continue;
+        int32_t node = 0;
+        for (char c : substring)
+        {
+            unsigned char u = static_cast<unsigned char>(c);
+            if (m_ac_goto[node][u] < 0)
+            {
+                m_ac_goto[node][u] = static_cast<int32_t>(m_ac_goto.size());
+                m_ac_goto.emplace_back(256, -1);
+                m_ac_match.push_back(0);
+            }
+            node = m_ac_goto[node][u];
+        }
+        m_ac_match[node] = 1;
+    }
+    // Breadth-first: complete the goto function with failure transitions
+    m_ac_fail.assign(m_ac_goto.size(), 0);
+    std::queue<int32_t> queue;
+    for (int c = 0; c < 256; ++c)
+    {
+        int32_t child = m_ac_goto[0][c];
+        if (child < 0)
+            m_ac_goto[0][c] = 0;
+        else
+            queue.push(child);
+    }
+    while (!queue.empty())
+    {
+        int32_t node = queue.front();
+        queue.pop();
+        m_ac_match[node] |= m_ac_match[m_ac_fail[node]];
+        for (int c = 0; c < 256; ++c)
+        {
+            int32_t child = m_ac_goto[node][c];
+            if (child < 0)
+            {
+                m_ac_goto[node][c] = m_ac_goto[m_ac_fail[node]][c];
+            }
+            else
+            {
+                m_ac_fail[child] = m_ac_goto[m_ac_fail[node]][c];
+                queue.push(child);
+            }
+        }
+    }
+}
+
+int32_t ConstraintMachine::ac_next(int32_t node, unsigned char c) const
+{
+    return m_ac_goto[node][c];
+}
+
+ConstraintMachine::State ConstraintMachine::initial() const
+{
+    // Counts, required flags, last char + run length, Aho-Corasick node
+    return State(PasswordConstraints::kNumClasses + m_required.size() + 3, 0);
+}
+
+bool ConstraintMachine::step(const State &from, unsigned char c, State &to) const
+{
+    to = from;
+    const size_t required_offset = kCountsOffset + PasswordConstraints::kNumClasses;
+    const size_t run_offset = required_offset + m_required.size();
+    const size_t ac_offset = run_offset + 2;
+
+    const int k = PasswordConstraints::classify(c);
+    int32_t &count = to[kCountsOffset + k];
+    if (m_constraints.max_count[k] >= 0 && count >= m_constraints.max_count[k])
+        return false;
+    if (count < m_count_cap[k])
+        ++count;
+
+    for (size_t r = 0; r < m_required.size(); ++r)
+    {
+        if (m_required[r][c])
+            to[required_offset + r] = 1;
+    }
+
+    if (m_constraints.max_repeat > 0)
+    {
+        int32_t &last = to[run_offset];
+        int32_t &run = to[run_offset + 1];
+        run = (run > 0 && last == c) ? run + 1 : 1;
+        last = c;
+        if (run > m_constraints.max_repeat)
+            return false;
+    }
+
+    if (m_ac_goto.size() > 1)
+    {
+        to[ac_offset] = ac_next(to[ac_offset], c);
+        if (m_ac_match[to[ac_offset]])
+            return false;
+    }
+    return true;
+}
+
+bool ConstraintMachine::accepting(const State &state) const
+{
+    for (int k = 0; k < PasswordConstraints::kNumClasses; ++k)
+    {
+        if (state[kCountsOffset + k] < m_constraints.min_count[k])
+            return false;
+    }
+    for (size_t r = 0; r < m_required.size(); ++r)
+    {
+        if (!state[kCountsOffset + PasswordConstraints::kNumClasses + r])
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint> // For int32_t
+
+// Password policy the search space is restricted to (brute-force and pattern modes).
+// Character classes follow the mask classes: lower a-z, upper A-Z, digit 0-9, symbol = anything else.
+struct PasswordConstraints {
+    enum CharClass { Lower = 0, Upper, Digit, Symbol, kNumClasses };
+
+    int min_count[kNumClasses] = {0, 0, 0, 0};     // --min-lower/--min-upper/--min-digits/--min-symbols
+    int max_count[kNumClasses] = {-1, -1, -1, -1}; // --max-...; -1 = unlimited
+    std::vector<std::string> required_sets;        // --require-one-of: at least one character from each
+    int max_repeat = 0;                            // --max-repeat: longest run of one character, 0 = unlimited
+    std::vector<std::string> forbidden;            // --forbid: substrings that must not occur
+
+    bool empty() const;
+
+    // Canonical text form, part of the random-mode job fingerprint
+    std::string describe() const;
+
+    static CharClass classify(unsigned char c);
+};
+
+// Deterministic automaton tracking how far a password prefix is from satisfying the constraints.
+// A state records the (capped) count per class, which required sets were hit, the current run of
+// identical characters and the Aho-Corasick node over the forbidden substrings. step() rejects a
+// prefix as soon as no extension can satisfy a "max" constraint, so the pattern automaton product
+// (see PatternAutomaton::build) prunes those subtrees and its path counts stay exact.
+class ConstraintMachine {
+public:
+    using State = std::vector<int32_t>;
+
+    explicit ConstraintMachine(const PasswordConstraints& constraints);
+
+    State initial() const;
+
+    // Extends `from` by `c`. Returns false if the extended prefix violates a constraint.
+    bool step(const State& from, unsigned char c, State& to) const;
+
+    // True if a password ending in this state satisfies every "min" / required constraint.
+    bool accepting(const State& state) const;
+
+private:
+    // Aho-Corasick transition over the forbidden substrings
+    int32_t ac_next(int32_t node, unsigned char c) const;
+
+    PasswordConstraints m_constraints;
+    int m_count_cap[PasswordConstraints::kNumClasses]; // Counts above this behave identically
+    std::vector<std::vector<bool>> m_required;         // Membership table per required set
+    std::vector<std::vector<int32_t>> m_ac_goto;       // Trie edges, 256 per node (-1 = none)
+    std::vector<int32_t> m_ac_fail;
+    std::vector<uint8_t> m_ac_match;                   // Node ends a forbidden substring (or a suffix does)
+};
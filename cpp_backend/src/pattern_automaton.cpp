@@ -0,0 +1,340 @@
+#include "pattern_automaton.h"
+#include <map>
+#include <utility> // For std::pair
+
+namespace
+{
+    // Thompson-style NFA: every edge consumes one literal character, one character of a set,
+    // or nothing (epsilon).
+    struct Edge
+    {
+        enum Kind
+        {
+            Epsilon,
+            Char,
+            Set
+        } kind;
+        char literal;
+        int set;
+        int to;
+    };
+
+    struct Nfa
+    {
+        std::vector<std::vector<Edge>> edges; // Outgoing edges per node
+        int accept = 0;
+
+        int add_node()
+        {
+            edges.emplace_back();
+            return static_cast<int>(edges.size() - 1);
+        }
+        // Chain of literal characters from `from`; returns the node after the last one
+        int add_literal(int from, const std::string &text)
+        {
+            for (char c : text)
+            {
+                int to = add_node();
+                edges[from].push_back({Edge::Char, c, 0, to});
+                from = to;
+            }
+            return from;
+        }
+    };
+
+    using StateSet = std::vector<uint64_t>; // Bitset over NFA nodes
+
+    bool contains(const StateSet &set, size_t node) { return (set[node / 64] >> (node % 64)) & 1; }
+    void insert(StateSet &set, size_t node) { set[node / 64] |= 1ULL << (node % 64); }
+
+    // Adds everything reachable through epsilon edges
+    void close(StateSet &set, const Nfa &nfa)
+    {
+        std::vector<int> stack;
+        for (size_t n = 0; n < nfa.edges.size(); ++n)
+        {
+            if (contains(set, n))
+                stack.push_back(static_cast<int>(n));
+        }
+        while (!stack.empty())
+        {
+            int n = stack.back();
+            stack.pop_back();
+            for (const Edge &e : nfa.edges[n])
+            {
+                if (e.kind == Edge::Epsilon && !contains(set, e.to))
+                {
+                    insert(set, e.to);
+                    stack.push_back(e.to);
+                }
+            }
+        }
+    }
+}
+
+// Product of the pattern DFA with the constraint machine, explored breadth-first from the start
+// state. Transitions the constraints reject go to kDead; a state accepts if both components do.
+static bool constrain(const std::string &alphabet, std::vector<int32_t> &next, std::vector<uint8_t> &accept,
+                      const PasswordConstraints &constraints, size_t max_states)
+{
+    const ConstraintMachine machine(constraints);
+    const size_t symbols = alphabet.size();
+    std::map<std::pair<int32_t, ConstraintMachine::State>, int32_t> ids;
+    std::vector<std::pair<int32_t, ConstraintMachine::State>> states;
+    std::vector<int32_t> product_next;
+    std::vector<uint8_t> product_accept;
+
+    states.emplace_back(0, machine.initial());
+    ids.emplace(states[0], 0);
+    ConstraintMachine::State stepped;
+    for (size_t id = 0; id < states.size(); ++id)
+    {
+        const std::pair<int32_t, ConstraintMachine::State> current = states[id];
+        product_accept.push_back(accept[current.first] && machine.accepting(current.second) ? 1 : 0);
+        for (size_t a = 0; a < symbols; ++a)
+        {
+            int32_t t = next[current.first * symbols + a];
+            if (t == PatternAutomaton::kDead || !machine.step(current.second, static_cast<unsigned char>(alphabet[a]), stepped))
+            {
+                product_next.push_back(PatternAutomaton::kDead);
+                continue;
+            }
+            auto key = std::make_pair(t, stepped);
+            auto it = ids.find(key);
+            if (it == ids.end())
+            {
+                if (states.size() >= max_states)
+                    return false;
+                it = ids.emplace(key, static_cast<int32_t>(states.size())).first;
+                states.push_back(key);
+            }
+            product_next.push_back(it->second);
+        }
+    }
+    next.swap(product_next);
+    accept.swap(product_accept);
+    return true;
+}
+
+bool PatternAutomaton::build(const ParsedPattern &pattern, int max_length, const PasswordConstraints *constraints)
+{
+    m_alphabet.clear();
+    m_next.clear();
+    m_accept.clear();
+    m_counts.clear();
+    m_max_length = (max_length < 0) ? 0 : max_length;
+
+    // Alphabet: distinct characters of the run charset in order, then of the other sets,
+    // then literal-only characters
+    bool in_alphabet[256] = {};
+    auto add_symbol = [&](char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (!in_alphabet[u])
+        {
+            in_alphabet[u] = true;
+            m_alphabet += c;
+        }
+    };
+    std::vector<std::vector<bool>> in_set(pattern.sets.size(), std::vector<bool>(256, false));
+    for (size_t k = 0; k < pattern.sets.size(); ++k)
+    {
+        for (char c : pattern.sets[k])
+        {
+            in_set[k][static_cast<unsigned char>(c)] = true;
+            add_symbol(c);
+        }
+    }
+
+    Nfa nfa;
+    int current = nfa.add_node();
+    for (const auto &token : pattern.tokens)
+    {
+        switch (token.kind)
+        {
+        case PatternToken::Literal:
+            for (char c : token.literal)
+                add_symbol(c);
+            current = nfa.add_literal(current, token.literal);
+            break;
+        case PatternToken::AnyOne:
+        {
+            int to = nfa.add_node();
+            nfa.edges[current].push_back({Edge::Set, '\0', token.set, to});
+            current = to;
+            break;
+        }
+        case PatternToken::AnyRun:
+        {
+            // Own node with a self loop, so the star cannot loop back into an earlier group
+            int loop = nfa.add_node();
+            nfa.edges[current].push_back({Edge::Epsilon, '\0', 0, loop});
+            nfa.edges[loop].push_back({Edge::Set, '\0', token.set, loop});
+            current = loop;
+            break;
+        }
+        case PatternToken::Choice:
+        {
+            int join = nfa.add_node();
+            for (const auto &alternative : token.alternatives)
+            {
+                for (char c : alternative)
+                    add_symbol(c);
+                int end = nfa.add_literal(current, alternative);
+                nfa.edges[end].push_back({Edge::Epsilon, '\0', 0, join});
+            }
+            current = join;
+            break;
+        }
+        }
+    }
+    nfa.accept = current;
+
+    const size_t words = (nfa.edges.size() + 63) / 64;
+    const size_t symbols = m_alphabet.size();
+    std::map<StateSet, int32_t> ids;
+    std::vector<StateSet> sets;
+
+    StateSet initial(words, 0);
+    insert(initial, 0);
+    close(initial, nfa);
+    ids.emplace(initial, 0);
+    sets.push_back(initial);
+
+    // Subset construction; the empty set is the implicit dead state
+    for (size_t id = 0; id < sets.size(); ++id)
+    {
+        const StateSet current_set = sets[id];
+        m_accept.push_back(contains(current_set, nfa.accept) ? 1 : 0);
+        for (size_t a = 0; a < symbols; ++a)
+        {
+            const unsigned char symbol = static_cast<unsigned char>(m_alphabet[a]);
+            StateSet target(words, 0);
+            bool any = false;
+            for (size_t n = 0; n < nfa.edges.size(); ++n)
+            {
+                if (!contains(current_set, n))
+                    continue;
+                for (const Edge &e : nfa.edges[n])
+                {
+                    bool match = (e.kind == Edge::Char && static_cast<unsigned char>(e.literal) == symbol) ||
+                                 (e.kind == Edge::Set && in_set[e.set][symbol]);
+                    if (match)
+                    {
+                        insert(target, e.to);
+                        any = true;
+                    }
+                }
+            }
+            if (!any)
+            {
+                m_next.push_back(kDead);
+                continue;
+            }
+            close(target, nfa);
+            auto it = ids.find(target);
+            if (it == ids.end())
+            {
+                if (sets.size() >= kMaxStates)
+                    return false;
+                it = ids.emplace(target, static_cast<int32_t>(sets.size())).first;
+                sets.push_back(target);
+            }
+            m_next.push_back(it->second);
+        }
+    }
+
+    if (constraints && !constraints->empty() && !constrain(m_alphabet, m_next, m_accept, *constraints, kMaxProductStates))
+        return false;
+
+    // completions[s][r] = sum over symbols of completions[next(s, a)][r - 1], saturating
+    const size_t states = m_accept.size();
+    const size_t stride = static_cast<size_t>(m_max_length) + 1;
+    const uint128 saturated = kUint128Max;
+    m_counts.assign(states * stride, 0);
+    for (size_t s = 0; s < states; ++s)
+        m_counts[s * stride] = m_accept[s];
+    for (size_t r = 1; r < stride; ++r)
+    {
+        for (size_t s = 0; s < states; ++s)
+        {
+            uint128 total = 0;
+            for (size_t a = 0; a < symbols; ++a)
+            {
+                int32_t t = m_next[s * symbols + a];
+                if (t == kDead)
+                    continue;
+                uint128 ways = m_counts[static_cast<size_t>(t) * stride + r - 1];
+                total = (ways > saturated - total) ? saturated : total + ways;
+            }
+            m_counts[s * stride + r] = total;
+        }
+    }
+    return true;
+}
+
+std::optional<uint128> PatternAutomaton::count(int length) const
+{
+    if (length < 0 || length > m_max_length || m_accept.empty())
+        return 0;
+    uint128 total = completions(start(), length);
+    if (total == kUint128Max)
+        return std::nullopt; // Saturated: the exact value is not representable
+    return total;
+}
+
+bool PatternAutomaton::unrank(uint128 index, int length, std::string &out_password) const
+{
+    std::optional<uint128> total = count(length);
+    if (!total || index >= *total)
+        return false;
+    out_password.resize(length);
+    int32_t state = start();
+    for (int pos = 0; pos < length; ++pos)
+    {
+        const int remaining = length - pos - 1;
+        bool placed = false;
+        for (size_t a = 0; a < m_alphabet.size(); ++a)
+        {
+            int32_t t = transition(state, a);
+            uint128 ways = completions(t, remaining);
+            if (index < ways)
+            {
+                out_password[pos] = m_alphabet[a];
+                state = t;
+                placed = true;
+                break;
+            }
+            index -= ways;
+        }
+        if (!placed)
+            return false;
+    }
+    return true;
+}
+
+bool PatternAutomaton::rank(std::string_view password, uint128 &out_index) const
+{
+    const int length = static_cast<int>(password.size());
+    std::optional<uint128> total = count(length);
+    if (length > m_max_length || !total || *total == 0)
+        return false; // Saturated counts would give inexact ranks
+    uint128 index = 0;
+    int32_t state = start();
+    for (int pos = 0; pos < length; ++pos)
+    {
+        const size_t symbol = m_alphabet.find(password[pos]);
+        if (symbol == std::string::npos)
+            return false;
+        // Every password that branches off to an earlier symbol here comes first
+        const int remaining = length - pos - 1;
+        for (size_t a = 0; a < symbol; ++a)
+            index += completions(transition(state, a), remaining);
+        state = transition(state, symbol);
+        if (state == kDead)
+            return false;
+    }
+    if (completions(state, 0) == 0)
+        return false;
+    out_index = index;
+    return true;
+}
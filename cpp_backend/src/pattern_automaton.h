@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstdint> // For int32_t
+#include <cstddef> // For size_t
+#include "pattern_syntax.h"
+#include "password_constraints.h"
+#include "uint128.h"
+
+// Deterministic automaton for the language of a parsed pattern (see pattern_syntax.h).
+// Patterns such as "a*b*", "**" or "{a|ab}{b|}" describe the same password in several ways
+// (star length splits, overlapping alternatives); the automaton accepts every password once, so counting paths gives the
+// exact number of distinct candidates and unranking walks them in lexicographic order
+// (run charset order first, then other character sets, then literal-only characters).
+// Password constraints are folded in as a product with a ConstraintMachine: prefixes that can no
+// longer satisfy the policy lead to dead or zero-count states, so whole subtrees are pruned and
+// counts stay exact.
+class PatternAutomaton {
+public:
+    static constexpr int32_t kDead = -1;          // Transition into the rejecting sink
+    static constexpr size_t kMaxStates = 4096;    // Subset construction gives up beyond this
+    static constexpr size_t kMaxProductStates = 1 << 16; // Same for the product with constraints
+
+    // Subset construction over an NFA of the pattern, plus path counts for lengths up to
+    // max_length. Returns false if the pattern needs more than kMaxStates states, or the
+    // product with non-empty `constraints` more than kMaxProductStates.
+    bool build(const ParsedPattern& pattern, int max_length, const PasswordConstraints* constraints = nullptr);
+
+    // Number of distinct passwords of this length, nullopt if it does not fit into 128 bits.
+    std::optional<uint128> count(int length) const;
+
+    // Writes the password with the given rank among all passwords of this length.
+    bool unrank(uint128 index, int length, std::string& out_password) const;
+
+    // Inverse of unrank(): rank of `password` among the passwords of its length.
+    // Returns false if the pattern does not accept it.
+    bool rank(std::string_view password, uint128& out_index) const;
+
+    int32_t start() const { return 0; }
+    int maxLength() const { return m_max_length; }
+    const std::string& alphabet() const { return m_alphabet; }
+    size_t numStates() const { return m_accept.size(); }
+
+    int32_t transition(int32_t state, size_t symbol) const { return m_next[state * m_alphabet.size() + symbol]; }
+
+    // Accepted continuations of exactly `remaining` characters from `state` (saturates at kUint128Max).
+    uint128 completions(int32_t state, int remaining) const
+    {
+        return (state == kDead) ? 0 : m_counts[static_cast<size_t>(state) * (m_max_length + 1) + remaining];
+    }
+
+private:
+    std::string m_alphabet;          // Symbols in enumeration order
+    std::vector<int32_t> m_next;     // state * |alphabet| + symbol -> state or kDead
+    std::vector<uint8_t> m_accept;
+    std::vector<uint128> m_counts;   // state * (max_length + 1) + remaining -> completions
+    int m_max_length = 0;
+};
@@ -0,0 +1,265 @@
+#include "pattern_plan.h"
+#include <algorithm> // For std::upper_bound, std::lower_bound
+
+bool PatternPlan::compile(const ParsedPattern &pattern, int min_length, int max_length, bool increment,
+                          const PasswordConstraints &constraints)
+{
+    *this = PatternPlan();
+    for (const auto &set : pattern.sets)
+    {
+        if (set.empty())
+        {
+            m_error = "Pattern uses an empty character set.";
+            return false;
+        }
+    }
+    m_pattern = pattern;
+    m_min_length = (min_length < 0) ? 0 : min_length;
+    m_max_length = (max_length < m_min_length) ? m_min_length : max_length;
+    m_fixed_length = pattern.fixedLength();
+    m_num_stars = pattern.numStars();
+
+    // Several stars or alternation groups can describe one password in several ways, and
+    // groups make the layout depend on the chosen branch: both are counted on the automaton.
+    // Constraints are only expressible there (product with the constraint machine).
+    if (!constraints.empty())
+    {
+        m_has_automaton = m_automaton.build(m_pattern, m_max_length, &constraints);
+        if (!m_has_automaton)
+        {
+            m_error = "Pattern and constraints are too complex (more than " + std::to_string(PatternAutomaton::kMaxProductStates) + " automaton states).";
+            return false;
+        }
+    }
+    else if (m_num_stars > 1 || pattern.hasChoices())
+    {
+        // Star length splits would test overlapping passwords repeatedly, so there is no fallback
+        m_has_automaton = m_automaton.build(m_pattern, m_max_length);
+        if (!m_has_automaton)
+        {
+            m_error = "Pattern is too complex (more than " + std::to_string(PatternAutomaton::kMaxStates) + " automaton states).";
+            return false;
+        }
+    }
+    increment = increment && !m_has_automaton;
+
+    // Star-free patterns have one layout; with increment, shorter lengths use its prefixes
+    PatternLayout full_layout;
+    if (m_num_stars == 0 && !m_has_automaton)
+        build_layout(std::vector<int>(), full_layout);
+
+    uint128 running_total = 0;
+    bool total_ok = true;
+    m_entries.resize(static_cast<size_t>(m_max_length - m_min_length) + 1);
+    for (int length = m_min_length; length <= m_max_length; ++length)
+    {
+        LengthEntry &e = m_entries[length - m_min_length];
+        int free_length = length - m_fixed_length;
+        PatternLayout layout;
+        if (m_has_automaton)
+        {
+            std::optional<uint128> count = m_automaton.count(length);
+            if (!count)
+            {
+                e.overflow = true;
+                total_ok = false;
+                continue;
+            }
+            e.count = *count;
+        }
+        else if (m_num_stars == 0)
+        {
+            if (free_length > 0 || (free_length < 0 && !increment))
+                continue; // No candidates at this length
+            layout.templ = full_layout.templ.substr(0, length);
+            for (size_t i = 0; i < full_layout.wildcard_positions.size() && full_layout.wildcard_positions[i] < length; ++i)
+            {
+                layout.wildcard_positions.push_back(full_layout.wildcard_positions[i]);
+                layout.wildcard_sets.push_back(full_layout.wildcard_sets[i]);
+            }
+        }
+        else
+        {
+            if (free_length < 0)
+                continue;
+            // The single star takes every free character
+            build_layout(std::vector<int>(1, free_length), layout);
+        }
+
+        if (!m_has_automaton)
+        {
+            std::optional<uint128> fills = layout_fills(layout);
+            if (!fills)
+            {
+                e.overflow = true;
+                total_ok = false;
+                continue;
+            }
+            e.count = *fills;
+            e.layout = layout;
+            // Rightmost wildcard varies fastest; each weight is the product of the set sizes to its right
+            e.strides.assign(layout.wildcard_positions.size(), 1);
+            for (size_t i = e.strides.size(); i-- > 1;)
+                e.strides[i - 1] = e.strides[i] * m_pattern.sets[layout.wildcard_sets[i]].size();
+        }
+
+        if (e.count > 0)
+        {
+            m_nonempty_lengths.push_back(length);
+            m_prefix.push_back(running_total);
+            if (running_total > kUint128Max - e.count)
+                total_ok = false;
+            else
+                running_total += e.count;
+        }
+    }
+    if (total_ok)
+        m_total = running_total;
+    return true;
+}
+
+std::optional<uint128> PatternPlan::layout_fills(const PatternLayout &layout) const
+{
+    uint128 fills = 1;
+    for (int set : layout.wildcard_sets)
+    {
+        uint128 radix = m_pattern.sets[set].size();
+        if (fills > kUint128Max / radix)
+            return std::nullopt;
+        fills *= radix;
+    }
+    return fills;
+}
+
+const PatternPlan::LengthEntry *PatternPlan::entry(int length) const
+{
+    if (length < m_min_length || length > m_max_length || m_entries.empty())
+        return nullptr;
+    return &m_entries[length - m_min_length];
+}
+
+std::optional<uint128> PatternPlan::count(int length) const
+{
+    const LengthEntry *e = entry(length);
+    if (!e)
+        return 0;
+    if (e->overflow)
+        return std::nullopt;
+    return e->count;
+}
+
+bool PatternPlan::build_layout(const std::vector<int> &star_lengths, PatternLayout &layout) const
+{
+    layout.templ.clear();
+    layout.wildcard_positions.clear();
+    layout.wildcard_sets.clear();
+    size_t star_idx = 0;
+    for (const auto &token : m_pattern.tokens)
+    {
+        int count = 1;
+        if (token.kind == PatternToken::Literal)
+        {
+            layout.templ += token.literal;
+            continue;
+        }
+        if (token.kind == PatternToken::AnyRun)
+        {
+            if (star_idx >= star_lengths.size())
+                return false;
+            count = star_lengths[star_idx++];
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            layout.wildcard_positions.push_back(static_cast<int>(layout.templ.size()));
+            layout.wildcard_sets.push_back(token.set);
+            layout.templ += m_pattern.sets[token.set][0];
+        }
+    }
+    return star_idx == star_lengths.size();
+}
+
+bool PatternPlan::layoutFor(uint128 index, int length, PatternLayout &layout, uint128 &local_index, uint128 &first_index) const
+{
+    const LengthEntry *e = entry(length);
+    if (m_has_automaton || !e || e->overflow || index >= e->count)
+        return false;
+    layout = e->layout;
+    local_index = index;
+    first_index = 0;
+    return true;
+}
+
+bool PatternPlan::unrank(uint128 index, int length, std::string &out_password) const
+{
+    if (m_has_automaton)
+        return m_automaton.unrank(index, length, out_password);
+    const LengthEntry *e = entry(length);
+    if (!e || e->overflow || index >= e->count)
+        return false;
+    // O(wildcards): copy the template and place one digit per precomputed stride
+    out_password = e->layout.templ;
+    const std::vector<int> &positions = e->layout.wildcard_positions;
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        uint128 digit = index / e->strides[i];
+        index -= digit * e->strides[i];
+        out_password[positions[i]] = m_pattern.sets[e->layout.wildcard_sets[i]][digit];
+    }
+    return true;
+}
+
+// Mixed-radix rank of `password` inside one layout (rightmost wildcard fastest), false if it does not fit
+static bool rank_in_layout(const PatternLayout &layout, const std::vector<std::string> &sets, std::string_view password, uint128 &out_index)
+{
+    if (password.size() != layout.templ.size())
+        return false;
+    uint128 index = 0;
+    size_t wildcard = 0;
+    for (size_t pos = 0; pos < password.size(); ++pos)
+    {
+        if (wildcard < layout.wildcard_positions.size() && layout.wildcard_positions[wildcard] == static_cast<int>(pos))
+        {
+            const std::string &set = sets[layout.wildcard_sets[wildcard++]];
+            const size_t digit = set.find(password[pos]);
+            if (digit == std::string::npos)
+                return false;
+            index = index * set.size() + digit;
+        }
+        else if (password[pos] != layout.templ[pos])
+            return false;
+    }
+    out_index = index;
+    return true;
+}
+
+bool PatternPlan::rank(std::string_view password, uint128 &out_index) const
+{
+    const int length = static_cast<int>(password.size());
+    if (m_has_automaton)
+        return length >= m_min_length && m_automaton.rank(password, out_index);
+    const LengthEntry *e = entry(length);
+    if (!e || e->overflow || e->count == 0)
+        return false;
+    return rank_in_layout(e->layout, m_pattern.sets, password, out_index);
+}
+
+bool PatternPlan::rankGlobal(std::string_view password, uint128 &out_global_index) const
+{
+    uint128 local_index = 0;
+    if (!m_total || !rank(password, local_index))
+        return false;
+    auto it = std::lower_bound(m_nonempty_lengths.begin(), m_nonempty_lengths.end(), static_cast<int>(password.size()));
+    if (it == m_nonempty_lengths.end() || *it != static_cast<int>(password.size()))
+        return false;
+    out_global_index = m_prefix[it - m_nonempty_lengths.begin()] + local_index;
+    return true;
+}
+
+bool PatternPlan::unrankGlobal(uint128 global_index, std::string &out_password) const
+{
+    if (!m_total || global_index >= *m_total || m_prefix.empty())
+        return false;
+    // Last non-empty length whose first global index is <= global_index
+    size_t i = static_cast<size_t>(std::upper_bound(m_prefix.begin(), m_prefix.end(), global_index) - m_prefix.begin()) - 1;
+    return unrank(global_index - m_prefix[i], m_nonempty_lengths[i], out_password);
+}
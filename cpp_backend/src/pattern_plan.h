@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include "uint128.h"
+#include "pattern_syntax.h"
+#include "pattern_automaton.h"
+
+// Concrete layout of a zero/one-star pattern at one length:
+// literal characters are already in `templ`, wildcard slots are listed left to right
+// together with the character set each one draws from.
+struct PatternLayout {
+    std::string templ;
+    std::vector<int> wildcard_positions;
+    std::vector<int> wildcard_sets; // Index into PatternPlan::sets()
+};
+
+// Pattern compiled once per run for a length range.
+// Holds everything index-based generation needs so that unranking never re-scans the
+// parsed tokens: per-length counts with a prefix-sum table (global index -> length by
+// binary search), and for zero/one-star patterns a ready template, wildcard list and
+// mixed-radix strides per length (each wildcard counts in the size of its own set).
+// Multi-star patterns and alternation groups rank distinct passwords through a
+// PatternAutomaton and are rejected if it is too large. Password constraints always go
+// through the automaton, which prunes every prefix that cannot satisfy them.
+class PatternPlan {
+public:
+    // With `increment`, a star-free pattern without groups also yields every prefix of at least
+    // min_length characters (hashcat --increment). Returns false (see error()) if a character
+    // set is empty or a pattern with several stars, alternation groups or constraints does not fit into an automaton.
+    bool compile(const ParsedPattern& pattern, int min_length, int max_length, bool increment = false,
+                 const PasswordConstraints& constraints = PasswordConstraints());
+
+    // Candidates of exactly this length, nullopt if the count does not fit into 128 bits.
+    std::optional<uint128> count(int length) const;
+
+    // Candidates over the whole length range, nullopt on overflow of any length or the sum.
+    std::optional<uint128> total() const { return m_total; }
+
+    // Password with the given rank among passwords of `length`.
+    bool unrank(uint128 index, int length, std::string& out_password) const;
+
+    // Password with the given rank across all lengths, shortest length first.
+    bool unrankGlobal(uint128 global_index, std::string& out_password) const;
+
+    // Inverses of unrank() and unrankGlobal(). Return false if the plan does not generate `password`.
+    bool rank(std::string_view password, uint128& out_index) const;
+    bool rankGlobal(std::string_view password, uint128& out_global_index) const;
+
+    // Layout holding local index `index` at `length` (patterns without an automaton have one per
+    // length). On success `local_index` is the rank inside that layout and `first_index` the
+    // length-local index of the layout's first candidate.
+    bool layoutFor(uint128 index, int length, PatternLayout& layout, uint128& local_index, uint128& first_index) const;
+
+    // Non-null when a multi-star pattern, groups or constraints are enumerated on the automaton
+    const PatternAutomaton* automaton() const { return m_has_automaton ? &m_automaton : nullptr; }
+
+    const std::vector<std::string>& sets() const { return m_pattern.sets; }
+    const std::string& error() const { return m_error; }
+    int minLength() const { return m_min_length; }
+    int maxLength() const { return m_max_length; }
+    int fixedLength() const { return m_fixed_length; }
+    int numStars() const { return m_num_stars; }
+
+private:
+    struct LengthEntry {
+        bool overflow = false;
+        uint128 count = 0;
+        PatternLayout layout;           // Patterns without an automaton only
+        std::vector<uint128> strides;   // Mixed-radix weight of each wildcard (no automaton only)
+    };
+
+    bool build_layout(const std::vector<int>& star_lengths, PatternLayout& layout) const;
+    std::optional<uint128> layout_fills(const PatternLayout& layout) const;
+    const LengthEntry* entry(int length) const;
+
+    ParsedPattern m_pattern;
+    int m_min_length = 0;
+    int m_max_length = 0;
+    int m_fixed_length = 0;
+    int m_num_stars = 0;
+    std::vector<LengthEntry> m_entries;   // Index: length - m_min_length
+    std::vector<int> m_nonempty_lengths;  // Lengths with at least one candidate, ascending
+    std::vector<uint128> m_prefix;        // m_prefix[i] = candidates in shorter non-empty lengths
+    std::optional<uint128> m_total;
+    PatternAutomaton m_automaton;
+    bool m_has_automaton = false;
+    std::string m_error;
+};
@@ -0,0 +1,349 @@
+#include "pattern_syntax.h"
+#include <algorithm> // For std::min, std::max
+
+static const char *CLASS_LOWER = "abcdefghijklmnopqrstuvwxyz";
+static const char *CLASS_UPPER = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static const char *CLASS_DIGIT = "0123456789";
+static const char *CLASS_SYMBOL = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+// Characters of a built-in class, or an empty string if `name` is not one
+static std::string builtin_class(char name)
+{
+    switch (name)
+    {
+    case 'l':
+        return CLASS_LOWER;
+    case 'u':
+        return CLASS_UPPER;
+    case 'd':
+        return CLASS_DIGIT;
+    case 's':
+        return CLASS_SYMBOL;
+    case 'a':
+        return std::string(CLASS_LOWER) + CLASS_UPPER + CLASS_DIGIT + CLASS_SYMBOL;
+    default:
+        return std::string();
+    }
+}
+
+// Appends the characters of `chars` that `out` does not contain yet
+static void append_unique(std::string &out, const std::string &chars)
+{
+    for (char c : chars)
+    {
+        if (out.find(c) == std::string::npos)
+            out += c;
+    }
+}
+
+static PatternToken make_token(PatternToken::Kind kind, const std::string &literal = std::string(), int set = 0)
+{
+    PatternToken token;
+    token.kind = kind;
+    token.literal = literal;
+    token.set = set;
+    return token;
+}
+
+// Sum of token lengths, taking the shortest or longest alternative of each group
+static int token_length(const std::vector<PatternToken> &tokens, bool longest)
+{
+    int length = 0;
+    for (const auto &token : tokens)
+    {
+        if (token.kind == PatternToken::Literal)
+            length += static_cast<int>(token.literal.size());
+        else if (token.kind == PatternToken::AnyOne)
+            ++length;
+        else if (token.kind == PatternToken::Choice && !token.alternatives.empty())
+        {
+            size_t best = token.alternatives[0].size();
+            for (const auto &alternative : token.alternatives)
+                best = longest ? std::max(best, alternative.size()) : std::min(best, alternative.size());
+            length += static_cast<int>(best);
+        }
+    }
+    return length;
+}
+
+// Index of the bracket closing the group opened at `open`, or npos (escaped characters skipped)
+static size_t find_closing(const std::string &pattern, size_t open, char closer)
+{
+    for (size_t i = open + 1; i < pattern.size(); ++i)
+    {
+        if (pattern[i] == '\\')
+            ++i;
+        else if (pattern[i] == closer)
+            return i;
+    }
+    return std::string::npos;
+}
+
+// Like find_closing, but only for an alternation group: a body without an unescaped '|' (such as
+// the "(1)" of "pw(1)") is not a group, so its brackets stay literal characters
+static size_t find_group_closing(const std::string &pattern, size_t open, char closer)
+{
+    size_t close = find_closing(pattern, open, closer);
+    if (close == std::string::npos)
+        return close;
+    for (size_t i = open + 1; i < close; ++i)
+    {
+        if (pattern[i] == '\\')
+            ++i;
+        else if (pattern[i] == '|')
+            return close;
+    }
+    return std::string::npos;
+}
+
+// Characters of a bracket expression body such as "a-f0-9_" (escapes allowed, '-' literal at the ends)
+static std::string expand_bracket(const std::string &body)
+{
+    std::string chars;
+    std::vector<bool> escaped;
+    for (size_t i = 0; i < body.size(); ++i)
+    {
+        bool esc = (body[i] == '\\' && i + 1 < body.size());
+        if (esc)
+            ++i;
+        chars += body[i];
+        escaped.push_back(esc);
+    }
+    std::string result;
+    for (size_t i = 0; i < chars.size(); ++i)
+    {
+        if (i + 2 < chars.size() && chars[i + 1] == '-' && !escaped[i + 1])
+        {
+            unsigned char from = static_cast<unsigned char>(chars[i]);
+            unsigned char to = static_cast<unsigned char>(chars[i + 2]);
+            for (unsigned c = from; c <= to; ++c)
+                append_unique(result, std::string(1, static_cast<char>(c)));
+            i += 2;
+        }
+        else
+        {
+            append_unique(result, std::string(1, chars[i]));
+        }
+    }
+    return result;
+}
+
+// Literal alternatives of a group body such as "2019|2020|" (escapes allowed)
+static std::vector<std::string> split_alternatives(const std::string &body)
+{
+    std::vector<std::string> alternatives(1);
+    for (size_t i = 0; i < body.size(); ++i)
+    {
+        if (body[i] == '\\' && i + 1 < body.size())
+            alternatives.back() += body[++i];
+        else if (body[i] == '|')
+            alternatives.emplace_back();
+        else
+            alternatives.back() += body[i];
+    }
+    // Repeated alternatives would only duplicate candidates
+    std::vector<std::string> unique;
+    for (const auto &alternative : alternatives)
+    {
+        if (std::find(unique.begin(), unique.end(), alternative) == unique.end())
+            unique.push_back(alternative);
+    }
+    return unique;
+}
+
+int ParsedPattern::fixedLength() const
+{
+    return token_length(tokens, false);
+}
+
+int ParsedPattern::maxFixedLength() const
+{
+    return token_length(tokens, true);
+}
+
+bool ParsedPattern::hasChoices() const
+{
+    for (const auto &token : tokens)
+    {
+        if (token.kind == PatternToken::Choice)
+            return true;
+    }
+    return false;
+}
+
+int ParsedPattern::numStars() const
+{
+    int stars = 0;
+    for (const auto &token : tokens)
+    {
+        if (token.kind == PatternToken::AnyRun)
+            ++stars;
+    }
+    return stars;
+}
+
+std::string expand_charset_spec(const std::string &spec)
+{
+    std::string result;
+    for (size_t i = 0; i < spec.size(); ++i)
+    {
+        if (spec[i] == '?' && i + 1 < spec.size())
+        {
+            std::string cls = builtin_class(spec[i + 1]);
+            if (!cls.empty())
+            {
+                append_unique(result, cls);
+                ++i;
+                continue;
+            }
+            if (spec[i + 1] == '?')
+            {
+                append_unique(result, "?");
+                ++i;
+                continue;
+            }
+        }
+        append_unique(result, std::string(1, spec[i]));
+    }
+    return result;
+}
+
+bool parse_pattern(const std::string &pattern, const std::string &charset,
+                   const std::array<std::string, kCustomCharsetSlots> &custom_charsets,
+                   ParsedPattern &out, std::string &error)
+{
+    out.tokens.clear();
+    out.sets.assign(1, charset);
+    std::string current_literal;
+
+    // Index of `chars` in out.sets, adding it if it is new
+    auto set_index = [&out](const std::string &chars) -> int {
+        for (size_t i = 0; i < out.sets.size(); ++i)
+        {
+            if (out.sets[i] == chars)
+                return static_cast<int>(i);
+        }
+        out.sets.push_back(chars);
+        return static_cast<int>(out.sets.size() - 1);
+    };
+    auto flush_literal = [&]() {
+        if (!current_literal.empty())
+        {
+            out.tokens.push_back(make_token(PatternToken::Literal, current_literal));
+            current_literal.clear();
+        }
+    };
+
+    for (size_t i = 0; i < pattern.size(); ++i)
+    {
+        char c = pattern[i];
+        if (c == '\\')
+        {
+            if (i + 1 < pattern.size())
+                current_literal += pattern[++i]; // A trailing backslash is dropped
+        }
+        else if (c == '*')
+        {
+            flush_literal();
+            out.tokens.push_back(make_token(PatternToken::AnyRun));
+        }
+        else if (c == '[' && find_closing(pattern, i, ']') != std::string::npos)
+        {
+            size_t close = find_closing(pattern, i, ']');
+            std::string chars = expand_bracket(pattern.substr(i + 1, close - i - 1));
+            if (chars.empty())
+            {
+                error = "Pattern contains an empty character range '[]'.";
+                return false;
+            }
+            flush_literal();
+            out.tokens.push_back(make_token(PatternToken::AnyOne, std::string(), set_index(chars)));
+            i = close;
+        }
+        else if ((c == '{' || c == '(') && find_group_closing(pattern, i, c == '{' ? '}' : ')') != std::string::npos)
+        {
+            size_t close = find_group_closing(pattern, i, c == '{' ? '}' : ')');
+            PatternToken choice = make_token(PatternToken::Choice);
+            choice.alternatives = split_alternatives(pattern.substr(i + 1, close - i - 1));
+            flush_literal();
+            if (choice.alternatives.size() == 1)
+            {
+                if (!choice.alternatives[0].empty())
+                    out.tokens.push_back(make_token(PatternToken::Literal, choice.alternatives[0])); // "(abc|abc)" is just "abc"
+            }
+            else
+                out.tokens.push_back(choice);
+            i = close;
+        }
+        else if (c == '?')
+        {
+            flush_literal();
+            char next = (i + 1 < pattern.size()) ? pattern[i + 1] : '\0';
+            std::string cls = builtin_class(next);
+            if (!cls.empty())
+            {
+                out.tokens.push_back(make_token(PatternToken::AnyOne, std::string(), set_index(cls)));
+                ++i;
+            }
+            else if (next >= '1' && next < '1' + kCustomCharsetSlots)
+            {
+                const std::string &custom = custom_charsets[next - '1'];
+                if (custom.empty())
+                {
+                    error = std::string("Pattern uses ?") + next + " but --custom-charset" + next + " is not set.";
+                    return false;
+                }
+                out.tokens.push_back(make_token(PatternToken::AnyOne, std::string(), set_index(custom)));
+                ++i;
+            }
+            else
+            {
+                out.tokens.push_back(make_token(PatternToken::AnyOne, std::string(), 0)); // Plain '?': run charset
+            }
+        }
+        else
+        {
+            current_literal += c;
+        }
+    }
+    flush_literal();
+    return true;
+}
+
+// Backtracking matcher for pattern_matches(): token `t` onwards against password[pos..]
+static bool match_from(const ParsedPattern &pattern, size_t t, std::string_view password, size_t pos)
+{
+    if (t == pattern.tokens.size())
+        return pos == password.size();
+    const PatternToken &token = pattern.tokens[t];
+    switch (token.kind)
+    {
+    case PatternToken::Literal:
+        return password.substr(pos, token.literal.size()) == token.literal &&
+               match_from(pattern, t + 1, password, pos + token.literal.size());
+    case PatternToken::AnyOne:
+        return pos < password.size() && pattern.sets[token.set].find(password[pos]) != std::string::npos &&
+               match_from(pattern, t + 1, password, pos + 1);
+    case PatternToken::AnyRun:
+        for (size_t end = pos;; ++end)
+        {
+            if (match_from(pattern, t + 1, password, end))
+                return true;
+            if (end == password.size() || pattern.sets[0].find(password[end]) == std::string::npos)
+                return false;
+        }
+    case PatternToken::Choice:
+        for (const auto &alternative : token.alternatives)
+        {
+            if (password.substr(pos, alternative.size()) == alternative && match_from(pattern, t + 1, password, pos + alternative.size()))
+                return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+bool pattern_matches(const ParsedPattern &pattern, std::string_view password)
+{
+    return match_from(pattern, 0, password, 0);
+}
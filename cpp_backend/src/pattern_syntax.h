@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Number of user-defined charset slots (?1 .. ?4)
+constexpr int kCustomCharsetSlots = 4;
+
+// One element of a parsed pattern
+struct PatternToken {
+    enum Kind {
+        Literal, // Fixed text
+        AnyOne,  // Exactly one character from sets[set]
+        AnyRun,  // Zero or more characters from the run charset (sets[0])
+        Choice   // Exactly one of `alternatives` (an empty alternative makes the group optional)
+    };
+    Kind kind;
+    std::string literal; // Kind::Literal only
+    int set = 0;         // Kind::AnyOne only
+    std::vector<std::string> alternatives; // Kind::Choice only
+};
+
+// Pattern syntax:
+//   ?            one character from the run charset
+//   *            zero or more characters from the run charset
+//   ?l ?u ?d ?s  one lowercase letter / uppercase letter / digit / symbol (hashcat classes)
+//   ?a           one character from ?l?u?d?s
+//   ?1 .. ?4     one character from a user-defined charset (--custom-charset1 .. 4)
+//   [a-f0-9_]    one character from the listed characters and ranges
+//   {2019|2020}  one of the literal alternatives; (Summer|Winter) is the same
+//   {!|}         an empty alternative makes the group optional
+//   \c           literal c
+// A '?' followed by anything else keeps its plain meaning, so "?x" is a wildcard and an 'x'.
+// '[', '{' and '(' without a matching closing bracket are literal characters.
+struct ParsedPattern {
+    std::vector<PatternToken> tokens;
+    std::vector<std::string> sets; // Distinct character sets; sets[0] is the run charset
+
+    int fixedLength() const; // Shortest password: every star empty, shortest alternative of each group
+    int maxFixedLength() const; // Longest password ignoring stars (longest alternative of each group)
+    int numStars() const;
+    bool hasChoices() const;
+};
+
+// Expands a charset specification: built-in classes (?l ?u ?d ?s ?a) are replaced by their
+// characters, "??" is a literal '?', and repeated characters are dropped (first one wins).
+std::string expand_charset_spec(const std::string& spec);
+
+// Parses `pattern` against the run charset and the custom charset slots (already expanded).
+// Returns false and sets `error` if the pattern references a custom charset that is not set.
+bool parse_pattern(const std::string& pattern, const std::string& charset,
+                   const std::array<std::string, kCustomCharsetSlots>& custom_charsets,
+                   ParsedPattern& out, std::string& error);
+
+// True if `password` is one of the strings `pattern` generates (any star length, any alternative)
+bool pattern_matches(const ParsedPattern& pattern, std::string_view password);
@@ -0,0 +1,339 @@
+#include "pcfg.h"
+#include "wordlist.h"
+#include <algorithm> // For std::sort, std::push_heap, std::pop_heap, std::make_heap
+#include <fstream>
+#include <limits>    // For std::numeric_limits
+#include <numeric>   // For std::iota
+#include <unordered_map>
+
+extern void update_output(const std::string &message); // Defined in main.cpp
+
+static char char_class(unsigned char c)
+{
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+        return 'L';
+    if (c >= '0' && c <= '9')
+        return 'D';
+    return 'S';
+}
+
+bool PcfgGrammar::train(const std::string &corpus_path, size_t max_terminals, std::string &error)
+{
+    Wordlist corpus;
+    if (!corpus.open(corpus_path, error))
+        return false;
+
+    std::unordered_map<std::string, uint64_t> structure_counts;
+    std::unordered_map<std::string, std::unordered_map<std::string, uint64_t>> terminal_counts;
+    WordlistReader reader(corpus, 0, corpus.size(), 1, 255);
+    std::string_view word;
+    uint64_t offset = 0;
+    std::vector<std::pair<std::string, std::string_view>> runs; // (nonterminal, terminal)
+    m_words = 0;
+    while (reader.next(word, offset))
+    {
+        bool printable = true;
+        for (char c : word)
+            printable = printable && static_cast<unsigned char>(c) >= 0x20 && static_cast<unsigned char>(c) <= 0x7E;
+        if (!printable)
+            continue;
+        runs.clear();
+        for (size_t i = 0; i < word.size();)
+        {
+            const char cls = char_class(static_cast<unsigned char>(word[i]));
+            size_t j = i + 1;
+            while (j < word.size() && char_class(static_cast<unsigned char>(word[j])) == cls)
+                ++j;
+            runs.emplace_back(cls + std::to_string(j - i), word.substr(i, j - i));
+            i = j;
+        }
+        if (runs.size() > kMaxSegments)
+            continue;
+        std::string structure;
+        for (const auto &run : runs)
+        {
+            structure += run.first;
+            ++terminal_counts[run.first][std::string(run.second)];
+        }
+        ++structure_counts[structure];
+        ++m_words;
+    }
+    if (m_words == 0)
+    {
+        error = "No usable training words (printable ASCII, at most " + std::to_string(kMaxSegments) + " runs) in: " + corpus_path;
+        return false;
+    }
+
+    m_nonterminals.clear();
+    m_structures.clear();
+    std::unordered_map<std::string, uint32_t> ids;
+    for (auto &entry : terminal_counts)
+    {
+        Nonterminal nonterminal;
+        nonterminal.name = entry.first;
+        std::vector<std::pair<std::string, uint64_t>> sorted(entry.second.begin(), entry.second.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+        if (max_terminals > 0 && sorted.size() > max_terminals)
+            sorted.resize(max_terminals);
+        for (auto &terminal : sorted)
+        {
+            nonterminal.terminals.push_back(std::move(terminal.first));
+            nonterminal.counts.push_back(terminal.second);
+        }
+        ids[nonterminal.name] = static_cast<uint32_t>(m_nonterminals.size());
+        m_nonterminals.push_back(std::move(nonterminal));
+    }
+    for (const auto &entry : structure_counts)
+    {
+        Structure structure;
+        structure.name = entry.first;
+        structure.count = entry.second;
+        // Re-split the name ("L6D2") into nonterminals
+        for (size_t i = 0; i < entry.first.size();)
+        {
+            size_t j = i + 1;
+            while (j < entry.first.size() && entry.first[j] >= '0' && entry.first[j] <= '9')
+                ++j;
+            structure.nonterminals.push_back(ids[entry.first.substr(i, j - i)]);
+            i = j;
+        }
+        m_structures.push_back(std::move(structure));
+    }
+    finish();
+    return true;
+}
+
+void PcfgGrammar::finish()
+{
+    std::sort(m_structures.begin(), m_structures.end(), [](const Structure &a, const Structure &b) {
+        return a.count != b.count ? a.count > b.count : a.name < b.name;
+    });
+    uint64_t structure_total = 0;
+    for (const auto &structure : m_structures)
+        structure_total += structure.count;
+    for (auto &structure : m_structures)
+        structure.probability = structure_total ? static_cast<double>(structure.count) / static_cast<double>(structure_total) : 0.0;
+
+    for (auto &nonterminal : m_nonterminals)
+    {
+        std::vector<size_t> order(nonterminal.terminals.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return nonterminal.counts[a] > nonterminal.counts[b]; });
+        Nonterminal sorted;
+        sorted.name = nonterminal.name;
+        uint64_t total = 0;
+        for (size_t i : order)
+        {
+            sorted.terminals.push_back(std::move(nonterminal.terminals[i]));
+            sorted.counts.push_back(nonterminal.counts[i]);
+            total += nonterminal.counts[i];
+        }
+        for (uint64_t count : sorted.counts)
+            sorted.probabilities.push_back(total ? static_cast<double>(count) / static_cast<double>(total) : 0.0);
+        nonterminal = std::move(sorted);
+    }
+}
+
+bool PcfgGrammar::save(const std::string &path, std::string &error) const
+{
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+    {
+        error = "Cannot write PCFG grammar: " + path;
+        return false;
+    }
+    ofs << "# APC PCFG grammar v1 (" << m_words << " training words)\n";
+    for (const auto &structure : m_structures)
+        ofs << "S\t" << structure.count << '\t' << structure.name << '\n';
+    for (const auto &nonterminal : m_nonterminals)
+        for (size_t i = 0; i < nonterminal.terminals.size(); ++i)
+            ofs << "T\t" << nonterminal.name << '\t' << nonterminal.counts[i] << '\t' << nonterminal.terminals[i] << '\n';
+    if (!ofs)
+    {
+        error = "Cannot write PCFG grammar: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool PcfgGrammar::load(const std::string &path, std::string &error)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+    {
+        error = "Cannot open PCFG grammar: " + path;
+        return false;
+    }
+    m_structures.clear();
+    m_nonterminals.clear();
+    std::unordered_map<std::string, uint32_t> ids;
+    auto id_of = [&](const std::string &name) {
+        auto it = ids.find(name);
+        if (it != ids.end())
+            return it->second;
+        Nonterminal nonterminal;
+        nonterminal.name = name;
+        m_nonterminals.push_back(std::move(nonterminal));
+        return ids[name] = static_cast<uint32_t>(m_nonterminals.size() - 1);
+    };
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(ifs, line))
+    {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+        // Fields: kind, then two (S) or three (T) tab-separated values; the last one is the rest of the line
+        const size_t t1 = line.find('\t');
+        const size_t t2 = (t1 == std::string::npos) ? t1 : line.find('\t', t1 + 1);
+        const size_t t3 = (t2 == std::string::npos || line[0] != 'T') ? std::string::npos : line.find('\t', t2 + 1);
+        try
+        {
+            if (line[0] == 'S' && t2 != std::string::npos)
+            {
+                Structure structure;
+                structure.count = std::stoull(line.substr(t1 + 1, t2 - t1 - 1));
+                structure.name = line.substr(t2 + 1);
+                for (size_t i = 0; i < structure.name.size();)
+                {
+                    size_t j = i + 1;
+                    while (j < structure.name.size() && structure.name[j] >= '0' && structure.name[j] <= '9')
+                        ++j;
+                    if (j == i + 1)
+                        throw std::invalid_argument("run without length");
+                    structure.nonterminals.push_back(id_of(structure.name.substr(i, j - i)));
+                    i = j;
+                }
+                if (structure.nonterminals.empty() || structure.nonterminals.size() > kMaxSegments)
+                    throw std::invalid_argument("bad structure");
+                m_structures.push_back(std::move(structure));
+                continue;
+            }
+            if (line[0] == 'T' && t3 != std::string::npos)
+            {
+                Nonterminal &nonterminal = m_nonterminals[id_of(line.substr(t1 + 1, t2 - t1 - 1))];
+                nonterminal.counts.push_back(std::stoull(line.substr(t2 + 1, t3 - t2 - 1)));
+                nonterminal.terminals.push_back(line.substr(t3 + 1));
+                continue;
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+        error = "Invalid PCFG grammar line " + std::to_string(line_number) + " in: " + path;
+        return false;
+    }
+    // A structure whose runs have no terminals can never produce a guess
+    m_structures.erase(std::remove_if(m_structures.begin(), m_structures.end(), [&](const Structure &structure) {
+                           for (uint32_t id : structure.nonterminals)
+                               if (m_nonterminals[id].terminals.empty())
+                                   return true;
+                           return false;
+                       }),
+                       m_structures.end());
+    if (m_structures.empty())
+    {
+        error = "PCFG grammar has no usable structures: " + path;
+        return false;
+    }
+    finish();
+    return true;
+}
+
+uint64_t PcfgGrammar::guesses() const
+{
+    const uint64_t max = std::numeric_limits<uint64_t>::max();
+    uint64_t total = 0;
+    for (const auto &structure : m_structures)
+    {
+        uint64_t product = 1;
+        for (uint32_t id : structure.nonterminals)
+        {
+            const uint64_t size = m_nonterminals[id].terminals.size();
+            product = (product > max / size) ? max : product * size;
+        }
+        total = (total > max - product) ? max : total + product;
+    }
+    return total;
+}
+
+bool train_pcfg_grammar(const std::string &corpus_path, const std::string &grammar_path, size_t max_terminals, std::string &error)
+{
+    PcfgGrammar grammar;
+    if (!grammar.train(corpus_path, max_terminals, error) || !grammar.save(grammar_path, error))
+        return false;
+    update_output("INFO: PCFG grammar trained on " + std::to_string(grammar.trainedWords()) + " words: " +
+                  std::to_string(grammar.structures().size()) + " structures, " + std::to_string(grammar.nonterminals().size()) +
+                  " nonterminals, " + std::to_string(grammar.guesses()) + " possible guesses. Saved to " + grammar_path);
+    return true;
+}
+
+// ================================================================
+// ===                      PCFG GENERATOR                      ===
+// ================================================================
+
+PcfgGenerator::PcfgGenerator(const PcfgGrammar &grammar, size_t max_queue)
+    : m_grammar(grammar), m_max_queue(std::max<size_t>(max_queue, 2))
+{
+    // One root per structure: every run at its most likely terminal
+    const auto &structures = grammar.structures();
+    for (size_t s = 0; s < structures.size(); ++s)
+    {
+        Item item{};
+        item.structure = static_cast<uint32_t>(s);
+        item.probability = structures[s].probability;
+        for (uint32_t id : structures[s].nonterminals)
+            item.probability *= grammar.nonterminals()[id].probabilities[0];
+        push(item);
+    }
+}
+
+void PcfgGenerator::push(const Item &item)
+{
+    m_heap.push_back(item);
+    std::push_heap(m_heap.begin(), m_heap.end(), Less());
+    if (m_heap.size() <= m_max_queue)
+        return;
+    // Memory limit: keep the more likely half
+    std::sort(m_heap.begin(), m_heap.end(), [](const Item &a, const Item &b) { return a.probability > b.probability; });
+    const size_t keep = m_max_queue / 2;
+    m_pruned += m_heap.size() - keep;
+    m_heap.resize(keep);
+    std::make_heap(m_heap.begin(), m_heap.end(), Less());
+}
+
+bool PcfgGenerator::next(std::string &guess)
+{
+    if (m_heap.empty())
+        return false;
+    std::pop_heap(m_heap.begin(), m_heap.end(), Less());
+    const Item item = m_heap.back();
+    m_heap.pop_back();
+
+    const auto &structure = m_grammar.structures()[item.structure];
+    const auto &nonterminals = m_grammar.nonterminals();
+    guess.clear();
+    for (size_t i = 0; i < structure.nonterminals.size(); ++i)
+        guess += nonterminals[structure.nonterminals[i]].terminals[item.indices[i]];
+
+    // Children: advance one run at or after the pivot, so each combination has exactly one parent
+    for (size_t i = item.pivot; i < structure.nonterminals.size(); ++i)
+    {
+        const auto &nonterminal = nonterminals[structure.nonterminals[i]];
+        if (item.indices[i] + 1 >= nonterminal.terminals.size())
+            continue;
+        Item child = item;
+        child.pivot = static_cast<uint32_t>(i);
+        ++child.indices[i];
+        child.probability = structure.probability;
+        for (size_t k = 0; k < structure.nonterminals.size(); ++k)
+            child.probability *= nonterminals[structure.nonterminals[k]].probabilities[child.indices[k]];
+        push(child);
+    }
+    return true;
+}
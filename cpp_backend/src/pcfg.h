@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint> // For uint64_t, uint32_t
+#include <cstddef> // For size_t
+
+// Probabilistic context-free grammar (Weir et al.) learned from a training list with `pcfg train`.
+// Every password is split into runs of letters (L), digits (D) and other printable characters (S);
+// the base structure lists the runs with their lengths ("L6D2S1"), and each run is a nonterminal
+// ("L6") whose terminals are the strings seen in that position. A guess is a structure with one
+// terminal per nonterminal; its probability is P(structure) * product of P(terminal).
+// Grammar file (text, one record per line, tab separated, '#' starts a comment line):
+//   S <count> <structure>
+//   T <nonterminal> <count> <terminal>     (the terminal is the rest of the line)
+class PcfgGrammar {
+public:
+    static constexpr size_t kMaxSegments = 8; // Structures with more runs are left out
+
+    struct Structure {
+        std::vector<uint32_t> nonterminals; // Index into nonterminals()
+        double probability = 0;
+        uint64_t count = 0;
+        std::string name;
+    };
+    struct Nonterminal {
+        std::string name;                  // "L6", "D2", ...
+        std::vector<std::string> terminals; // Descending probability
+        std::vector<double> probabilities;
+        std::vector<uint64_t> counts;
+    };
+
+    // Learns structures and terminals from a text wordlist (printable ASCII lines of at most 255
+    // characters). Only the `max_terminals` most frequent terminals of each nonterminal are kept
+    // (0 = all). Returns false and sets `error` on failure.
+    bool train(const std::string& corpus_path, size_t max_terminals, std::string& error);
+
+    bool load(const std::string& path, std::string& error);
+    bool save(const std::string& path, std::string& error) const;
+
+    const std::vector<Structure>& structures() const { return m_structures; }
+    const std::vector<Nonterminal>& nonterminals() const { return m_nonterminals; }
+
+    // Number of distinct guesses (saturates at UINT64_MAX)
+    uint64_t guesses() const;
+
+    uint64_t trainedWords() const { return m_words; }
+
+private:
+    // Sorts terminals and structures by descending count and derives the probabilities
+    void finish();
+
+    std::vector<Structure> m_structures;
+    std::vector<Nonterminal> m_nonterminals;
+    uint64_t m_words = 0;
+};
+
+// Emits the guesses of a grammar in descending probability with a priority queue ("next"
+// function with pivots, so every guess is produced exactly once). Popping a pre-terminal yields
+// one guess and pushes its children: the terminal index of each run at or after the pivot is
+// increased by one. Memory is bounded: once the queue holds more than `max_queue` entries, the
+// less likely half is discarded (counted in pruned()); those branches are never guessed.
+class PcfgGenerator {
+public:
+    PcfgGenerator(const PcfgGrammar& grammar, size_t max_queue);
+
+    // Next guess; returns false once the queue is empty
+    bool next(std::string& guess);
+
+    // Queue entries discarded at the memory limit so far
+    uint64_t pruned() const { return m_pruned; }
+
+private:
+    struct Item {
+        double probability;
+        uint32_t structure;
+        uint32_t pivot;
+        uint32_t indices[PcfgGrammar::kMaxSegments];
+    };
+    struct Less {
+        bool operator()(const Item& a, const Item& b) const { return a.probability < b.probability; }
+    };
+
+    void push(const Item& item);
+
+    const PcfgGrammar& m_grammar;
+    std::vector<Item> m_heap;
+    size_t m_max_queue;
+    uint64_t m_pruned = 0;
+};
+
+// `pcfg train`: trains a grammar from `corpus_path` and writes it to `grammar_path`
+bool train_pcfg_grammar(const std::string& corpus_path, const std::string& grammar_path, size_t max_terminals, std::string& error);
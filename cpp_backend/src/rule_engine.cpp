@@ -0,0 +1,408 @@
+#include "rule_engine.h"
+#include "candidate_batch.h"
+#include "bloom_filter.h" // For fnv1a_hash
+#include <algorithm> // For std::reverse, std::rotate, std::swap
+#include <cstring>   // For std::memcpy, std::memmove
+#include <fstream>
+
+extern void update_output(const std::string &message); // Defined in main.cpp
+
+// Operands of each function: 'N' = position (0-9, A-Z), 'X' = literal character; nullptr = unknown
+static const char *operand_kinds(char op)
+{
+    switch (op)
+    {
+    case ':': case 'l': case 'u': case 'c': case 'C': case 't': case 'r': case 'd': case 'f':
+    case '{': case '}': case '[': case ']': case 'q': case 'k': case 'K': case 'E':
+        return "";
+    case 'T': case 'p': case 'D': case '\'': case 'z': case 'Z': case 'L': case 'R':
+    case '+': case '-': case '.': case ',': case 'y': case 'Y': case '<': case '>': case '_':
+        return "N";
+    case '$': case '^': case '@': case 'e': case '!': case '/': case '(': case ')':
+        return "X";
+    case 'x': case 'O': case '*':
+        return "NN";
+    case 'i': case 'o': case '=': case '%':
+        return "NX";
+    case 's':
+        return "XX";
+    default:
+        return nullptr;
+    }
+}
+
+// Position operand value, or -1 if `c` is not 0-9 / A-Z
+static int position_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static char to_lower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c; }
+static char to_upper(char c) { return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 32) : c; }
+static char toggle(char c) { return (c >= 'a' && c <= 'z') ? to_upper(c) : to_lower(c); }
+
+bool RuleSet::add(const std::string &rule, std::string &error)
+{
+    std::vector<uint8_t> code;
+    for (size_t i = 0; i < rule.size();)
+    {
+        char op = rule[i++];
+        if (op == ' ' || op == '\t')
+            continue; // Whitespace between functions
+        const char *kinds = operand_kinds(op);
+        if (!kinds)
+        {
+            error = std::string("unknown function '") + op + "'";
+            return false;
+        }
+        uint8_t operands[2] = {0, 0};
+        for (size_t k = 0; kinds[k]; ++k)
+        {
+            if (i >= rule.size())
+            {
+                error = std::string("missing operand for '") + op + "'";
+                return false;
+            }
+            char c = rule[i++];
+            if (kinds[k] == 'N')
+            {
+                int value = position_value(c);
+                if (value < 0)
+                {
+                    error = std::string("invalid position '") + c + "' for '" + op + "'";
+                    return false;
+                }
+                operands[k] = static_cast<uint8_t>(value);
+            }
+            else
+            {
+                operands[k] = static_cast<uint8_t>(c);
+            }
+        }
+        code.push_back(static_cast<uint8_t>(op));
+        code.push_back(operands[0]);
+        code.push_back(operands[1]);
+    }
+    m_offsets.push_back(static_cast<uint32_t>(m_code.size()));
+    m_lengths.push_back(static_cast<uint32_t>(code.size()));
+    m_code.insert(m_code.end(), code.begin(), code.end());
+    m_texts.push_back(rule);
+    return true;
+}
+
+bool RuleSet::load(const std::string &path, std::string &error)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+    {
+        error = "Cannot open rule file: " + path;
+        return false;
+    }
+    std::string line;
+    size_t line_number = 0, invalid = 0;
+    while (std::getline(ifs, line))
+    {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::string rule_error;
+        if (!add(line, rule_error))
+        {
+            if (++invalid <= 10)
+                update_output("WARN: Skipping rule on line " + std::to_string(line_number) + " ('" + line + "'): " + rule_error);
+        }
+    }
+    if (invalid > 10)
+        update_output("WARN: " + std::to_string(invalid) + " invalid rules skipped in total.");
+    if (empty())
+    {
+        error = "No valid rules in: " + path;
+        return false;
+    }
+    return true;
+}
+
+int RuleSet::apply(size_t rule, char *buf, size_t length) const
+{
+    const uint8_t *ip = m_code.data() + m_offsets[rule];
+    const uint8_t *end = ip + m_lengths[rule];
+    size_t len = length;
+    for (; ip < end; ip += 3)
+    {
+        const char op = static_cast<char>(ip[0]);
+        const size_t n = ip[1];
+        const size_t m = ip[2];
+        const char x = static_cast<char>(ip[1]);
+        switch (op)
+        {
+        case ':':
+            break;
+        case 'l':
+            for (size_t i = 0; i < len; ++i) buf[i] = to_lower(buf[i]);
+            break;
+        case 'u':
+            for (size_t i = 0; i < len; ++i) buf[i] = to_upper(buf[i]);
+            break;
+        case 'c':
+            for (size_t i = 0; i < len; ++i) buf[i] = to_lower(buf[i]);
+            if (len > 0) buf[0] = to_upper(buf[0]);
+            break;
+        case 'C':
+            for (size_t i = 0; i < len; ++i) buf[i] = to_upper(buf[i]);
+            if (len > 0) buf[0] = to_lower(buf[0]);
+            break;
+        case 't':
+            for (size_t i = 0; i < len; ++i) buf[i] = toggle(buf[i]);
+            break;
+        case 'T':
+            if (n < len) buf[n] = toggle(buf[n]);
+            break;
+        case 'E':
+        case 'e':
+        {
+            const char separator = (op == 'E') ? ' ' : x;
+            for (size_t i = 0; i < len; ++i)
+                buf[i] = (i == 0 || buf[i - 1] == separator) ? to_upper(buf[i]) : to_lower(buf[i]);
+            break;
+        }
+        case 'r':
+            std::reverse(buf, buf + len);
+            break;
+        case 'd':
+            if (len * 2 <= kMaxLength) { std::memcpy(buf + len, buf, len); len *= 2; }
+            break;
+        case 'p':
+            if (len * (n + 1) <= kMaxLength)
+            {
+                for (size_t copy = 1; copy <= n; ++copy) std::memcpy(buf + copy * len, buf, len);
+                len *= n + 1;
+            }
+            break;
+        case 'f':
+            if (len * 2 <= kMaxLength)
+            {
+                for (size_t i = 0; i < len; ++i) buf[len + i] = buf[len - 1 - i];
+                len *= 2;
+            }
+            break;
+        case '{':
+            if (len > 1) std::rotate(buf, buf + 1, buf + len);
+            break;
+        case '}':
+            if (len > 1) std::rotate(buf, buf + len - 1, buf + len);
+            break;
+        case '$':
+            if (len < kMaxLength) buf[len++] = x;
+            break;
+        case '^':
+            if (len < kMaxLength) { std::memmove(buf + 1, buf, len); buf[0] = x; ++len; }
+            break;
+        case '[':
+            if (len > 0) { std::memmove(buf, buf + 1, len - 1); --len; }
+            break;
+        case ']':
+            if (len > 0) --len;
+            break;
+        case 'D':
+            if (n < len) { std::memmove(buf + n, buf + n + 1, len - n - 1); --len; }
+            break;
+        case 'x':
+            if (n < len && n + m <= len) { std::memmove(buf, buf + n, m); len = m; }
+            break;
+        case 'O':
+            if (n < len && n + m <= len) { std::memmove(buf + n, buf + n + m, len - n - m); len -= m; }
+            break;
+        case 'i':
+            if (n <= len && len < kMaxLength) { std::memmove(buf + n + 1, buf + n, len - n); buf[n] = static_cast<char>(m); ++len; }
+            break;
+        case 'o':
+            if (n < len) buf[n] = static_cast<char>(m);
+            break;
+        case '\'':
+            if (n < len) len = n;
+            break;
+        case 's':
+            for (size_t i = 0; i < len; ++i)
+                if (buf[i] == x) buf[i] = static_cast<char>(m);
+            break;
+        case '@':
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < len; ++i)
+                if (buf[i] != x) buf[kept++] = buf[i];
+            len = kept;
+            break;
+        }
+        case 'z':
+            if (len > 0 && len + n <= kMaxLength) { std::memmove(buf + n, buf, len); std::memset(buf, buf[n], n); len += n; }
+            break;
+        case 'Z':
+            if (len > 0 && len + n <= kMaxLength) { std::memset(buf + len, buf[len - 1], n); len += n; }
+            break;
+        case 'y':
+            if (n <= len && len + n <= kMaxLength) { std::memmove(buf + n, buf, len); std::memcpy(buf, buf + n, n); len += n; }
+            break;
+        case 'Y':
+            if (n <= len && len + n <= kMaxLength) { std::memcpy(buf + len, buf + len - n, n); len += n; }
+            break;
+        case 'q':
+            if (len * 2 <= kMaxLength)
+            {
+                for (size_t i = len; i-- > 0;) buf[2 * i] = buf[2 * i + 1] = buf[i];
+                len *= 2;
+            }
+            break;
+        case 'k':
+            if (len >= 2) std::swap(buf[0], buf[1]);
+            break;
+        case 'K':
+            if (len >= 2) std::swap(buf[len - 2], buf[len - 1]);
+            break;
+        case '*':
+            if (n < len && m < len) std::swap(buf[n], buf[m]);
+            break;
+        case 'L':
+            if (n < len) buf[n] = static_cast<char>(static_cast<unsigned char>(buf[n]) << 1);
+            break;
+        case 'R':
+            if (n < len) buf[n] = static_cast<char>(static_cast<unsigned char>(buf[n]) >> 1);
+            break;
+        case '+':
+            if (n < len) ++buf[n];
+            break;
+        case '-':
+            if (n < len) --buf[n];
+            break;
+        case '.':
+            if (n + 1 < len) buf[n] = buf[n + 1];
+            break;
+        case ',':
+            if (n >= 1 && n < len) buf[n] = buf[n - 1];
+            break;
+        // --- Rejections ---
+        case '<':
+            if (len > n) return -1;
+            break;
+        case '>':
+            if (len < n) return -1;
+            break;
+        case '_':
+            if (len != n) return -1;
+            break;
+        case '!':
+            if (std::memchr(buf, x, len)) return -1;
+            break;
+        case '/':
+            if (!std::memchr(buf, x, len)) return -1;
+            break;
+        case '(':
+            if (len == 0 || buf[0] != x) return -1;
+            break;
+        case ')':
+            if (len == 0 || buf[len - 1] != x) return -1;
+            break;
+        case '=':
+            if (n >= len || buf[n] != static_cast<char>(m)) return -1;
+            break;
+        case '%':
+        {
+            size_t found = 0;
+            for (size_t i = 0; i < len; ++i)
+                found += (buf[i] == static_cast<char>(m));
+            if (found < n) return -1;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return static_cast<int>(len);
+}
+
+RecentCandidates::RecentCandidates(size_t window) : m_window(window < 1 ? 1 : window)
+{
+    size_t capacity = 1;
+    while (capacity < m_window * 2)
+        capacity <<= 1;
+    m_slots.resize(capacity);
+    m_arena.reserve(m_window * 16);
+}
+
+bool RecentCandidates::insert(std::string_view candidate)
+{
+    if (m_count >= m_window)
+    {
+        ++m_generation; // Forget the whole window
+        m_count = 0;
+        m_arena.clear();
+    }
+    const uint64_t hash = fnv1a_hash(candidate.data(), static_cast<int>(candidate.size()));
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask)
+    {
+        Slot &slot = m_slots[i];
+        if (slot.generation != m_generation)
+        {
+            slot.hash = hash;
+            slot.offset = static_cast<uint32_t>(m_arena.size());
+            slot.length = static_cast<uint32_t>(candidate.size());
+            slot.generation = m_generation;
+            m_arena.insert(m_arena.end(), candidate.begin(), candidate.end());
+            ++m_count;
+            return true;
+        }
+        if (slot.hash == hash && slot.length == candidate.size() &&
+            std::memcmp(m_arena.data() + slot.offset, candidate.data(), candidate.size()) == 0)
+            return false;
+    }
+}
+
+RuleExpander::RuleExpander(const RuleSet &rules, int min_length, int max_length)
+    : m_rules(rules), m_min_length(min_length < 0 ? 0 : static_cast<size_t>(min_length)),
+      m_max_length(max_length < 0 ? 0 : static_cast<size_t>(max_length)), m_next_rule(rules.size())
+{
+}
+
+void RuleExpander::setWord(std::string_view word, uint64_t word_index, size_t first_rule)
+{
+    m_word.assign(word.data(), std::min(word.size(), RuleSet::kMaxLength));
+    m_word_index = word_index;
+    m_next_rule = first_rule;
+}
+
+size_t RuleExpander::fill(CandidateBatch &batch)
+{
+    size_t appended = 0;
+    while (!done() && !batch.full())
+    {
+        const size_t rule = m_next_rule++;
+        // The rule runs directly in the batch slot; rejected results give the slot back
+        char *slot = batch.emplace(RuleSet::kMaxLength, m_word_index * m_rules.size() + rule);
+        if (!slot)
+            break;
+        std::memcpy(slot, m_word.data(), m_word.size());
+        int length = m_rules.apply(rule, slot, m_word.size());
+        if (length < 0 || static_cast<size_t>(length) < m_min_length || static_cast<size_t>(length) > m_max_length)
+        {
+            batch.popBack();
+            ++m_dropped;
+            continue;
+        }
+        ++m_results;
+        if (!m_recent.insert(std::string_view(slot, static_cast<size_t>(length))))
+        {
+            batch.popBack();
+            ++m_duplicates;
+            continue;
+        }
+        batch.resizeLast(static_cast<size_t>(length));
+        ++appended;
+    }
+    return appended;
+}
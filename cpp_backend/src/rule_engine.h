@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint> // For uint64_t, uint32_t, uint8_t
+#include <cstddef> // For size_t
+
+class CandidateBatch;
+
+// Word mangling rules in hashcat / John the Ripper syntax, one rule per line ('#' starts a
+// comment line, spaces between functions are ignored). Positions N/M are 0-9 then A-Z (10-35).
+//   :  l u c C t TN E eX      no-op, lower, upper, capitalize, invert capitalize, toggle all/at N, title case
+//   r d pN f { }              reverse, duplicate, append N copies, reflect, rotate left/right
+//   $X ^X [ ] DN 'N           append, prepend, delete first/last/at N, truncate to N
+//   xNM ONM iNX oNX           extract M from N, omit M from N, insert X at N, overwrite at N with X
+//   sXY @X                    replace every X with Y (leet substitutions), purge every X
+//   zN ZN yN YN q             duplicate first/last char N times, first/last N chars, every char
+//   k K *NM +N -N .N ,N LN RN swaps, increment/decrement, copy next/prior char, bit shifts at N
+//   <N >N _N !X /X (X )X =NX %NX   reject unless length <= N, >= N, == N, no X, has X, starts/ends
+//                                  with X, X at N, at least N times X
+// Each rule is compiled once into fixed three-byte instructions (opcode, operand, operand).
+// As in hashcat, a function whose position is out of range leaves the word unchanged.
+class RuleSet {
+public:
+    static constexpr size_t kMaxLength = 256; // Working buffer size; longer results leave the word unchanged
+
+    // Parses and compiles a rule file. Invalid rules are skipped with a warning through update_output.
+    // Returns false and sets `error` if the file cannot be read or holds no valid rule.
+    bool load(const std::string& path, std::string& error);
+
+    // Compiles one rule line. Returns false (and sets `error`) if the syntax is invalid.
+    bool add(const std::string& rule, std::string& error);
+
+    size_t size() const { return m_offsets.size(); }
+    bool empty() const { return m_offsets.empty(); }
+    const std::string& text(size_t rule) const { return m_texts[rule]; }
+
+    // Runs rule `rule` in place on buf[0, length), where buf holds at least kMaxLength bytes.
+    // Returns the new length, or -1 if a rejection function discarded the word.
+    int apply(size_t rule, char* buf, size_t length) const;
+
+private:
+    std::vector<uint8_t> m_code;      // Instructions of all rules, three bytes each
+    std::vector<uint32_t> m_offsets;  // First instruction byte of each rule
+    std::vector<uint32_t> m_lengths;  // Instruction bytes of each rule
+    std::vector<std::string> m_texts; // Source text, for messages
+};
+
+// Exact set of the most recent candidates (short-window dedup). Open addressing with linear
+// probing over a power-of-two table at most half full; candidate bytes are kept in an arena so
+// hits are confirmed with memcmp, never by hash alone. Once `window` candidates are held, the
+// whole window is forgotten in O(1) by bumping a generation counter.
+class RecentCandidates {
+public:
+    explicit RecentCandidates(size_t window = 4096);
+
+    // Returns false if `candidate` is already in the window, otherwise remembers it
+    bool insert(std::string_view candidate);
+
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        uint32_t offset = 0;     // Into m_arena
+        uint32_t length = 0;
+        uint32_t generation = 0; // Slot is empty unless equal to m_generation
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<char> m_arena;
+    size_t m_window;
+    size_t m_count = 0;
+    uint32_t m_generation = 1;
+};
+
+// Expands one word at a time by every rule straight into candidate batch slots.
+// The rank of a candidate is word_index * rules + rule, so a run can resume inside a word.
+// Results outside [min_length, max_length] or rejected by the rule are dropped; results equal to
+// one of the last few thousand produced by this expander (e.g. `l` on a lowercase word) are skipped.
+class RuleExpander {
+public:
+    RuleExpander(const RuleSet& rules, int min_length, int max_length);
+
+    // Starts on `word` (at most RuleSet::kMaxLength bytes), beginning with rule `first_rule`
+    void setWord(std::string_view word, uint64_t word_index, size_t first_rule = 0);
+
+    // Appends results for the current word until the batch is full or every rule has run.
+    // The batch slot width must be at least RuleSet::kMaxLength. Returns the number appended.
+    size_t fill(CandidateBatch& batch);
+
+    // True once every rule has run on the current word (also before the first setWord)
+    bool done() const { return m_next_rule >= m_rules.size(); }
+
+    // Rank of the first (word, rule) pair not expanded yet
+    uint64_t position() const { return m_word_index * m_rules.size() + m_next_rule; }
+
+    // Results dropped so far because of their length or a rejection function
+    uint64_t dropped() const { return m_dropped; }
+
+    // Results that passed the length check, and how many of them were skipped as duplicates
+    uint64_t results() const { return m_results; }
+    uint64_t duplicates() const { return m_duplicates; }
+
+private:
+    const RuleSet& m_rules;
+    size_t m_min_length;
+    size_t m_max_length;
+    std::string m_word;
+    uint64_t m_word_index = 0;
+    size_t m_next_rule;
+    uint64_t m_dropped = 0;
+    uint64_t m_results = 0;
+    uint64_t m_duplicates = 0;
+    RecentCandidates m_recent;
+};
@@ -0,0 +1,159 @@
+#include "run_state.h"
+#include "bloom_filter.h" // For fnv1a_hash
+#include <cstdio>         // For std::remove, std::rename
+#include <fstream>
+#include <sstream>
+#include <iomanip>        // For std::setw, std::setfill
+
+static const char *RUN_STATE_HEADER = "# ArchivePasswordCracker run state";
+static const int RUN_STATE_VERSION = 1;
+
+bool RunState::save(const std::string &filepath) const
+{
+    std::string tmp_path = filepath + ".tmp";
+    {
+        std::ofstream ofs(tmp_path, std::ios::trunc);
+        if (!ofs)
+            return false;
+        ofs << RUN_STATE_HEADER << "\n";
+        ofs << "version=" << RUN_STATE_VERSION << "\n";
+        ofs << "job=" << job_key << "\n";
+        ofs << "seed=" << seed << "\n";
+        ofs << "domain=" << to_string(domain) << "\n";
+        ofs << "order=" << order << "\n";
+        if (!shard.empty())
+            ofs << "shard=" << shard << "\n";
+        ofs << "range=" << to_string(range_begin) << " " << to_string(range_end) << "\n";
+        ofs << "slices=" << slices.size() << "\n";
+        for (const auto &slice : slices)
+            ofs << "slice=" << to_string(slice.begin) << " " << to_string(slice.end) << " " << to_string(slice.next) << "\n";
+        if (!ofs.good())
+            return false;
+    }
+    // Replace the previous state only once the new one is fully written
+    std::remove(filepath.c_str());
+    return std::rename(tmp_path.c_str(), filepath.c_str()) == 0;
+}
+
+// Reads one decimal 128-bit field; sets the stream's failbit on bad input
+static std::istream &read_uint128(std::istream &in, uint128 &out)
+{
+    std::string text;
+    if (in >> text && !parse_uint128(text, out))
+        in.setstate(std::ios::failbit);
+    return in;
+}
+
+bool RunState::load(const std::string &filepath)
+{
+    std::ifstream ifs(filepath);
+    if (!ifs)
+        return false;
+
+    RunState loaded;
+    int version = 0;
+    size_t expected_slices = 0;
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos)
+            return false;
+        std::string key = line.substr(0, eq);
+        std::istringstream value(line.substr(eq + 1));
+        if (key == "version")
+            value >> version;
+        else if (key == "job")
+            value >> loaded.job_key;
+        else if (key == "seed")
+            value >> loaded.seed;
+        else if (key == "domain")
+            read_uint128(value, loaded.domain);
+        else if (key == "order")
+            loaded.order = line.substr(eq + 1);
+        else if (key == "shard")
+            value >> loaded.shard;
+        else if (key == "range")
+        {
+            read_uint128(value, loaded.range_begin);
+            read_uint128(value, loaded.range_end);
+        }
+        else if (key == "slices")
+            value >> expected_slices;
+        else if (key == "slice")
+        {
+            SliceProgress slice;
+            read_uint128(value, slice.begin);
+            read_uint128(value, slice.end);
+            read_uint128(value, slice.next);
+            if (!value || slice.begin > slice.end || slice.next < slice.begin || slice.next > slice.end)
+                return false;
+            loaded.slices.push_back(slice);
+        }
+        if (value.fail())
+            return false;
+    }
+    if (version != RUN_STATE_VERSION || loaded.slices.size() != expected_slices)
+        return false;
+    *this = loaded;
+    return true;
+}
+
+bool RunState::complete() const
+{
+    for (const auto &slice : slices)
+    {
+        if (slice.next < slice.end)
+            return false;
+    }
+    return true;
+}
+
+std::vector<SliceProgress> RunState::remaining() const
+{
+    std::vector<SliceProgress> result;
+    for (const auto &slice : slices)
+    {
+        if (slice.next >= slice.end)
+            continue;
+        if (!result.empty() && result.back().end == slice.next)
+            result.back().end = slice.end;
+        else
+            result.push_back(SliceProgress{slice.next, slice.end, slice.next});
+    }
+    return result;
+}
+
+std::vector<SliceProgress> RunState::split(uint128 domain, unsigned parts)
+{
+    return split(0, domain, parts);
+}
+
+std::vector<SliceProgress> RunState::split(uint128 begin, uint128 end, unsigned parts)
+{
+    std::vector<SliceProgress> result;
+    if (begin >= end || parts == 0)
+        return result;
+    const uint128 size = end - begin;
+    uint128 per_slice = size / parts + (size % parts != 0 ? 1 : 0);
+    for (uint128 first = begin; first < end; first = result.back().end)
+    {
+        SliceProgress slice;
+        slice.begin = first;
+        slice.end = (end - first > per_slice) ? first + per_slice : end;
+        slice.next = first;
+        result.push_back(slice);
+    }
+    return result;
+}
+
+std::string RunState::make_job_key(const std::string &description)
+{
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << fnv1a_hash(description.data(), static_cast<int>(description.size()));
+    return oss.str();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint> // For uint64_t
+#include "uint128.h"
+
+// Progress of one contiguous counter slice worked by a single thread
+struct SliceProgress {
+    uint128 begin = 0;
+    uint128 end = 0;
+    uint128 next = 0; // First counter in [begin, end) not yet tested
+};
+
+// Lock-free position of one slice, stored by its worker and read when the run state is saved.
+// Holds the offset from the slice start in a 64-bit atomic: slices may span more than 2^64
+// counters, but no single run gets through 2^64 candidates.
+class SliceCounter {
+public:
+    void reset(uint128 begin, uint128 next) {
+        m_begin = begin;
+        m_offset.store(static_cast<uint64_t>(next - begin), std::memory_order_relaxed);
+    }
+    void store(uint128 next, std::memory_order order = std::memory_order_seq_cst) {
+        m_offset.store(static_cast<uint64_t>(next - m_begin), order);
+    }
+    uint128 load(std::memory_order order = std::memory_order_seq_cst) const { return m_begin + m_offset.load(order); }
+
+private:
+    uint128 m_begin = 0;
+    std::atomic<uint64_t> m_offset{0};
+};
+
+// Resumable run state, checkpointed next to the skip list (<skip-file>.state).
+// Stores the job fingerprint, the random-order seed and every slice's position, so a stopped
+// run can continue exactly where each thread left off instead of re-probing the skip filter
+// for the already covered prefix.
+class RunState {
+public:
+    std::string job_key;      // Fingerprint of charset/lengths/pattern/mode/archive (see make_job_key)
+    uint64_t seed = 0;        // Permutation key for random mode
+    uint128 domain = 0;       // Size of the counter space the slices partition
+    std::string order;        // Phase the positions belong to ("random order", "wordlist", ...)
+    std::string shard;        // "i/N" for a --shard run, empty otherwise
+    uint128 range_begin = 0;  // Positions [range_begin, range_end) this run covers
+    uint128 range_end = 0;
+    std::vector<SliceProgress> slices;
+
+    // Text format, written to a temporary file first and then moved into place
+    bool save(const std::string& filepath) const;
+    bool load(const std::string& filepath);
+
+    // True if every slice has been worked to its end
+    bool complete() const;
+
+    // Untested [next, end) parts of the slices, adjacent parts merged
+    std::vector<SliceProgress> remaining() const;
+
+    // Splits [0, domain) into `parts` contiguous slices (fewer if domain is small)
+    static std::vector<SliceProgress> split(uint128 domain, unsigned parts);
+
+    // Same for [begin, end)
+    static std::vector<SliceProgress> split(uint128 begin, uint128 end, unsigned parts);
+
+    // Hex fingerprint of an arbitrary job description string
+    static std::string make_job_key(const std::string& description);
+};
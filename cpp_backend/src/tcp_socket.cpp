@@ -0,0 +1,255 @@
+#include "tcp_socket.h"
+#include <cstring> // For std::memset, std::strerror
+#include <cerrno>
+#include <string>
+
+#ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600 // inet_pton needs Vista or later
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mutex>
+typedef int socklen_t;
+#define CLOSE_SOCKET closesocket
+#define SEND_FLAGS 0
+#define SHUTDOWN_BOTH SD_BOTH
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#define CLOSE_SOCKET ::close
+#define SEND_FLAGS MSG_NOSIGNAL // A dead peer must not raise SIGPIPE
+#define SHUTDOWN_BOTH SHUT_RDWR
+#endif
+
+// Winsock needs one WSAStartup per process before the first socket call
+static bool init_sockets(std::string &error)
+{
+#ifdef _WIN32
+    static std::once_flag once;
+    static int result = 0;
+    std::call_once(once, []() {
+        WSADATA data;
+        result = WSAStartup(MAKEWORD(2, 2), &data);
+    });
+    if (result != 0)
+    {
+        error = "WSAStartup failed (" + std::to_string(result) + ").";
+        return false;
+    }
+#else
+    (void)error;
+#endif
+    return true;
+}
+
+static std::string last_socket_error()
+{
+#ifdef _WIN32
+    return "socket error " + std::to_string(WSAGetLastError());
+#else
+    return std::strerror(errno);
+#endif
+}
+
+// --- TcpStream ---
+
+TcpStream::~TcpStream()
+{
+    close();
+}
+
+TcpStream::TcpStream(TcpStream &&other) noexcept
+    : m_handle(other.m_handle), m_buffer(std::move(other.m_buffer))
+{
+    other.m_handle = kInvalidHandle;
+}
+
+TcpStream &TcpStream::operator=(TcpStream &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        m_handle = other.m_handle;
+        m_buffer = std::move(other.m_buffer);
+        other.m_handle = kInvalidHandle;
+    }
+    return *this;
+}
+
+bool TcpStream::connect(const std::string &host, uint16_t port, std::string &error)
+{
+    close();
+    if (!init_sockets(error))
+        return false;
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *results = nullptr;
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &results);
+    if (status != 0 || !results)
+    {
+        error = "Cannot resolve " + host + ": " + std::string(gai_strerror(status));
+        return false;
+    }
+    for (addrinfo *address = results; address; address = address->ai_next)
+    {
+        Handle handle = static_cast<Handle>(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+        if (handle == kInvalidHandle)
+            continue;
+        if (::connect(handle, address->ai_addr, static_cast<socklen_t>(address->ai_addrlen)) == 0)
+        {
+            // Requests are single short lines waiting for a reply: do not batch them
+            int one = 1;
+            setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
+            m_handle = handle;
+            break;
+        }
+        error = "Cannot connect to " + host + ":" + std::to_string(port) + ": " + last_socket_error();
+        CLOSE_SOCKET(handle);
+    }
+    freeaddrinfo(results);
+    if (m_handle == kInvalidHandle && error.empty())
+        error = "Cannot connect to " + host + ":" + std::to_string(port) + ".";
+    return m_handle != kInvalidHandle;
+}
+
+bool TcpStream::valid() const
+{
+    return m_handle != kInvalidHandle;
+}
+
+void TcpStream::close()
+{
+    if (m_handle != kInvalidHandle)
+    {
+        CLOSE_SOCKET(m_handle);
+        m_handle = kInvalidHandle;
+    }
+    m_buffer.clear();
+}
+
+void TcpStream::shutdown()
+{
+    if (m_handle != kInvalidHandle)
+        ::shutdown(m_handle, SHUTDOWN_BOTH);
+}
+
+bool TcpStream::sendLine(const std::string &line)
+{
+    if (m_handle == kInvalidHandle)
+        return false;
+    const std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        int n = ::send(m_handle, data.data() + sent, static_cast<int>(data.size() - sent), SEND_FLAGS);
+        if (n <= 0)
+            return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool TcpStream::readLine(std::string &line)
+{
+    if (m_handle == kInvalidHandle)
+        return false;
+    size_t newline;
+    while ((newline = m_buffer.find('\n')) == std::string::npos)
+    {
+        if (m_buffer.size() > kMaxLine)
+            return false;
+        char chunk[4096];
+        int n = ::recv(m_handle, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        m_buffer.append(chunk, static_cast<size_t>(n));
+    }
+    line.assign(m_buffer, 0, newline);
+    m_buffer.erase(0, newline + 1);
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+    return true;
+}
+
+// --- TcpListener ---
+
+TcpListener::~TcpListener()
+{
+    close();
+}
+
+bool TcpListener::listen(const std::string &address, uint16_t port, std::string &error)
+{
+    close();
+    if (!init_sockets(error))
+        return false;
+
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &local.sin_addr) != 1)
+    {
+        error = "Invalid IPv4 listen address: " + address;
+        return false;
+    }
+    TcpStream::Handle handle = static_cast<TcpStream::Handle>(socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (handle == TcpStream::kInvalidHandle)
+    {
+        error = "Cannot create socket: " + last_socket_error();
+        return false;
+    }
+    // A restarted coordinator can reuse its port while old connections are in TIME_WAIT
+    int one = 1;
+    setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&one), sizeof(one));
+    if (bind(handle, reinterpret_cast<const sockaddr *>(&local), sizeof(local)) != 0 || ::listen(handle, 16) != 0)
+    {
+        error = "Cannot listen on " + address + ":" + std::to_string(port) + ": " + last_socket_error();
+        CLOSE_SOCKET(handle);
+        return false;
+    }
+    socklen_t length = sizeof(local);
+    if (getsockname(handle, reinterpret_cast<sockaddr *>(&local), &length) == 0)
+        m_port = ntohs(local.sin_port);
+    m_handle = handle;
+    return true;
+}
+
+void TcpListener::close()
+{
+    if (m_handle != TcpStream::kInvalidHandle)
+    {
+        CLOSE_SOCKET(m_handle);
+        m_handle = TcpStream::kInvalidHandle;
+    }
+}
+
+TcpStream TcpListener::accept(int timeout_ms)
+{
+    if (m_handle == TcpStream::kInvalidHandle)
+        return TcpStream();
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(m_handle, &readable);
+    timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    if (select(static_cast<int>(m_handle) + 1, &readable, nullptr, nullptr, &timeout) <= 0)
+        return TcpStream();
+    TcpStream::Handle client = static_cast<TcpStream::Handle>(::accept(m_handle, nullptr, nullptr));
+    if (client == TcpStream::kInvalidHandle)
+        return TcpStream();
+    int one = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
+    return TcpStream(client);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <cstdint> // For uint16_t, uintptr_t
+
+// Blocking TCP streams for the coordinator protocol (Winsock on Windows, BSD sockets elsewhere).
+// The protocol is line based: sendLine() appends '\n', readLine() strips it (and a '\r').
+class TcpStream {
+public:
+#ifdef _WIN32
+    typedef uintptr_t Handle; // SOCKET
+    static constexpr Handle kInvalidHandle = ~static_cast<Handle>(0); // INVALID_SOCKET
+#else
+    typedef int Handle;
+    static constexpr Handle kInvalidHandle = -1;
+#endif
+
+    TcpStream() = default;
+    explicit TcpStream(Handle handle) : m_handle(handle) {}
+    ~TcpStream();
+    TcpStream(TcpStream&& other) noexcept;
+    TcpStream& operator=(TcpStream&& other) noexcept;
+    TcpStream(const TcpStream&) = delete;
+    TcpStream& operator=(const TcpStream&) = delete;
+
+    // Resolves `host` (name or address) and connects. Returns false and sets `error` on failure.
+    bool connect(const std::string& host, uint16_t port, std::string& error);
+    bool valid() const;
+    void close();
+
+    // Ends both directions, so a readLine() blocked in another thread returns false
+    void shutdown();
+
+    bool sendLine(const std::string& line);
+
+    // Next line without its terminator; false once the peer closed or on error.
+    // Lines longer than kMaxLine are treated as a protocol error.
+    bool readLine(std::string& line);
+
+    static constexpr size_t kMaxLine = 64 * 1024;
+
+private:
+    Handle m_handle = kInvalidHandle;
+    std::string m_buffer; // Bytes received after the last returned line
+};
+
+// Listening socket; accept() polls, so the owner can do periodic work between connections
+class TcpListener {
+public:
+    TcpListener() = default;
+    ~TcpListener();
+    TcpListener(const TcpListener&) = delete;
+    TcpListener& operator=(const TcpListener&) = delete;
+
+    // Binds `address` (e.g. 127.0.0.1, 0.0.0.0 for all interfaces) and listens.
+    // Port 0 picks a free port, see port().
+    bool listen(const std::string& address, uint16_t port, std::string& error);
+    void close();
+
+    // Waits up to `timeout_ms` for a connection; an invalid stream on timeout or error
+    TcpStream accept(int timeout_ms);
+
+    uint16_t port() const { return m_port; }
+
+private:
+    TcpStream::Handle m_handle = TcpStream::kInvalidHandle;
+    uint16_t m_port = 0;
+};
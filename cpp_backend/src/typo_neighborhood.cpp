@@ -0,0 +1,181 @@
+#include "typo_neighborhood.h"
+#include "candidate_batch.h"
+#include "bloom_filter.h" // For fnv1a_hash
+#include <algorithm>      // For std::stable_sort, std::min
+#include <cstdlib>        // For std::abs
+
+// US QWERTY rows, unshifted and shifted; row r + 1 is offset half a key to the right of row r
+static const char *const kRows[2][4] = {
+    {"`1234567890-=", "qwertyuiop[]\\", "asdfghjkl;'", "zxcvbnm,./"},
+    {"~!@#$%^&*()_+", "QWERTYUIOP{}|", "ASDFGHJKL:\"", "ZXCVBNM<>?"},
+};
+
+static bool key_position(char c, int &row, int &column, int &shift)
+{
+    for (shift = 0; shift < 2; ++shift)
+        for (row = 0; row < 4; ++row)
+            for (column = 0; kRows[shift][row][column]; ++column)
+                if (kRows[shift][row][column] == c)
+                    return true;
+    return false;
+}
+
+bool TypoNeighborhood::adjacentKeys(char a, char b)
+{
+    int ra, ca, sa, rb, cb, sb;
+    if (a == b || !key_position(a, ra, ca, sa) || !key_position(b, rb, cb, sb))
+        return false;
+    if (ra == rb && ca == cb)
+        return true; // Same key, Shift slipped
+    if (ra == rb)
+        return std::abs(ca - cb) == 1;
+    if (rb == ra + 1) // b one row down: the key below-left or below-right of a
+        return cb == ca || cb == ca - 1;
+    if (rb == ra - 1)
+        return cb == ca || cb == ca + 1;
+    return false;
+}
+
+bool TypoNeighborhood::add(std::string_view s, int distance, int weight)
+{
+    if (m_table.size() < 2 * (m_entries.size() + 1))
+    {
+        // Grow and rehash at half load
+        std::vector<uint32_t> table(std::max<size_t>(1024, m_table.size() * 2), 0);
+        const size_t mask = table.size() - 1;
+        for (size_t i = 0; i < m_entries.size(); ++i)
+        {
+            std::string_view existing = text(m_entries[i]);
+            size_t slot = static_cast<size_t>(fnv1a_hash(existing.data(), static_cast<int>(existing.size()))) & mask;
+            while (table[slot])
+                slot = (slot + 1) & mask;
+            table[slot] = static_cast<uint32_t>(i + 1);
+        }
+        m_table.swap(table);
+    }
+    const size_t mask = m_table.size() - 1;
+    size_t slot = static_cast<size_t>(fnv1a_hash(s.data(), static_cast<int>(s.size()))) & mask;
+    for (; m_table[slot]; slot = (slot + 1) & mask)
+    {
+        Entry &entry = m_entries[m_table[slot] - 1];
+        if (text(entry) == s)
+        {
+            // Rediscovered at the same distance through a likelier path
+            if (entry.distance == distance && weight < entry.weight)
+                entry.weight = static_cast<uint8_t>(weight);
+            return true;
+        }
+    }
+    if (m_entries.size() >= kMaxCandidates)
+        return false;
+    m_table[slot] = static_cast<uint32_t>(m_entries.size() + 1);
+    m_entries.push_back(Entry{m_arena.size(), static_cast<uint32_t>(s.size()), static_cast<uint8_t>(distance), static_cast<uint8_t>(weight)});
+    m_arena.append(s.data(), s.size());
+    return true;
+}
+
+bool TypoNeighborhood::build(const std::vector<std::string> &bases, const std::string &alphabet, int distance, bool keyboard_weighting,
+                             int min_length, int max_length, std::string &error)
+{
+    *this = TypoNeighborhood();
+    distance = std::max(0, std::min(distance, kMaxDistance));
+    for (const auto &base : bases)
+        add(base, 0, 0);
+
+    std::string edited;
+    size_t level_begin = 0;
+    for (int d = 1; d <= distance; ++d)
+    {
+        const size_t level_end = m_entries.size();
+        for (size_t e = level_begin; e < level_end; ++e)
+        {
+            const std::string s(text(m_entries[e]));
+            const int parent_weight = m_entries[e].weight;
+            const size_t n = s.size();
+            auto emit = [&](bool likely) {
+                if (!add(edited, d, std::min(255, parent_weight + (likely ? 0 : 1))))
+                {
+                    error = "Typo neighbourhood exceeds " + std::to_string(kMaxCandidates) +
+                            " candidates; lower --typo-distance or use a smaller charset.";
+                    return false;
+                }
+                return true;
+            };
+            // Deletions and transpositions are always plausible slips
+            for (size_t i = 0; i < n; ++i)
+            {
+                edited = s;
+                edited.erase(i, 1);
+                if (!emit(true)) return false;
+            }
+            for (size_t i = 0; i + 1 < n; ++i)
+            {
+                if (s[i] == s[i + 1]) continue;
+                edited = s;
+                std::swap(edited[i], edited[i + 1]);
+                if (!emit(true)) return false;
+            }
+            // Substitutions and insertions are likely when the key is next to an intended one
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (char c : alphabet)
+                {
+                    if (c == s[i]) continue;
+                    edited = s;
+                    edited[i] = c;
+                    if (!emit(adjacentKeys(s[i], c))) return false;
+                }
+            }
+            for (size_t i = 0; i <= n; ++i)
+            {
+                for (char c : alphabet)
+                {
+                    const bool likely = (i > 0 && (c == s[i - 1] || adjacentKeys(s[i - 1], c))) ||
+                                        (i < n && (c == s[i] || adjacentKeys(s[i], c)));
+                    edited = s;
+                    edited.insert(edited.begin() + static_cast<std::ptrdiff_t>(i), c);
+                    if (!emit(likely)) return false;
+                }
+            }
+        }
+        level_begin = level_end;
+    }
+    m_table = std::vector<uint32_t>(); // Only needed while building
+
+    // Entries are already grouped by distance; weighting reorders inside each group
+    m_distance_counts.assign(static_cast<size_t>(distance) + 1, 0);
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        const Entry &entry = m_entries[i];
+        if (entry.length < static_cast<uint32_t>(std::max(0, min_length)) || entry.length > static_cast<uint32_t>(std::max(0, max_length)))
+            continue;
+        m_order.push_back(static_cast<uint32_t>(i));
+        ++m_distance_counts[entry.distance];
+    }
+    if (keyboard_weighting)
+    {
+        std::stable_sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) {
+            const Entry &x = m_entries[a], &y = m_entries[b];
+            return x.distance != y.distance ? x.distance < y.distance : x.weight < y.weight;
+        });
+    }
+    return true;
+}
+
+std::string_view TypoNeighborhood::candidate(uint64_t rank) const
+{
+    return text(m_entries[m_order[static_cast<size_t>(rank)]]);
+}
+
+uint64_t TypoNeighborhood::countAt(int distance) const
+{
+    return (distance >= 0 && static_cast<size_t>(distance) < m_distance_counts.size()) ? m_distance_counts[distance] : 0;
+}
+
+size_t TypoNeighborhood::fill(CandidateBatch &batch, uint64_t rank, uint64_t end) const
+{
+    size_t appended = 0;
+    for (; rank < end && !batch.full(); ++rank, ++appended)
+        batch.push(candidate(rank), rank);
+    return appended;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint> // For uint64_t, uint32_t, uint8_t
+#include <cstddef> // For size_t
+
+class CandidateBatch;
+
+// Every string within Damerau-Levenshtein distance k of one or more base guesses ("I almost
+// remember it"). The neighbourhood is built breadth-first over single edits (delete, transpose
+// adjacent characters, substitute or insert a character of the alphabet), so each string is
+// stored once, at its exact distance, in one arena behind an open-addressing index.
+// Ranks run distance 0 (the bases), then 1, then 2, ...; with keyboard weighting, candidates of
+// one distance are further ordered by how many of their edits were unlikely typos (a key that
+// is not next to the intended one on a QWERTY keyboard), fat-finger variants first.
+class TypoNeighborhood {
+public:
+    static constexpr size_t kMaxCandidates = 20000000; // Strings walked (in range or not) before build() gives up
+    static constexpr int kMaxDistance = 4;
+
+    // Builds the neighbourhood; candidates outside [min_length, max_length] are walked through
+    // but not ranked. Returns false and sets `error` if it grows beyond kMaxCandidates.
+    bool build(const std::vector<std::string>& bases, const std::string& alphabet, int distance, bool keyboard_weighting,
+               int min_length, int max_length, std::string& error);
+
+    // Ranked candidates (length range applied)
+    uint64_t size() const { return m_order.size(); }
+    std::string_view candidate(uint64_t rank) const;
+
+    // Ranked candidates at exactly `distance`
+    uint64_t countAt(int distance) const;
+
+    // Appends candidates from `rank` until the batch is full or `end` is reached. Returns the number appended.
+    size_t fill(CandidateBatch& batch, uint64_t rank, uint64_t end) const;
+
+    // True if `a` and `b` are neighbouring keys on a US QWERTY keyboard (or the same key with and without Shift)
+    static bool adjacentKeys(char a, char b);
+
+private:
+    struct Entry {
+        uint64_t offset;  // Into m_arena
+        uint32_t length;
+        uint8_t distance;
+        uint8_t weight;   // Unlikely edits on the cheapest path found
+    };
+
+    // Adds `s` at `distance` unless it is already known; returns false once kMaxCandidates is exceeded
+    bool add(std::string_view s, int distance, int weight);
+    std::string_view text(const Entry& entry) const { return std::string_view(m_arena.data() + entry.offset, entry.length); }
+
+    std::string m_arena;
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_table;  // Entry index + 1, 0 = empty
+    std::vector<uint32_t> m_order;  // Ranked entry indices
+    std::vector<uint64_t> m_distance_counts; // Ranked candidates per distance
+};
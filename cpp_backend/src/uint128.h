@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <cstdint> // For uint64_t
+
+// Unsigned 128-bit integer for keyspace counts, ranks and slice bounds (GCC / Clang / MinGW).
+// Long brute-force lengths pass 2^64 quickly (95 printable characters: length 10), so counts are
+// kept in 128 bits; hot loops test fits_u64() and run on plain 64-bit arithmetic when they can.
+__extension__ typedef unsigned __int128 uint128;
+
+constexpr uint128 kUint128Max = ~static_cast<uint128>(0);
+
+inline bool fits_u64(uint128 value) { return (value >> 64) == 0; }
+
+// a * b, false on overflow (`out` untouched)
+inline bool checked_mul(uint128 a, uint128 b, uint128& out) {
+    if (a != 0 && b > kUint128Max / a)
+        return false;
+    out = a * b;
+    return true;
+}
+
+// a + b, false on overflow (`out` untouched)
+inline bool checked_add(uint128 a, uint128 b, uint128& out) {
+    if (b > kUint128Max - a)
+        return false;
+    out = a + b;
+    return true;
+}
+
+// Decimal text (std::to_string has no 128-bit overload)
+inline std::string to_string(uint128 value) {
+    if (fits_u64(value))
+        return std::to_string(static_cast<uint64_t>(value));
+    char digits[40];
+    char* first = digits + sizeof(digits);
+    while (value != 0) {
+        *--first = static_cast<char>('0' + static_cast<int>(value % 10));
+        value /= 10;
+    }
+    return std::string(first, digits + sizeof(digits));
+}
+
+// Parses a decimal number (no sign, no spaces). Returns false on bad input or overflow.
+inline bool parse_uint128(const std::string& text, uint128& out) {
+    if (text.empty())
+        return false;
+    uint128 value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9' || !checked_mul(value, 10, value) || !checked_add(value, static_cast<uint128>(c - '0'), value))
+            return false;
+    }
+    out = value;
+    return true;
+}
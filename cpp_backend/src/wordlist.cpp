@@ -0,0 +1,278 @@
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#endif
+
+#include "wordlist.h"
+#include "candidate_batch.h"
+#include <algorithm> // For std::min
+#include <bitset>    // For std::bitset::count (portable popcount)
+#include <cstring>   // For std::memcpy
+#include "worker_pool.h" // Line counting runs on the process-wide threads
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>    // For open
+#include <sys/mman.h> // For mmap, madvise, munmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For close
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define WORDLIST_SSE2 1
+#endif
+
+const char *find_newline(const char *begin, const char *end)
+{
+#ifdef WORDLIST_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - begin >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        if (mask != 0)
+        {
+            while (!(mask & 1u))
+            {
+                mask >>= 1;
+                ++begin;
+            }
+            return begin;
+        }
+        begin += 16;
+    }
+#endif
+    while (begin < end && *begin != '\n')
+        ++begin;
+    return begin;
+}
+
+uint64_t count_newlines(const char *begin, const char *end)
+{
+    uint64_t count = 0;
+#ifdef WORDLIST_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - begin >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        count += std::bitset<16>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)))).count();
+        begin += 16;
+    }
+#endif
+    for (; begin < end; ++begin)
+        count += (*begin == '\n');
+    return count;
+}
+
+Wordlist::~Wordlist()
+{
+    close();
+}
+
+bool Wordlist::open(const std::string &path, std::string &error)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        error = "Cannot open wordlist: " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        error = "Cannot determine wordlist size: " + path;
+        return false;
+    }
+    m_file = file;
+    m_size = static_cast<uint64_t>(size.QuadPart);
+    if (m_size == 0)
+        return true; // Empty files cannot be mapped; there is simply nothing to read
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        close();
+        error = "Cannot map wordlist into memory: " + path;
+        return false;
+    }
+    m_mapping = mapping;
+    m_data = static_cast<const char *>(view);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "Cannot open wordlist: " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        error = "Cannot determine wordlist size: " + path;
+        return false;
+    }
+    m_size = static_cast<uint64_t>(st.st_size);
+    if (m_size > 0)
+    {
+        void *view = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            ::close(fd);
+            m_size = 0;
+            error = "Cannot map wordlist into memory: " + path;
+            return false;
+        }
+        madvise(view, static_cast<size_t>(m_size), MADV_SEQUENTIAL);
+        m_data = static_cast<const char *>(view);
+    }
+    ::close(fd); // The mapping stays valid without the descriptor
+#endif
+    return true;
+}
+
+void Wordlist::close()
+{
+#ifdef _WIN32
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+    if (m_file)
+        CloseHandle(static_cast<HANDLE>(m_file));
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_data)
+        munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+uint64_t Wordlist::lineStartFrom(uint64_t offset) const
+{
+    if (offset == 0 || offset >= m_size)
+        return std::min(offset, m_size);
+    // `offset` is a line start iff the byte before it ends a line
+    const char *newline = find_newline(m_data + offset - 1, m_data + m_size);
+    return std::min(static_cast<uint64_t>(newline - m_data) + 1, m_size);
+}
+
+std::vector<SliceProgress> Wordlist::split(unsigned parts) const
+{
+    return split(0, m_size, parts);
+}
+
+std::vector<SliceProgress> Wordlist::split(uint64_t begin, uint64_t end, unsigned parts) const
+{
+    std::vector<SliceProgress> slices;
+    const uint64_t first = lineStartFrom(begin);
+    const uint64_t last = lineStartFrom(end);
+    if (first >= last)
+        return slices;
+    for (const SliceProgress &even : RunState::split(first, last, parts))
+    {
+        uint64_t slice_begin = slices.empty() ? first : static_cast<uint64_t>(slices.back().end);
+        uint64_t slice_end = lineStartFrom(static_cast<uint64_t>(even.end));
+        if (slice_end <= slice_begin)
+            continue; // A single long line swallowed this slice
+        SliceProgress slice;
+        slice.begin = slice.next = slice_begin;
+        slice.end = slice_end;
+        slices.push_back(slice);
+    }
+    return slices;
+}
+
+bool Wordlist::find(std::string_view word, uint64_t &offset) const
+{
+    if (word.empty())
+        return false;
+    WordlistReader reader(*this, 0, m_size, static_cast<int>(word.size()), static_cast<int>(word.size()));
+    std::string_view line;
+    while (reader.next(line, offset))
+    {
+        if (line == word)
+            return true;
+    }
+    return false;
+}
+
+uint64_t Wordlist::countLines() const
+{
+    if (m_size == 0)
+        return 0;
+    std::vector<SliceProgress> slices = RunState::split(m_size, WorkerPool::shared().size());
+    std::vector<uint64_t> counts(slices.size(), 0);
+    {
+        TaskGroup tasks;
+        for (size_t i = 0; i < slices.size(); ++i)
+        {
+            tasks.run([this, &slices, &counts, i]() {
+                counts[i] = count_newlines(m_data + slices[i].begin, m_data + slices[i].end);
+            });
+        }
+        tasks.wait();
+    }
+    uint64_t lines = 0;
+    for (uint64_t count : counts)
+        lines += count;
+    if (m_data[m_size - 1] != '\n')
+        ++lines; // Last line without a terminating newline
+    return lines;
+}
+
+WordlistReader::WordlistReader(const Wordlist &wordlist, uint64_t begin, uint64_t end, int min_length, int max_length)
+    : m_data(wordlist.data()), m_position(begin), m_end(std::min(end, wordlist.size())),
+      m_min_length(min_length < 0 ? 0 : static_cast<size_t>(min_length)),
+      m_max_length(max_length < 0 ? 0 : static_cast<size_t>(max_length))
+{
+}
+
+bool WordlistReader::next(std::string_view &word, uint64_t &offset)
+{
+    while (m_position < m_end)
+    {
+        const char *line = m_data + m_position;
+        const char *newline = find_newline(line, m_data + m_end);
+        size_t length = static_cast<size_t>(newline - line);
+        uint64_t line_offset = m_position;
+        m_position += length + (newline < m_data + m_end ? 1 : 0);
+        if (length > 0 && line[length - 1] == '\r')
+            --length;
+        if (length == 0)
+            continue;
+        if (length < m_min_length || length > m_max_length)
+        {
+            ++m_skipped;
+            continue;
+        }
+        word = std::string_view(line, length);
+        offset = line_offset;
+        return true;
+    }
+    return false;
+}
+
+size_t WordlistReader::fill(CandidateBatch &batch)
+{
+    size_t appended = 0;
+    std::string_view word;
+    uint64_t offset = 0;
+    while (!batch.full() && next(word, offset))
+    {
+        char *slot = batch.emplace(word.size(), offset);
+        std::memcpy(slot, word.data(), word.size());
+        ++appended;
+    }
+    return appended;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint> // For uint64_t
+#include <cstddef> // For size_t
+#include "run_state.h" // For SliceProgress
+
+class CandidateBatch;
+
+// Read-only memory mapping of a text wordlist (one candidate per line, LF or CRLF).
+// Nothing is copied or parsed up front: threads scan their own byte range of the mapping,
+// so multi-GB lists cost no heap memory beyond the page cache.
+class Wordlist {
+public:
+    Wordlist() = default;
+    ~Wordlist();
+    Wordlist(const Wordlist&) = delete;
+    Wordlist& operator=(const Wordlist&) = delete;
+
+    // Maps the whole file. Returns false and sets `error` if it cannot be opened or mapped.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const char* data() const { return m_data; }
+    uint64_t size() const { return m_size; }
+
+    // First line start at or after `offset` (size() if there is none)
+    uint64_t lineStartFrom(uint64_t offset) const;
+
+    // Splits the file into at most `parts` contiguous byte slices whose boundaries are line starts
+    std::vector<SliceProgress> split(unsigned parts) const;
+
+    // Splits the lines starting in [begin, end) the same way
+    std::vector<SliceProgress> split(uint64_t begin, uint64_t end, unsigned parts) const;
+
+    // Number of lines (a last line without newline counts), counted in parallel on the worker pool
+    uint64_t countLines() const;
+
+    // Offset of the first line equal to `word` (CR stripped). Returns false if there is none.
+    bool find(std::string_view word, uint64_t& offset) const;
+
+private:
+    const char* m_data = nullptr;
+    uint64_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;    // HANDLE
+    void* m_mapping = nullptr; // HANDLE
+#endif
+};
+
+// Sequential reader over the lines of one byte slice [begin, end) of a Wordlist.
+// Words are copied from the mapping straight into batch slots; the rank of a candidate is the
+// byte offset of its line, so position() is an exact resume point.
+class WordlistReader {
+public:
+    // `begin` must be a line start; words outside [min_length, max_length] are skipped
+    WordlistReader(const Wordlist& wordlist, uint64_t begin, uint64_t end, int min_length, int max_length);
+
+    // Next word of the slice (a view into the mapping) and the byte offset of its line.
+    // Returns false at the end of the slice.
+    bool next(std::string_view& word, uint64_t& offset);
+
+    // Appends words until the batch is full or the slice ends. Returns the number appended.
+    size_t fill(CandidateBatch& batch);
+
+    // Offset of the first line not read yet
+    uint64_t position() const { return m_position; }
+    bool done() const { return m_position >= m_end; }
+
+    // Non-empty lines skipped because of their length
+    uint64_t skipped() const { return m_skipped; }
+
+private:
+    const char* m_data;
+    uint64_t m_position;
+    uint64_t m_end;
+    size_t m_min_length;
+    size_t m_max_length;
+    uint64_t m_skipped = 0;
+};
+
+// Pointer to the first '\n' in [begin, end), or `end` (16 bytes per step with SSE2)
+const char* find_newline(const char* begin, const char* end);
+
+// Number of '\n' bytes in [begin, end)
+uint64_t count_newlines(const char* begin, const char* end);
@@ -0,0 +1,58 @@
+#include "worker_pool.h"
+
+WorkerPool &WorkerPool::shared()
+{
+    static WorkerPool pool(std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 4);
+    return pool;
+}
+
+WorkerPool::WorkerPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = 1;
+    m_threads.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t)
+        m_threads.emplace_back(&WorkerPool::run, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_wake.notify_all();
+    for (auto &th : m_threads) { if (th.joinable()) th.join(); }
+}
+
+void WorkerPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void WorkerPool::run()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_closing || !m_tasks.empty(); });
+            if (m_tasks.empty())
+                return; // Closing and drained
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void TaskGroup::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+}
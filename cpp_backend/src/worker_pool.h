@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Worker threads that live for the whole process. Every phase and every length queues its work
+// here instead of creating and joining its own threads, so short lengths cost no thread start-up
+// and a thread that runs out of work in one step can take the next one right away.
+// Tasks must not wait for other tasks of the pool.
+class WorkerPool {
+public:
+    // The process-wide pool: one thread per hardware thread (4 if unknown), started on first use
+    static WorkerPool& shared();
+
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool(); // Finishes queued tasks, then joins the threads
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(m_threads.size()); }
+
+    // Runs `task` on the next free thread
+    void submit(std::function<void()> task);
+
+private:
+    void run();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_closing = false;
+};
+
+// Tasks of one phase on a pool, waited for together (the pool's counterpart of a joined thread vector)
+class TaskGroup {
+public:
+    explicit TaskGroup(WorkerPool& pool = WorkerPool::shared()) : m_pool(pool) {}
+    ~TaskGroup() { wait(); }
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // Like std::thread's constructor: arguments are copied or moved (use std::ref / std::cref for references)
+    template <typename Function, typename... Args>
+    void run(Function&& function, Args&&... args)
+    {
+        // Shared, so move-only arguments still fit in a std::function
+        auto call = std::make_shared<std::tuple<std::decay_t<Function>, std::decay_t<Args>...>>(
+            std::forward<Function>(function), std::forward<Args>(args)...);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_pending;
+            ++m_started;
+        }
+        m_pool.submit([this, call]() mutable {
+            std::apply([](auto&... items) { std::invoke(std::move(items)...); }, *call);
+            call.reset(); // Arguments die before wait() returns, not after
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0)
+                m_done.notify_all();
+        });
+    }
+
+    // Blocks until every task started so far has returned
+    void wait();
+
+    bool empty() const { return m_started == 0; } // No task was started
+    size_t size() const { return m_started; }
+
+private:
+    WorkerPool& m_pool;
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    size_t m_pending = 0;
+    size_t m_started = 0;
+};